@@ -1,6 +1,8 @@
 #include "sceneBuilderClass.hpp"
 #include "modelClass.hpp"
+#include "parallelUtil.hpp"
 
+#include <cstdlib>
 #include <iostream>
 #include <cmath>
 #include <algorithm>
@@ -10,6 +12,37 @@ using namespace std;
 //is the goal to add models live? like start with a render loop?
 
 int main(int argc, char** argv) {
+    // trailing flags, any order, after <model_path> <num_instances>:
+    //   --no-mesh-cache  always import, never read or write <model_path>.meshcache
+    //   --no-mesh-opt    keep the loader's index / vertex order (no cache, overdraw or fetch reordering)
+    //   --quantized      12-byte vertices (unorm16 positions, octahedral normals) instead of 24
+    //   --bench-load     compare Assimp vs the native STL reader vs the mesh cache, then exit
+    //   --headless       no visible window, render into an FBO (EGL without a display)
+    //   --animate        spin every instance, streaming transforms through a persistent-mapped ring
+    //   --inverse-normals  per-vertex inverse(model) instead of precomputed normal matrices (A/B timing)
+    //   --frames=N       render N frames on a scripted orbit, print CPU/GPU timings and exit
+    //                    (--headless alone implies --frames=300)
+    VertexFormat vertexFormat = VertexFormat::Float;
+    bool benchLoad = false;
+    bool headless = false;
+    bool animate = false;
+    int  benchFrames = 0;
+    while (argc >= 3 && string(argv[argc - 1]).rfind("--", 0) == 0) {
+        const string flag = argv[--argc];
+        if (flag == "--no-mesh-cache") ModelObject::setMeshCacheEnabled(false);
+        else if (flag == "--no-mesh-opt") ModelObject::setMeshOptimizeEnabled(false);
+        else if (flag == "--headless") headless = true;
+        else if (flag == "--animate") animate = true;
+        else if (flag == "--inverse-normals") ModelObject::setPrecomputedNormals(false);
+        else if (flag.rfind("--frames=", 0) == 0) benchFrames = atoi(flag.c_str() + 9);
+        else if (flag == "--quantized") vertexFormat = VertexFormat::Quantized;
+        else if (flag == "--bench-load") benchLoad = true;
+        else cerr << "Unknown flag: " << flag << "\n";
+    }
+    if (benchLoad) {
+        ModelObject::benchmarkLoad(argv[1]);
+        return 0;
+    }
     if (argc < 3) {
         cerr << "Usage: " << argv[0] << " <model_path> <num_instances>\n";
         return 1;
@@ -20,12 +53,13 @@ int main(int argc, char** argv) {
     const int numInstancesInput = stoi(argv[2]);
     const int numInstances = max(1, numInstancesInput);
 
-    sceneBuilderClass scene;//precurser to set global state (rn just sets window and view)
+    if (headless && benchFrames <= 0) benchFrames = 300;
+    sceneBuilderClass scene(headless);//precurser to set global state (rn just sets window and view)
 
     shared_ptr<ModelObject> model;
     //keeps them from being spawned on top of each other
     try {
-        model = make_shared<ModelObject>(modelPath);
+        model = make_shared<ModelObject>(modelPath, vertexFormat);
     } catch (const exception& e) {
         cerr << "Failed to create ModelObject: " << e.what() << "\n";
         return 3;
@@ -55,9 +89,21 @@ int main(int argc, char** argv) {
 
     // Apply instances and register the object with the scene.
     model->setInstanceTransforms(instances);
+    if (animate) {
+        // each instance spins about its own Y axis at one of a few speeds
+        model->setInstanceAnimator([](double t, const glm::mat4* base, glm::mat4* dst, size_t count) {
+            parallelFor(count, [&](size_t b, size_t e) {
+                for (size_t i = b; i < e; ++i) {
+                    const float speed = 0.5f + 0.25f * float(i % 7);
+                    dst[i] = glm::rotate(base[i], float(t) * speed, glm::vec3(0.0f, 1.0f, 0.0f));
+                }
+            });
+        });
+    }
     scene.addObject(model);
 
-    // Render loop.
-    scene.run();
+    // Render loop (or a fixed-length benchmark).
+    if (benchFrames > 0) scene.runBenchmark(benchFrames);
+    else scene.run();
     return 0;
 }
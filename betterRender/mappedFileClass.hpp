@@ -0,0 +1,41 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+using namespace std;
+
+// Read-only memory map of a whole file (POSIX); unmapped when destroyed.
+class mappedFileClass {
+public:
+    explicit mappedFileClass(const string& path) {
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw runtime_error("Cannot open: " + path);
+        struct stat st{};
+        if (fstat(fd, &st) != 0) { close(fd); throw runtime_error("Cannot stat: " + path); }
+        size_ = static_cast<size_t>(st.st_size);
+        if (size_ > 0) {
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) { close(fd); throw runtime_error("mmap failed: " + path); }
+            madvise(p, size_, MADV_SEQUENTIAL);
+            data_ = static_cast<const unsigned char*>(p);
+        }
+        close(fd); // the mapping keeps the file alive
+    }
+    ~mappedFileClass() {
+        if (data_) munmap(const_cast<unsigned char*>(data_), size_);
+    }
+    mappedFileClass(const mappedFileClass&) = delete;
+    mappedFileClass& operator=(const mappedFileClass&) = delete;
+
+    const unsigned char* data() const { return data_; }
+    size_t               size() const { return size_; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
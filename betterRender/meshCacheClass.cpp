@@ -0,0 +1,161 @@
+#include "meshCacheClass.hpp"
+#include "parallelUtil.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+namespace {
+struct CacheHeader {
+    char     magic[8];        // "MESHCACH"
+    uint32_t version;
+    uint32_t importKey;
+    uint64_t sourceHash;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    float    bboxMin[3];
+    float    bboxMax[3];
+    uint32_t sectionCount;
+    uint32_t pad;
+};
+
+struct CacheSection {
+    uint32_t id;
+    uint32_t pad;
+    uint64_t offset;          // from the start of the file, 64-byte aligned
+    uint64_t bytes;
+};
+
+const char kMagic[8] = {'M','E','S','H','C','A','C','H'};
+
+inline uint64_t alignUp(uint64_t v) { return (v + 63) & ~uint64_t(63); }
+
+inline uint64_t mix64(uint64_t h) {
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+    return h ^ (h >> 33);
+}
+} // namespace
+
+string meshCacheClass::cachePathFor(const string& meshPath) {
+    return meshPath + ".meshcache";
+}
+
+// 8 bytes at a time per 1 MiB block (blocks hashed in parallel), block hashes folded in order.
+// Block size is fixed so the result does not depend on the number of threads.
+uint64_t meshCacheClass::hashFile(const string& path) {
+    mappedFileClass file(path);
+    const unsigned char* d = file.data();
+    const size_t n = file.size();
+    const size_t kBlock = size_t(1) << 20;
+    const size_t blocks = (n + kBlock - 1) / kBlock;
+
+    vector<uint64_t> blockHash(blocks);
+    parallelFor(blocks, [&](size_t bb, size_t be) {
+        for (size_t b = bb; b < be; ++b) {
+            const size_t off = b * kBlock, len = min(kBlock, n - off);
+            uint64_t h = 0x9E3779B97F4A7C15ull ^ len;
+            size_t i = 0;
+            for (; i + 8 <= len; i += 8) {
+                uint64_t w; memcpy(&w, d + off + i, 8);
+                h = mix64(h ^ w) + 0x9E3779B97F4A7C15ull;
+            }
+            uint64_t tail = 0;
+            memcpy(&tail, d + off + i, len - i);
+            blockHash[b] = mix64(h ^ tail);
+        }
+    }, 1);
+
+    uint64_t h = mix64(uint64_t(n));
+    for (uint64_t bh : blockHash) h = mix64(h ^ bh);
+    return h;
+}
+
+unique_ptr<mappedFileClass> meshCacheClass::open(const string& cachePath, uint64_t sourceHash,
+                                                 uint32_t importKey, MeshView& out) {
+    unique_ptr<mappedFileClass> file;
+    try {
+        file = make_unique<mappedFileClass>(cachePath);
+    } catch (const exception&) {
+        return nullptr; // no cache yet
+    }
+
+    const unsigned char* d = file->data();
+    const size_t n = file->size();
+    if (n < sizeof(CacheHeader)) return nullptr;
+
+    CacheHeader hdr;
+    memcpy(&hdr, d, sizeof(hdr));
+    if (memcmp(hdr.magic, kMagic, 8) != 0 || hdr.version != kVersion ||
+        hdr.importKey != importKey || hdr.sourceHash != sourceHash) {
+        return nullptr;
+    }
+    if (sizeof(CacheHeader) + hdr.sectionCount * sizeof(CacheSection) > n) return nullptr;
+
+    MeshView view;
+    view.vertexCount = hdr.vertexCount;
+    view.indexCount  = hdr.indexCount;
+    view.bboxMin = glm::vec3(hdr.bboxMin[0], hdr.bboxMin[1], hdr.bboxMin[2]);
+    view.bboxMax = glm::vec3(hdr.bboxMax[0], hdr.bboxMax[1], hdr.bboxMax[2]);
+
+    for (uint32_t s = 0; s < hdr.sectionCount; ++s) {
+        CacheSection sec;
+        memcpy(&sec, d + sizeof(CacheHeader) + s * sizeof(CacheSection), sizeof(sec));
+        if (sec.offset + sec.bytes > n) return nullptr; // truncated
+        if (sec.id == kVertices && sec.bytes == hdr.vertexCount * 6 * sizeof(float)) {
+            view.vertices = reinterpret_cast<const float*>(d + sec.offset);
+        } else if (sec.id == kIndices && sec.bytes == hdr.indexCount * sizeof(unsigned)) {
+            view.indices = reinterpret_cast<const unsigned*>(d + sec.offset);
+        }
+    }
+    if (!view.vertices || !view.indices) return nullptr;
+
+    out = view;
+    return file;
+}
+
+bool meshCacheClass::write(const string& cachePath, uint64_t sourceHash, uint32_t importKey,
+                           const MeshView& mesh) {
+    CacheHeader hdr{};
+    memcpy(hdr.magic, kMagic, 8);
+    hdr.version     = kVersion;
+    hdr.importKey   = importKey;
+    hdr.sourceHash  = sourceHash;
+    hdr.vertexCount = mesh.vertexCount;
+    hdr.indexCount  = mesh.indexCount;
+    for (int k = 0; k < 3; ++k) { hdr.bboxMin[k] = mesh.bboxMin[k]; hdr.bboxMax[k] = mesh.bboxMax[k]; }
+
+    vector<CacheSection> sections = {
+        { kVertices, 0, 0, mesh.vertexCount * 6 * sizeof(float) },
+        { kIndices,  0, 0, mesh.indexCount * sizeof(unsigned) },
+    };
+    const void* payload[] = { mesh.vertices, mesh.indices };
+    hdr.sectionCount = static_cast<uint32_t>(sections.size());
+
+    uint64_t off = alignUp(sizeof(CacheHeader) + sections.size() * sizeof(CacheSection));
+    for (auto& s : sections) { s.offset = off; off = alignUp(off + s.bytes); }
+
+    const string tmp = cachePath + ".tmp";
+    {
+        ofstream f(tmp, ios::binary | ios::trunc);
+        if (!f) return false;
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        f.write(reinterpret_cast<const char*>(sections.data()), sections.size() * sizeof(CacheSection));
+        static const char zeros[64] = {};
+        uint64_t pos = sizeof(hdr) + sections.size() * sizeof(CacheSection);
+        for (size_t s = 0; s < sections.size(); ++s) {
+            f.write(zeros, sections[s].offset - pos);
+            f.write(static_cast<const char*>(payload[s]), sections[s].bytes);
+            pos = sections[s].offset + sections[s].bytes;
+        }
+        if (!f) { f.close(); remove(tmp.c_str()); return false; }
+    }
+    if (rename(tmp.c_str(), cachePath.c_str()) != 0) {
+        remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
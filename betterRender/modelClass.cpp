@@ -1,16 +1,41 @@
 #include "modelClass.hpp"
+#include "stlLoaderClass.hpp"
+#include "parallelUtil.hpp"
+#include "meshOptimizerClass.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 using namespace std;
 //contructor from just name of file
-ModelObject::ModelObject(const string& meshPath) {
+ModelObject::ModelObject(const string& meshPath, VertexFormat format) : format_(format) {
     loadMesh(meshPath);
+    if (format_ == VertexFormat::Quantized) quantizeVertices_();
     uploadMesh();
 
-    GLuint vs = compile(GL_VERTEX_SHADER, kDefaultVS);
+    // start from the common case so setInstanceTransforms() rarely has to recompile
+    normalMode_ = precomputeNormals_ ? NormalMode::UniformScale : NormalMode::Inverse;
+    buildProgram_();
+}
+
+void ModelObject::buildProgram_() {
+    // the VS decodes whichever layout was uploaded and picks the normal-matrix source
+    string defines;
+    if (format_ == VertexFormat::Quantized)        defines += "#define QUANTIZED_VERTICES 1\n";
+    if (normalMode_ == NormalMode::Precomputed)    defines += "#define NORMAL_MATRIX_ATTRIB 1\n";
+    if (normalMode_ == NormalMode::UniformScale)   defines += "#define NORMAL_UNIFORM_SCALE 1\n";
+    string vsSrc = kDefaultVS;
+    vsSrc.insert(vsSrc.find('\n') + 1, defines);
+
+    GLuint vs = compile(GL_VERTEX_SHADER, vsSrc.c_str());
     GLuint fs = compile(GL_FRAGMENT_SHADER, kDefaultFS);
+    if (program_) glDeleteProgram(program_);
     program_ = link(vs, fs);
 
     uView_ = glGetUniformLocation(program_, "view");
     uProj_ = glGetUniformLocation(program_, "projection");
+    uDequantOffset_ = glGetUniformLocation(program_, "uDequantOffset");
+    uDequantScale_  = glGetUniformLocation(program_, "uDequantScale");
 }
 
 static void checkCompile(GLuint sh, GLenum type) {
@@ -32,17 +57,48 @@ static void checkLink(GLuint prog) {
 
 //basic vertex
 const char* ModelObject::kDefaultVS = R"(#version 330 core
+#ifdef QUANTIZED_VERTICES
+layout (location = 0) in vec3 aPosQ;       // unorm16 within the mesh AABB
+layout (location = 1) in vec2 aNormalOct;  // octahedral, snorm16
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+#endif
 layout (location = 2) in mat4 iModel;
+#ifdef NORMAL_MATRIX_ATTRIB
+layout (location = 6) in mat3 iNormal;     // inverse-transpose of mat3(iModel), per instance
+#endif
 
 out vec3 vNormal;
 
 uniform mat4 view;
 uniform mat4 projection;
 
+#ifdef QUANTIZED_VERTICES
+uniform vec3 uDequantOffset;   // bboxMin
+uniform vec3 uDequantScale;    // bbox size
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
+
 void main() {
+#ifdef QUANTIZED_VERTICES
+    vec3 aPos    = uDequantOffset + aPosQ * uDequantScale;
+    vec3 aNormal = octDecode(aNormalOct);
+#endif
+#if defined(NORMAL_MATRIX_ATTRIB)
+    vNormal = iNormal * aNormal;
+#elif defined(NORMAL_UNIFORM_SCALE)
+    vNormal = mat3(iModel) * aNormal; // scale only changes length; the FS normalises
+#else
     vNormal = mat3(transpose(inverse(iModel))) * aNormal;
+#endif
     gl_Position = projection * view * iModel * vec4(aPos, 1.0);
 }
 )";
@@ -79,47 +135,193 @@ GLuint ModelObject::link(GLuint vs, GLuint fs) {
     return p;
 }
 
-//importer
-void ModelObject::loadMesh(const string& path) {
+bool ModelObject::meshCacheEnabled_ = true;
+bool ModelObject::precomputeNormals_ = true;
+bool ModelObject::meshOptimizeEnabled_ = true;
+
+// index order is left to optimizeMesh_(), which treats every loader's output the same
+static const unsigned kAssimpFlags =
+    aiProcess_Triangulate |
+    aiProcess_GenNormals |
+    aiProcess_JoinIdenticalVertices |
+    aiProcess_OptimizeMeshes;
+
+// cache key for the import pipeline: bump kNativeStlKey when the STL loader's output changes,
+// kMeshOptKey when the optimizer's does
+static const uint32_t kNativeStlKey = 0x53544C01u; // 'STL' v1
+static const uint32_t kMeshOptKey   = 0x4F500000u; // 'OP' v0
+static uint32_t importKey(const string& path, bool optimized) {
+    return (stlLoaderClass::isStlPath(path) ? kNativeStlKey : kAssimpFlags) ^ (optimized ? kMeshOptKey : 0u);
+}
+
+//assimp importer, used for everything that is not STL
+static void loadWithAssimp(const string& path, vector<float>& interleaved, vector<unsigned>& indices,
+                           glm::vec3& bboxMin, glm::vec3& bboxMax) {
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(
-        path,
-        aiProcess_Triangulate |
-        aiProcess_GenNormals |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_OptimizeMeshes
-    );
+    const aiScene* scene = importer.ReadFile(path, kAssimpFlags);
     if (!scene || !scene->mNumMeshes) {
         throw runtime_error("Assimp failed to load: " + path);
     }
     const aiMesh* m = scene->mMeshes[0];
-    interleaved_.reserve(m->mNumVertices * 6);
+    interleaved.reserve(m->mNumVertices * 6);
     for (unsigned i = 0; i < m->mNumVertices; ++i) {
         const aiVector3D& p = m->mVertices[i];
         const aiVector3D& n = m->mNormals[i];
 
         // === NEW: update bounds ===
-        bboxMin_.x = min(bboxMin_.x, p.x);
-        bboxMin_.y = min(bboxMin_.y, p.y);
-        bboxMin_.z = min(bboxMin_.z, p.z);
-        bboxMax_.x = max(bboxMax_.x, p.x);
-        bboxMax_.y = max(bboxMax_.y, p.y);
-        bboxMax_.z = max(bboxMax_.z, p.z);
+        bboxMin.x = min(bboxMin.x, p.x);
+        bboxMin.y = min(bboxMin.y, p.y);
+        bboxMin.z = min(bboxMin.z, p.z);
+        bboxMax.x = max(bboxMax.x, p.x);
+        bboxMax.y = max(bboxMax.y, p.y);
+        bboxMax.z = max(bboxMax.z, p.z);
 
-        interleaved_.insert(end(interleaved_), {p.x,p.y,p.z, n.x,n.y,n.z});
+        interleaved.insert(end(interleaved), {p.x,p.y,p.z, n.x,n.y,n.z});
     }
-    indices_.reserve(m->mNumFaces * 3);
+    indices.reserve(m->mNumFaces * 3);
     for (unsigned f = 0; f < m->mNumFaces; ++f) {
         const aiFace& face = m->mFaces[f];
         if (face.mNumIndices == 3) {
-            indices_.push_back(face.mIndices[0]);
-            indices_.push_back(face.mIndices[1]);
-            indices_.push_back(face.mIndices[2]);
+            indices.push_back(face.mIndices[0]);
+            indices.push_back(face.mIndices[1]);
+            indices.push_back(face.mIndices[2]);
         }
     }
 }
 
+//importer: mapped .meshcache if it is current, else native reader for STL, Assimp for the rest
+void ModelObject::loadMesh(const string& path) {
+    const string cachePath = meshCacheClass::cachePathFor(path);
+    uint64_t hash = 0;
+    if (meshCacheEnabled_) {
+        hash = meshCacheClass::hashFile(path);
+        cacheFile_ = meshCacheClass::open(cachePath, hash, importKey(path, meshOptimizeEnabled_), mesh_);
+        if (cacheFile_) {
+            bboxMin_ = mesh_.bboxMin;
+            bboxMax_ = mesh_.bboxMax;
+            return;
+        }
+    }
+
+    if (stlLoaderClass::isStlPath(path)) {
+        stlLoaderClass::load(path, interleaved_, indices_, bboxMin_, bboxMax_);
+    } else {
+        loadWithAssimp(path, interleaved_, indices_, bboxMin_, bboxMax_);
+    }
+    if (meshOptimizeEnabled_) optimizeMesh_();
+    mesh_.vertices    = interleaved_.data();
+    mesh_.vertexCount = interleaved_.size() / 6;
+    mesh_.indices     = indices_.data();
+    mesh_.indexCount  = indices_.size();
+    mesh_.bboxMin     = bboxMin_;
+    mesh_.bboxMax     = bboxMax_;
+
+    if (meshCacheEnabled_ && !meshCacheClass::write(cachePath, hash, importKey(path, meshOptimizeEnabled_), mesh_)) {
+        cerr << "[cache] could not write " << cachePath << "\n";
+    }
+}
+
+// vertex cache order, then overdraw order, then vertices in first-use order; the result is
+// what gets cached, so a cache hit is already optimized
+void ModelObject::optimizeMesh_() {
+    const auto t0 = chrono::steady_clock::now();
+    const size_t vertexCount = interleaved_.size() / 6;
+    const auto before = meshOptimizerClass::analyzeVertexCache(indices_.data(), indices_.size(), vertexCount);
+    meshOptimizerClass::optimizeVertexCache(indices_.data(), indices_.size(), vertexCount);
+    meshOptimizerClass::optimizeOverdraw(indices_.data(), indices_.size(), interleaved_.data(), vertexCount, 6);
+    const size_t used = meshOptimizerClass::optimizeVertexFetch(interleaved_.data(), vertexCount, 6,
+                                                                indices_.data(), indices_.size());
+    interleaved_.resize(used * 6);
+    const auto after = meshOptimizerClass::analyzeVertexCache(indices_.data(), indices_.size(), used);
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "[meshopt] " << indices_.size() / 3 << " tris: acmr " << before.acmr << " -> " << after.acmr
+         << ", atvr " << before.atvr << " -> " << after.atvr << " (fifo " << meshOptimizerClass::kCacheSize << ")";
+    if (used != vertexCount) cout << ", " << vertexCount - used << " unused verts dropped";
+    cout << ", " << ms << " ms\n";
+}
+
+static uint16_t toUnorm16(float v) {
+    return static_cast<uint16_t>(clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+static int16_t toSnorm16(float v) {
+    return static_cast<int16_t>(lround(clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+// builds the 12-byte stream from the float one; positions span the mesh's own AABB
+void ModelObject::quantizeVertices_() {
+    static_assert(sizeof(QuantizedVertex) == 12, "quantized vertex must stay 12 bytes");
+    const glm::vec3 ext = bboxSize();
+    const glm::vec3 inv(ext.x > 0.0f ? 1.0f / ext.x : 0.0f,
+                        ext.y > 0.0f ? 1.0f / ext.y : 0.0f,
+                        ext.z > 0.0f ? 1.0f / ext.z : 0.0f);
+    const float* src = mesh_.vertices;
+    quantized_.resize(mesh_.vertexCount);
+
+    parallelFor(quantized_.size(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const float* s = src + v * 6;
+            QuantizedVertex& q = quantized_[v];
+            q.px  = toUnorm16((s[0] - bboxMin_.x) * inv.x);
+            q.py  = toUnorm16((s[1] - bboxMin_.y) * inv.y);
+            q.pz  = toUnorm16((s[2] - bboxMin_.z) * inv.z);
+            q.pad = 0;
+
+            // octahedral: project onto |x|+|y|+|z| = 1, fold the lower hemisphere over
+            float l1 = fabs(s[3]) + fabs(s[4]) + fabs(s[5]);
+            float ox = l1 > 0.0f ? s[3] / l1 : 0.0f;
+            float oy = l1 > 0.0f ? s[4] / l1 : 0.0f;
+            if (s[5] < 0.0f) {
+                float fx = (1.0f - fabs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+                float fy = (1.0f - fabs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+                ox = fx; oy = fy;
+            }
+            q.nx = toSnorm16(ox);
+            q.ny = toSnorm16(oy);
+        }
+    });
+}
+
+//times the Assimp path against the native STL reader (no GL needed)
+void ModelObject::benchmarkLoad(const string& path) {
+    auto timeIt = [&](const char* name, auto&& fn) {
+        vector<float> v; vector<unsigned> idx;
+        glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+        auto t0 = chrono::steady_clock::now();
+        fn(v, idx, bmin, bmax);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        cout << "[load] " << name << ": " << ms << " ms, "
+             << v.size() / 6 << " verts, " << idx.size() / 3 << " tris\n";
+        return ms;
+    };
+
+    double assimpMs = timeIt("assimp", [&](auto& v, auto& i, auto& bmin, auto& bmax) {
+        loadWithAssimp(path, v, i, bmin, bmax);
+    });
+    if (stlLoaderClass::isStlPath(path)) {
+        double nativeMs = timeIt("native", [&](auto& v, auto& i, auto& bmin, auto& bmax) {
+            stlLoaderClass::load(path, v, i, bmin, bmax);
+        });
+        cout << "[load] " << path << ": native is " << assimpMs / max(nativeMs, 1e-6)
+             << "x the speed of assimp (" << workerCount() << " threads)\n";
+    }
+
+    // cache hit: hash the source, validate and map; touch every page so the
+    // number includes what the upload would otherwise pay for faulting them in
+    const string cachePath = meshCacheClass::cachePathFor(path);
+    auto t0 = chrono::steady_clock::now();
+    meshCacheClass::MeshView view;
+    auto file = meshCacheClass::open(cachePath, meshCacheClass::hashFile(path), importKey(path, meshOptimizeEnabled_), view);
+    if (!file) {
+        cout << "[load] cache: no current " << cachePath << " (run once without --bench-load to create it)\n";
+        return;
+    }
+    volatile unsigned sink = 0;
+    for (size_t off = 0; off < file->size(); off += 4096) sink += file->data()[off];
+    double cacheMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "[load] cache: " << cacheMs << " ms, " << view.vertexCount << " verts, "
+         << view.indexCount / 3 << " tris (" << assimpMs / max(cacheMs, 1e-6) << "x assimp)\n";
+}
+
 //send mesh to gpu
 void ModelObject::uploadMesh() {
     glGenVertexArrays(1, &vao_);
@@ -127,41 +329,108 @@ void ModelObject::uploadMesh() {
 
     glGenBuffers(1, &vbo_);
     glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, interleaved_.size() * sizeof(float), interleaved_.data(), GL_STATIC_DRAW);
+    if (format_ == VertexFormat::Quantized) {
+        glBufferData(GL_ARRAY_BUFFER, quantized_.size() * sizeof(QuantizedVertex), quantized_.data(), GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, mesh_.vertexCount * 6 * sizeof(float), mesh_.vertices, GL_STATIC_DRAW);
+    }
 
     glGenBuffers(1, &ebo_);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned), indices_.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh_.indexCount * sizeof(unsigned), mesh_.indices, GL_STATIC_DRAW);
 
     // pos (0), normal (1)
-    const GLsizei stride = sizeof(float) * 6;
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(float)*3));
+    if (format_ == VertexFormat::Quantized) {
+        const GLsizei stride = sizeof(QuantizedVertex);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                              reinterpret_cast<void*>(offsetof(QuantizedVertex, px)));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride,
+                              reinterpret_cast<void*>(offsetof(QuantizedVertex, nx)));
+    } else {
+        const GLsizei stride = sizeof(float) * 6;
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(float)*3));
+    }
 
     glBindVertexArray(0);
+
+    // the GL buffers own the mesh now; keep only the counts
+    cacheFile_.reset();
+    vector<float>().swap(interleaved_);
+    vector<unsigned>().swap(indices_);
+    vector<QuantizedVertex>().swap(quantized_);
+    mesh_.vertices = nullptr;
+    mesh_.indices  = nullptr;
 }
 
 void ModelObject::setupInstanceBuffer() {
+    const size_t n = instanceMats_.size();
+    // animated transforms are unknown ahead of time, so they always get the precomputed stream
+    if (!precomputeNormals_)                                     setNormalMode_(NormalMode::Inverse);
+    else if (!animator_ && allUniformScale(instanceMats_.data(), n)) setNormalMode_(NormalMode::UniformScale);
+    else                                                         setNormalMode_(NormalMode::Precomputed);
+
+    const size_t matBytes = n * sizeof(glm::mat4);
+    const size_t bytes = matBytes + (normalMode_ == NormalMode::Precomputed ? n * sizeof(NormalMatrix) : 0);
     if (!instanceVbo_) glGenBuffers(1, &instanceVbo_);
-    glBindVertexArray(vao_);
     glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
-    glBufferData(GL_ARRAY_BUFFER, instanceMats_.size() * sizeof(glm::mat4), instanceMats_.data(), GL_DYNAMIC_DRAW);
+    if (bytes != instanceBytes_) {
+        glBufferData(GL_ARRAY_BUFFER, GLsizeiptr(bytes), nullptr, GL_DYNAMIC_DRAW);
+        instanceBytes_ = bytes;
+    } // same size: no reallocation
+    glBufferSubData(GL_ARRAY_BUFFER, 0, GLsizeiptr(matBytes), instanceMats_.data());
+    if (normalMode_ == NormalMode::Precomputed) {
+        vector<NormalMatrix> normals(n);
+        parallelFor(n, [&](size_t b, size_t e) { computeNormalMatrices(instanceMats_.data(), normals.data(), b, e); });
+        glBufferSubData(GL_ARRAY_BUFFER, GLintptr(matBytes), GLsizeiptr(n * sizeof(NormalMatrix)), normals.data());
+    }
+    instanceCount_ = static_cast<GLsizei>(n);
+
+    if (animator_) {
+        instanceRing_.allocate(GL_ARRAY_BUFFER, bytes, 256);
+        animScratch_.resize(normalMode_ == NormalMode::Precomputed ? n : 0);
+    }
 
-    // mat4 takes 4 attribute locations (2..5)
-    constexpr GLuint baseLoc = 2;
+    glBindVertexArray(vao_);
+    bindInstanceAttribs_(instanceVbo_, 0);
+    glBindVertexArray(0);
+}
+
+// mat4 takes 4 attribute locations (2..5), the normal mat3 three more (6..8); call with the VAO bound
+void ModelObject::bindInstanceAttribs_(GLuint buffer, size_t offset) {
+    constexpr GLuint baseLoc = 2, normalLoc = 6;
     constexpr GLsizei vec4Size = sizeof(glm::vec4);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
     for (int i = 0; i < 4; ++i) {
         glEnableVertexAttribArray(baseLoc + i);
-        const uintptr_t offset = static_cast<uintptr_t>(i) * static_cast<uintptr_t>(vec4Size);
+        const uintptr_t col = offset + static_cast<uintptr_t>(i) * static_cast<uintptr_t>(vec4Size);
         glVertexAttribPointer(baseLoc + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-                              reinterpret_cast<void*>(offset));
+                              reinterpret_cast<void*>(col));
         glVertexAttribDivisor(baseLoc + i, 1);
     }
-    glBindVertexArray(0);
 
-    instanceCount_ = static_cast<GLsizei>(instanceMats_.size());
+    const size_t normalOffset = offset + instanceMats_.size() * sizeof(glm::mat4);
+    for (int i = 0; i < 3; ++i) {
+        if (normalMode_ != NormalMode::Precomputed) { glDisableVertexAttribArray(normalLoc + i); continue; }
+        glEnableVertexAttribArray(normalLoc + i);
+        const uintptr_t col = normalOffset + static_cast<uintptr_t>(i) * static_cast<uintptr_t>(vec4Size);
+        glVertexAttribPointer(normalLoc + i, 3, GL_FLOAT, GL_FALSE, sizeof(NormalMatrix),
+                              reinterpret_cast<void*>(col));
+        glVertexAttribDivisor(normalLoc + i, 1);
+    }
+}
+
+void ModelObject::setNormalMode_(NormalMode mode) {
+    if (mode == normalMode_) return;
+    normalMode_ = mode;
+    buildProgram_();
+}
+
+void ModelObject::setInstanceAnimator(InstanceAnimator animator) {
+    animator_ = move(animator);
+    if (instanceCount_ > 0) setupInstanceBuffer(); // re-picks the normal mode, sizes the ring
 }
 
 //destructor
@@ -195,12 +464,37 @@ void ModelObject::render() {
     glUseProgram(program_);
     glUniformMatrix4fv(uView_, 1, GL_FALSE, glm::value_ptr(*view_));
     glUniformMatrix4fv(uProj_, 1, GL_FALSE, glm::value_ptr(*proj_));
+    if (format_ == VertexFormat::Quantized) {
+        glUniform3fv(uDequantOffset_, 1, glm::value_ptr(bboxMin_));
+        glUniform3fv(uDequantScale_,  1, glm::value_ptr(bboxSize()));
+    }
 
     glBindVertexArray(vao_);
+    const bool streaming = animator_ && instanceRing_.valid();
+    if (streaming) {
+        // this frame's region: written straight into mapped memory, attributes point at it
+        auto* region = static_cast<unsigned char*>(instanceRing_.beginWrite());
+        auto* dst = reinterpret_cast<glm::mat4*>(region);
+        if (normalMode_ != NormalMode::Precomputed) {
+            animator_(animTime_, instanceMats_.data(), dst, instanceMats_.size());
+        } else {
+            // the mapping may be write-combined: animate into cached memory, then store the
+            // matrices and their normal matrices per chunk without reading the mapping back
+            animator_(animTime_, instanceMats_.data(), animScratch_.data(), animScratch_.size());
+            auto* normals = reinterpret_cast<NormalMatrix*>(region + animScratch_.size() * sizeof(glm::mat4));
+            parallelFor(animScratch_.size(), [&](size_t b, size_t e) {
+                copy(animScratch_.begin() + b, animScratch_.begin() + e, dst + b);
+                computeNormalMatrices(animScratch_.data(), normals, b, e);
+            });
+        }
+        instanceRing_.endWrite();
+        bindInstanceAttribs_(instanceRing_.buffer(), instanceRing_.offset());
+    }
     glDrawElementsInstanced(GL_TRIANGLES,
-                            static_cast<GLsizei>(indices_.size()),
+                            static_cast<GLsizei>(mesh_.indexCount),
                             GL_UNSIGNED_INT,
                             reinterpret_cast<void*>(0),
                             instanceCount_);
+    if (streaming) instanceRing_.fence();
     glBindVertexArray(0);
 }
@@ -8,7 +8,11 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cfloat>
+#include "meshCacheClass.hpp"
+#include "persistentRingClass.hpp"
+#include "normalMatrixUtil.hpp"
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,14 +22,35 @@ using namespace std;
 
 
 
+// writes animated transforms for `count` instances at time `t` from their static `base` ones
+using InstanceAnimator = function<void(double t, const glm::mat4* base, glm::mat4* dst, size_t count)>;
+
+// GPU vertex layout
+enum class VertexFormat {
+    Float,      // pos 3x f32 + normal 3x f32 (24 bytes)
+    Quantized,  // pos 3x unorm16 within the mesh AABB (+pad), normal octahedral 2x snorm16 (12 bytes)
+};
+
+// how the VS gets each instance's normal matrix
+enum class NormalMode {
+    Inverse,       // transpose(inverse(mat3)) per vertex (reference / A-B timing)
+    Precomputed,   // per-instance inverse-transpose, instanced attribute at locations 6..8
+    UniformScale,  // every instance is rotation * uniform scale: mat3(model) is enough
+};
+
 class ModelObject{
 public:
 
-    ModelObject(const string& meshPath);
+    ModelObject(const string& meshPath, VertexFormat format = VertexFormat::Float);
     ~ModelObject();
 
     void bindCamera(const glm::mat4* viewPtr, const glm::mat4* projPtr);
     void setInstanceTransforms(const vector<glm::mat4>& transforms);//here or in scene builder?
+    const vector<glm::mat4>& instanceTransforms() const { return instanceMats_; }
+    // streaming mode: render() asks the animator for this frame's transforms and writes them
+    // into a persistent-mapped triple-buffered ring (orphaning without ARB_buffer_storage)
+    void setInstanceAnimator(InstanceAnimator animator);
+    void setAnimationTime(double t) { animTime_ = t; }
 
     //for spacing
     glm::vec3 bboxMin()  const { return bboxMin_; }
@@ -35,15 +60,33 @@ public:
 
     void render();
 
+    // prints Assimp vs native STL load times for a file (no GL context needed)
+    static void benchmarkLoad(const string& path);
+
+    // read/write "<mesh>.meshcache" next to the source (on by default)
+    static void setMeshCacheEnabled(bool on) { meshCacheEnabled_ = on; }
+    // vertex cache / overdraw / vertex fetch reordering at import (on by default; cached
+    // meshes are keyed on it)
+    static void setMeshOptimizeEnabled(bool on) { meshOptimizeEnabled_ = on; }
+    // normal matrices computed on the CPU when transforms change (on by default);
+    // off keeps the per-vertex inverse. Applies to objects created afterwards.
+    static void setPrecomputedNormals(bool on) { precomputeNormals_ = on; }
+    NormalMode  normalMode() const { return normalMode_; }
+
 private:
     // shader utils
     static GLuint compile(GLenum type, const char* src);
     static GLuint link(GLuint vs, GLuint fs);
+    void buildProgram_();
+    void setNormalMode_(NormalMode mode);
 
     // mesh utils
     void loadMesh(const string& path);
     void uploadMesh();
+    void quantizeVertices_();
+    void optimizeMesh_();
     void setupInstanceBuffer();
+    void bindInstanceAttribs_(GLuint buffer, size_t offset); // matrices, then normal matrices
 
     //for spacing
     glm::vec3 bboxMin_{  FLT_MAX,  FLT_MAX,  FLT_MAX };
@@ -52,13 +95,32 @@ private:
     // gpu
     GLuint vao_ = 0, vbo_ = 0, ebo_ = 0, instanceVbo_ = 0, program_ = 0;
 
-    // cpu mesh
+    // cpu mesh: either owned vectors or a mapped cache file, viewed through mesh_;
+    // both are released once uploaded
     vector<float> interleaved_;     // pos(3) + normal(3)
     vector<unsigned> indices_;
+    unique_ptr<mappedFileClass> cacheFile_;
+    meshCacheClass::MeshView mesh_;
+    static bool meshCacheEnabled_;
+    static bool meshOptimizeEnabled_;
+
+    struct QuantizedVertex {
+        uint16_t px, py, pz, pad;
+        int16_t  nx, ny;
+    };
+    VertexFormat format_ = VertexFormat::Float;
+    vector<QuantizedVertex> quantized_;
 
     // instancing
     vector<glm::mat4> instanceMats_;
     GLsizei instanceCount_ = 0;
+    size_t  instanceBytes_ = 0;     // instanceVbo_: matrices, then normal matrices when precomputed
+    persistentRingClass instanceRing_;  // same layout per region
+    InstanceAnimator    animator_;
+    double              animTime_ = 0.0;
+    vector<glm::mat4>   animScratch_;   // animator output when normals are derived from it
+    NormalMode          normalMode_ = NormalMode::Inverse;
+    static bool         precomputeNormals_;
 
     // camera (not owned)
     const glm::mat4* view_ = nullptr;
@@ -67,6 +129,8 @@ private:
     // uniform locations
     GLint uView_ = -1;
     GLint uProj_ = -1;
+    GLint uDequantOffset_ = -1;
+    GLint uDequantScale_  = -1;
 
     // defaults
     static const char* kDefaultVS;
@@ -0,0 +1,32 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// number of CPU workers used by the parallel helpers
+inline unsigned workerCount() {
+    unsigned n = thread::hardware_concurrency();
+    return n ? n : 1u;
+}
+
+// Splits [0, count) into contiguous chunks (one per worker, at least minChunk items each)
+// and runs fn(begin, end) on them. Chunk i always covers the same range for a given
+// count and worker count, so per-chunk results can be stitched back in order.
+template <class Fn>
+inline void parallelFor(size_t count, Fn&& fn, size_t minChunk = 4096) {
+    if (count == 0) return;
+    size_t chunks = min<size_t>(workerCount(), (count + minChunk - 1) / minChunk);
+    if (chunks <= 1) { fn(size_t(0), count); return; }
+
+    const size_t per = (count + chunks - 1) / chunks;
+    vector<thread> pool;
+    pool.reserve(chunks - 1);
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t b = c * per, e = min(count, b + per);
+        if (b < e) pool.emplace_back([&fn, b, e] { fn(b, e); });
+    }
+    fn(size_t(0), min(count, per)); // caller's thread takes the first chunk
+    for (auto& t : pool) t.join();
+}
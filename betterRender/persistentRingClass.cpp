@@ -0,0 +1,77 @@
+#include "persistentRingClass.hpp"
+
+#include <iostream>
+using namespace std;
+
+void persistentRingClass::release_() {
+    for (GLsync& f : fences_) {
+        if (f) glDeleteSync(f);
+        f = nullptr;
+    }
+    if (buffer_) {
+        if (mapped_) {
+            glBindBuffer(target_, buffer_);
+            glUnmapBuffer(target_);
+        }
+        glDeleteBuffers(1, &buffer_);
+    }
+    buffer_ = 0;
+    mapped_ = nullptr;
+}
+
+void persistentRingClass::allocate(GLenum target, size_t bytes, size_t alignment) {
+    release_();
+    target_ = target;
+    bytes_  = bytes;
+    alignment = alignment ? alignment : 1;
+    stride_ = (bytes + alignment - 1) / alignment * alignment;
+    head_   = kRegions - 1; // first beginWrite() moves to region 0
+    persistent_ = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+
+    glGenBuffers(1, &buffer_);
+    glBindBuffer(target_, buffer_);
+    if (persistent_) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(target_, GLsizeiptr(stride_ * kRegions), nullptr, flags);
+        mapped_ = static_cast<unsigned char*>(glMapBufferRange(target_, 0, GLsizeiptr(stride_ * kRegions), flags));
+        if (!mapped_) {
+            cerr << "persistentRingClass: persistent map failed, falling back to orphaning\n";
+            glDeleteBuffers(1, &buffer_);
+            glGenBuffers(1, &buffer_);
+            glBindBuffer(target_, buffer_);
+            persistent_ = false;
+        }
+    }
+    if (!persistent_) {
+        glBufferData(target_, GLsizeiptr(bytes_), nullptr, GL_STREAM_DRAW);
+        staging_.resize(bytes_);
+    }
+}
+
+void* persistentRingClass::beginWrite() {
+    if (!buffer_) return nullptr;
+    if (!persistent_) return staging_.data();
+
+    head_ = (head_ + 1) % kRegions;
+    if (GLsync& f = fences_[head_]) {
+        // normally already signalled: the GPU finished this region two frames ago
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(f, flags, 1000000) == GL_TIMEOUT_EXPIRED) flags = 0;
+        glDeleteSync(f);
+        f = nullptr;
+    }
+    return mapped_ + size_t(head_) * stride_;
+}
+
+void persistentRingClass::endWrite() {
+    if (!buffer_ || persistent_) return; // coherent mapping: visible to the next command
+    glBindBuffer(target_, buffer_);
+    glBufferData(target_, GLsizeiptr(bytes_), nullptr, GL_STREAM_DRAW); // orphan: no wait on the GPU
+    glBufferSubData(target_, 0, GLsizeiptr(bytes_), staging_.data());
+}
+
+void persistentRingClass::fence() {
+    if (!buffer_ || !persistent_) return;
+    if (fences_[head_]) glDeleteSync(fences_[head_]);
+    fences_[head_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
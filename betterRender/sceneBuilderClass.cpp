@@ -1,14 +1,23 @@
 #include "sceneBuilderClass.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 using namespace std;
 
 //initialize window and camera
-sceneBuilderClass::sceneBuilderClass() {
+sceneBuilderClass::sceneBuilderClass(bool headless) : headless_(headless) {
     windowInit(1280, 720, "Instanced Scene");
     setCamera(60.0f, 1280.0f / 720.0f, 0.1f, 1000.0f);
 }
 
 GLFWwindow* sceneBuilderClass::windowInit(int width, int height, string name) {
+#ifdef GLFW_PLATFORM_NULL
+    // no display server at all (build machines): GLFW's null platform with an EGL context
+    if (headless_ && !getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY")) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#endif
     if (!glfwInit()) {
         cerr << "GLFW init failed\n";
         return nullptr;
@@ -16,6 +25,12 @@ GLFWwindow* sceneBuilderClass::windowInit(int width, int height, string name) {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (headless_) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+    }
 
     window = glfwCreateWindow(width, height, name.c_str(), nullptr, nullptr);
     if (!window) {
@@ -23,8 +38,13 @@ GLFWwindow* sceneBuilderClass::windowInit(int width, int height, string name) {
         return nullptr;
     }
     glfwMakeContextCurrent(window);
+    if (headless_) glfwSwapInterval(0);
 
-    if (glewInit() != GLEW_OK) {
+    GLenum glewErr = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glewErr == GLEW_ERROR_NO_GLX_DISPLAY) glewErr = GLEW_OK; // EGL context: GL entry points are loaded, GLX ones are not needed
+#endif
+    if (glewErr != GLEW_OK) {
         cerr << "GLEW init failed\n";
         return nullptr;
     }
@@ -91,9 +111,117 @@ void sceneBuilderClass::run() {
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
         for (auto& obj : objects_) {
+            obj->setAnimationTime(glfwGetTime());
             obj->render();
         }
 
         glfwSwapBuffers(window);
     }
 }
+
+// colour + depth renderbuffers sized to the window
+void sceneBuilderClass::ensureTarget_(int w, int h) {
+    if (fbo_ && w == targetW_ && h == targetH_) return;
+    targetW_ = w; targetH_ = h;
+
+    if (!fbo_) {
+        glGenFramebuffers(1, &fbo_);
+        glGenRenderbuffers(1, &colorRb_);
+        glGenRenderbuffers(1, &depthRb_);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, colorRb_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+    glBindRenderbuffer(GL_RENDERBUFFER, depthRb_);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, w, h);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRb_);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,  GL_RENDERBUFFER, depthRb_);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cerr << "Offscreen framebuffer incomplete\n";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+// one slightly raised orbit around every object's instances
+glm::mat4 sceneBuilderClass::orbitView_(int frame, int frameCount) const {
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    float meshExtent = 0.0f;
+    for (auto& o : objects_) {
+        for (const glm::mat4& m : o->instanceTransforms()) {
+            lo = glm::min(lo, glm::vec3(m[3]));
+            hi = glm::max(hi, glm::vec3(m[3]));
+        }
+        meshExtent = max(meshExtent, o->maxExtent());
+    }
+    if (lo.x > hi.x) { lo = glm::vec3(-1.0f); hi = glm::vec3(1.0f); }
+
+    const glm::vec3 center = 0.5f * (lo + hi);
+    const float radius = 0.75f * glm::length(hi - lo) + 2.0f * meshExtent + 1.0f;
+    const float a = 6.2831853f * float(frame) / float(frameCount);
+    const glm::vec3 eye = center + glm::vec3(sin(a) * radius, 0.25f * radius, cos(a) * radius);
+    return glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// Fixed-length run for perf regressions; frames are a function of the frame index only
+void sceneBuilderClass::runBenchmark(int frameCount) {
+    if (!window || frameCount <= 0) return;
+    bindCameraPointers();
+
+    // two GL_TIME_ELAPSED queries: frame i is read back while frame i+1 is recorded
+    GLuint queries[2];
+    glGenQueries(2, queries);
+    vector<double> cpuMs(frameCount, 0.0), gpuMs(frameCount, 0.0);
+    auto readGpu = [&](int frame) {
+        GLuint64 ns = 0;
+        glGetQueryObjectui64v(queries[frame & 1], GL_QUERY_RESULT, &ns);
+        gpuMs[frame] = double(ns) * 1e-6;
+        cout << "[bench] frame " << frame << " cpu " << cpuMs[frame] << " ms gpu " << gpuMs[frame] << " ms\n";
+    };
+
+    const auto wall0 = chrono::steady_clock::now();
+    for (int f = 0; f < frameCount; ++f) {
+        glfwPollEvents();
+        view = orbitView_(f, frameCount);
+
+        int w, h;
+        glfwGetFramebufferSize(window, &w, &h);
+        if (headless_) {
+            ensureTarget_(w, h);
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+        }
+
+        const auto t0 = chrono::steady_clock::now();
+        glBeginQuery(GL_TIME_ELAPSED, queries[f & 1]);
+        glViewport(0, 0, w, h);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        for (auto& obj : objects_) {
+            obj->setAnimationTime(f / 60.0); // follows the frame index, like the camera
+            obj->render();
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+        if (headless_) glFlush();
+        else glfwSwapBuffers(window);
+        cpuMs[f] = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+        if (f > 0) readGpu(f - 1);
+    }
+    readGpu(frameCount - 1);
+    glFinish();
+    const double wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - wall0).count();
+    glDeleteQueries(2, queries);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    auto summarize = [&](const char* name, vector<double> v) {
+        sort(v.begin(), v.end());
+        double sum = 0.0; for (double x : v) sum += x;
+        cout << "[bench] " << name << " ms: avg " << sum / v.size() << " min " << v.front()
+             << " p50 " << v[v.size() / 2] << " p95 " << v[min(v.size() - 1, v.size() * 95 / 100)]
+             << " max " << v.back() << "\n";
+    };
+    cout << "[bench] " << frameCount << " frames" << (headless_ ? " headless" : "") << "\n";
+    summarize("cpu", cpuMs);
+    summarize("gpu", gpuMs);
+    cout << "[bench] wall " << wallMs << " ms (" << frameCount * 1000.0 / max(wallMs, 1e-6) << " fps)\n";
+}
@@ -9,7 +9,9 @@ using namespace std;
 
 class sceneBuilderClass {
 public:
-    sceneBuilderClass();
+    // headless: invisible window (or GLFW's null platform + EGL when there is no display),
+    // renders into an FBO; pair with runBenchmark()
+    explicit sceneBuilderClass(bool headless = false);
     GLFWwindow* windowInit(int width, int height, string name);
 
     // camera
@@ -22,12 +24,21 @@ public:
 
     // main loop
     void run();
+    // fixed number of frames on a scripted orbit; prints per-frame CPU/GPU ms and a summary
+    void runBenchmark(int frameCount);
 
 private:
     void bindCameraPointers();
+    void ensureTarget_(int w, int h);
+    glm::mat4 orbitView_(int frame, int frameCount) const;
 
 private:
     GLFWwindow* window = nullptr;
+    bool headless_ = false;
+
+    // offscreen target for headless runs (the null platform has no default framebuffer)
+    GLuint fbo_ = 0, colorRb_ = 0, depthRb_ = 0;
+    int    targetW_ = 0, targetH_ = 0;
     glm::mat4 view{1.0f}, projection{1.0f};
     vector<shared_ptr<ModelObject>> objects_;
 };
@@ -0,0 +1,32 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <cfloat>
+#include <cstdint>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Native STL reader used instead of Assimp for .stl files.
+// mmaps the file, parses triangles in parallel chunks, welds identical positions with a
+// sharded parallel hash and generates area-weighted smooth normals.
+class stlLoaderClass {
+public:
+    static bool isStlPath(const string& path);
+
+    // pos(3) + normal(3) interleaved vertices and triangle indices; throws on malformed files
+    static void load(const string& path,
+                     vector<float>& interleaved,
+                     vector<unsigned>& indices,
+                     glm::vec3& bboxMin,
+                     glm::vec3& bboxMax);
+
+private:
+    // triangle soup: 9 floats per triangle
+    static void parseBinary_(const unsigned char* data, size_t size, vector<float>& soup);
+    static void parseAscii_(const unsigned char* data, size_t size, vector<float>& soup);
+
+    // soup -> unique positions + indices, order of first occurrence (thread-count independent)
+    static void weld_(const vector<float>& soup, vector<float>& positions, vector<unsigned>& indices);
+    static void generateNormals_(const vector<float>& positions, const vector<unsigned>& indices,
+                                 vector<float>& interleaved);
+};
@@ -0,0 +1,215 @@
+#include "meshOptimizerClass.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+using namespace std;
+
+namespace {
+// Forsyth's scoring: the LRU cache here only ranks candidates, it is not a FIFO model
+constexpr int   kScoreCacheSize = 32;
+constexpr float kLastTriScore   = 0.75f;
+constexpr float kCacheDecay     = 1.5f;
+constexpr float kValenceScale   = 2.0f;
+constexpr float kValencePower   = 0.5f;
+
+struct ScoreTables {
+    float cache[kScoreCacheSize];
+    float valence[64];
+    ScoreTables() {
+        for (int i = 0; i < kScoreCacheSize; ++i) {
+            cache[i] = i < 3 ? kLastTriScore
+                             : pow(1.0f - float(i - 3) / float(kScoreCacheSize - 3), kCacheDecay);
+        }
+        valence[0] = 0.0f;
+        for (int i = 1; i < 64; ++i) valence[i] = kValenceScale * pow(float(i), -kValencePower);
+    }
+};
+
+inline float vertexScore(const ScoreTables& t, int cachePos, uint32_t live) {
+    if (live == 0) return -1.0f; // no triangle left to pull in
+    const float c = cachePos >= 0 ? t.cache[cachePos] : 0.0f;
+    return c + (live < 64 ? t.valence[live] : kValenceScale * pow(float(live), -kValencePower));
+}
+} // namespace
+
+meshOptimizerClass::CacheStats meshOptimizerClass::analyzeVertexCache(const unsigned* indices, size_t indexCount,
+                                                                       size_t vertexCount, uint32_t cacheSize) {
+    // FIFO via insertion stamps: resident while fewer than cacheSize misses happened since
+    vector<uint32_t> stamp(vertexCount, 0);
+    vector<uint8_t>  seen(vertexCount, 0);
+    uint32_t time = cacheSize + 1;
+    size_t misses = 0, referenced = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        const unsigned v = indices[i];
+        if (time - stamp[v] > cacheSize) { stamp[v] = time++; ++misses; }
+        if (!seen[v]) { seen[v] = 1; ++referenced; }
+    }
+    CacheStats s{0.0f, 0.0f};
+    if (indexCount >= 3) s.acmr = float(double(misses) / double(indexCount / 3));
+    if (referenced)      s.atvr = float(double(misses) / double(referenced));
+    return s;
+}
+
+void meshOptimizerClass::optimizeVertexCache(unsigned* indices, size_t indexCount, size_t vertexCount) {
+    const size_t triCount = indexCount / 3;
+    if (triCount == 0) return;
+    static const ScoreTables tables;
+
+    // vertex -> live triangles; live[v] is the length of v's list, emitted ones are swapped out
+    vector<uint32_t> start(vertexCount + 1, 0), adj(triCount * 3), live(vertexCount, 0);
+    for (size_t i = 0; i < triCount * 3; ++i) ++start[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v) start[v + 1] += start[v];
+    for (size_t i = 0; i < triCount * 3; ++i) adj[start[indices[i]] + live[indices[i]]++] = uint32_t(i / 3);
+
+    vector<int>     cachePos(vertexCount, -1);
+    vector<float>   score(vertexCount);
+    vector<uint8_t> emitted(triCount, 0);
+    for (size_t v = 0; v < vertexCount; ++v) score[v] = vertexScore(tables, -1, live[v]);
+
+    vector<unsigned> out;
+    out.reserve(triCount * 3);
+    vector<uint32_t> cache, next;
+    cache.reserve(kScoreCacheSize + 3);
+    next.reserve(kScoreCacheSize + 3);
+    size_t cursor = 0; // dead ends restart from the next triangle in input order
+    int64_t best = -1;
+
+    for (size_t done = 0; done < triCount; ++done) {
+        if (best < 0) {
+            while (emitted[cursor]) ++cursor;
+            best = int64_t(cursor);
+        }
+        const unsigned* tri = indices + size_t(best) * 3;
+        out.insert(out.end(), tri, tri + 3);
+        emitted[size_t(best)] = 1;
+        for (int k = 0; k < 3; ++k) {
+            const unsigned v = tri[k];
+            uint32_t* list = adj.data() + start[v];
+            for (uint32_t a = 0; a < live[v]; ++a) {
+                if (list[a] == uint32_t(best)) { list[a] = list[--live[v]]; break; }
+            }
+        }
+
+        // the emitted triangle goes to the front; whatever falls off the end is rescored too
+        next.assign(tri, tri + 3);
+        for (uint32_t v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) next.push_back(v);
+        }
+        for (size_t i = 0; i < next.size(); ++i) {
+            cachePos[next[i]] = i < size_t(kScoreCacheSize) ? int(i) : -1;
+            score[next[i]] = vertexScore(tables, cachePos[next[i]], live[next[i]]);
+        }
+        if (next.size() > size_t(kScoreCacheSize)) next.resize(kScoreCacheSize);
+        cache.swap(next);
+
+        // best live triangle touching the cache
+        best = -1;
+        float bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t a = start[v]; a < start[v] + live[v]; ++a) {
+                const unsigned* t = indices + size_t(adj[a]) * 3;
+                const float s = score[t[0]] + score[t[1]] + score[t[2]];
+                if (s > bestScore) { bestScore = s; best = adj[a]; }
+            }
+        }
+    }
+    memcpy(indices, out.data(), out.size() * sizeof(unsigned));
+}
+
+void meshOptimizerClass::optimizeOverdraw(unsigned* indices, size_t indexCount, const float* vertices,
+                                          size_t vertexCount, size_t strideFloats, float threshold) {
+    const size_t triCount = indexCount / 3;
+    if (triCount < 2) return;
+    auto pos = [&](unsigned v) { return vertices + size_t(v) * strideFloats; };
+    const float limit = analyzeVertexCache(indices, indexCount, vertexCount).acmr * threshold;
+
+    // Clusters: a triangle that misses all three vertices starts one (the cache is cold there
+    // anyway); otherwise cut as soon as the running cluster is within `limit`. Each cluster
+    // is simulated from a cold cache, as it may land anywhere after sorting.
+    vector<uint32_t> clusters{0};
+    vector<uint32_t> stamp(vertexCount, 0);
+    uint32_t time = kCacheSize + 1;
+    size_t clusterTris = 0, clusterMisses = 0;
+    for (size_t t = 0; t < triCount; ++t) {
+        const unsigned* tri = indices + t * 3;
+        int cold = 0;
+        for (int k = 0; k < 3; ++k) cold += time - stamp[tri[k]] > kCacheSize ? 1 : 0;
+        if (cold == 3 && clusterTris > 0) {
+            clusters.push_back(uint32_t(t));
+            clusterTris = clusterMisses = 0;
+            time += kCacheSize + 1;
+        }
+        for (int k = 0; k < 3; ++k) {
+            if (time - stamp[tri[k]] > kCacheSize) { stamp[tri[k]] = time++; ++clusterMisses; }
+        }
+        ++clusterTris;
+        if (t + 1 < triCount && float(clusterMisses) <= limit * float(clusterTris)) {
+            clusters.push_back(uint32_t(t + 1));
+            clusterTris = clusterMisses = 0;
+            time += kCacheSize + 1;
+        }
+    }
+    clusters.push_back(uint32_t(triCount));
+    const size_t clusterCount = clusters.size() - 1;
+
+    // area-weighted centroid and normal per cluster, and for the whole mesh
+    vector<double> centroid(clusterCount * 3, 0.0), normal(clusterCount * 3, 0.0);
+    double meshC[3] = {0.0, 0.0, 0.0}, meshArea = 0.0;
+    for (size_t c = 0; c < clusterCount; ++c) {
+        double area = 0.0;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+            const float* p0 = pos(indices[t * 3]);
+            const float* p1 = pos(indices[t * 3 + 1]);
+            const float* p2 = pos(indices[t * 3 + 2]);
+            const double e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            const double e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            const double n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            const double w = 0.5 * sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+            for (int k = 0; k < 3; ++k) {
+                centroid[c * 3 + k] += w * (p0[k] + p1[k] + p2[k]) / 3.0;
+                normal[c * 3 + k]   += n[k];
+            }
+            area += w;
+        }
+        for (int k = 0; k < 3; ++k) meshC[k] += centroid[c * 3 + k];
+        if (area > 0.0) for (int k = 0; k < 3; ++k) centroid[c * 3 + k] /= area;
+        meshArea += area;
+    }
+    if (meshArea > 0.0) for (double& x : meshC) x /= meshArea;
+
+    // outward-facing clusters first
+    vector<double> key(clusterCount, 0.0);
+    for (size_t c = 0; c < clusterCount; ++c) {
+        const double* n = &normal[c * 3];
+        const double len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len <= 0.0) continue;
+        for (int k = 0; k < 3; ++k) key[c] += (centroid[c * 3 + k] - meshC[k]) * n[k] / len;
+    }
+    vector<uint32_t> order(clusterCount);
+    iota(order.begin(), order.end(), 0u);
+    stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    vector<unsigned> out;
+    out.reserve(triCount * 3);
+    for (uint32_t c : order) out.insert(out.end(), indices + size_t(clusters[c]) * 3, indices + size_t(clusters[c + 1]) * 3);
+    memcpy(indices, out.data(), out.size() * sizeof(unsigned));
+}
+
+size_t meshOptimizerClass::optimizeVertexFetch(float* vertices, size_t vertexCount, size_t strideFloats,
+                                               unsigned* indices, size_t indexCount) {
+    vector<unsigned> remap(vertexCount, ~0u);
+    unsigned used = 0;
+    for (size_t i = 0; i < indexCount; ++i) {
+        unsigned& r = remap[indices[i]];
+        if (r == ~0u) r = used++;
+        indices[i] = r;
+    }
+    vector<float> src(vertices, vertices + vertexCount * strideFloats);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        if (remap[v] == ~0u) continue;
+        memcpy(vertices + size_t(remap[v]) * strideFloats, src.data() + v * strideFloats, strideFloats * sizeof(float));
+    }
+    return used;
+}
@@ -12,6 +12,8 @@
 #include <iostream>
 #include <vector>
 
+#include "meshOptimizerClass.hpp"
+
 // Simple GLSL shaders
 const char* vShaderSrc = R"(
 #version 330 core
@@ -96,6 +98,13 @@ int main() {
             indices.push_back(face.mIndices[j]);
     }
 
+    // built-in vertex cache, overdraw and vertex fetch order (see meshOptimizerClass)
+    const size_t vertexCount = vertices.size() / 6;
+    meshOptimizerClass::optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    meshOptimizerClass::optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, 6);
+    vertices.resize(meshOptimizerClass::optimizeVertexFetch(vertices.data(), vertexCount, 6,
+                                                            indices.data(), indices.size()) * 6);
+
     // -------------------- Upload to GPU --------------------
     GLuint VBO, VAO, EBO;
     glGenVertexArrays(1, &VAO);
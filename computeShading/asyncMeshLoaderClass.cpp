@@ -0,0 +1,52 @@
+#include "asyncMeshLoaderClass.hpp"
+#include "traceRecorderClass.hpp"
+
+#include <thread>
+using namespace std;
+
+asyncMeshLoaderClass::asyncMeshLoaderClass(jobSystemClass& jobs) : jobs_(jobs) {}
+
+asyncMeshLoaderClass::~asyncMeshLoaderClass() {
+    cancelled_ = true;
+    // background jobs are never run by a waiter, so just let the workers drain them
+    while (inFlight_.pending.load(memory_order_acquire) > 0) this_thread::yield();
+}
+
+void asyncMeshLoaderClass::request(const string& path, VertexFormat format, size_t tag) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        ++outstanding_;
+    }
+    const auto queued = chrono::steady_clock::now();
+    jobs_.submitBackground([this, path, format, tag, queued] { load_(path, format, tag, queued); }, &inFlight_);
+}
+
+vector<asyncMeshLoaderClass::Result> asyncMeshLoaderClass::takeFinished() {
+    lock_guard<mutex> lock(mutex_);
+    vector<Result> out;
+    out.swap(finished_);
+    outstanding_ -= out.size();
+    return out;
+}
+
+size_t asyncMeshLoaderClass::pending() const {
+    lock_guard<mutex> lock(mutex_);
+    return outstanding_;
+}
+
+void asyncMeshLoaderClass::load_(const string& path, VertexFormat format, size_t tag,
+                                 chrono::steady_clock::time_point queued) {
+    if (cancelled_) return;
+    shared_ptr<ModelObject> object;
+    try {
+        TRACE_SCOPE("async mesh load");
+        object = make_shared<ModelObject>(path, format);
+    } catch (const exception& e) {
+        cerr << "[async] " << path << ": " << e.what() << "\n";
+    }
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - queued).count();
+
+    lock_guard<mutex> lock(mutex_);
+    if (object) finished_.push_back({move(object), path, tag, ms});
+    else --outstanding_;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "modelClass.hpp"
+#include "jobSystemClass.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Builds ModelObjects as background jobs on the shared job system: import (or cache map),
+// optimization, LODs, meshlets and quantization are all CPU work, so none of it needs the
+// GL context. The render thread collects finished objects with takeFinished() and uploads
+// them itself; nothing here touches GL.
+class asyncMeshLoaderClass {
+public:
+    struct Result {
+        shared_ptr<ModelObject> object;
+        string path;
+        size_t tag;     // whatever request() was given
+        double ms;      // queue + load time
+    };
+
+    explicit asyncMeshLoaderClass(jobSystemClass& jobs = jobSystemClass::global());
+    ~asyncMeshLoaderClass();  // queued requests are skipped, running ones finish
+    asyncMeshLoaderClass(const asyncMeshLoaderClass&) = delete;
+    asyncMeshLoaderClass& operator=(const asyncMeshLoaderClass&) = delete;
+
+    void request(const string& path, VertexFormat format, size_t tag);
+    // loads finished since the last call; failed ones are reported on cerr and dropped
+    vector<Result> takeFinished();
+    // requested but not yet taken
+    size_t pending() const;
+
+private:
+    void load_(const string& path, VertexFormat format, size_t tag, chrono::steady_clock::time_point queued);
+
+    jobSystemClass& jobs_;
+    jobSystemClass::Counter inFlight_;
+    atomic<bool> cancelled_{false};
+    mutable mutex mutex_;
+    vector<Result> finished_;
+    size_t outstanding_ = 0;
+};
@@ -0,0 +1,253 @@
+#include "cpuCullerClass.hpp"
+#include "parallelUtil.hpp"
+
+#include <algorithm>
+#include <cmath>
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64)
+#include <immintrin.h>
+#define CPU_CULL_X86 1
+#endif
+#if defined(CPU_CULL_X86) && defined(__GNUC__)
+#define CPU_CULL_AVX2 1   // compiled for AVX2 via the target attribute, chosen at runtime
+#endif
+using namespace std;
+
+static constexpr uint32_t kChunk = 1u << 16; // instances per work item
+
+namespace {
+struct Planes {
+    float nx[6], ny[6], nz[6], d[6];
+    float ax[6], ay[6], az[6];   // |n|, for the projected extent
+};
+
+// writes the visible indices of [b, e) to out, returns how many
+uint32_t cullScalar(const Planes& P, const float* cx, const float* cy, const float* cz,
+                    const float* ex, const float* ey, const float* ez, uint32_t b, uint32_t e, uint32_t* out) {
+    uint32_t n = 0;
+    for (uint32_t i = b; i < e; ++i) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; ++p) {
+            const float s = P.nx[p] * cx[i] + P.ny[p] * cy[i] + P.nz[p] * cz[i] + P.d[p];
+            const float r = P.ax[p] * ex[i] + P.ay[p] * ey[i] + P.az[p] * ez[i];
+            inside = s >= -r;
+        }
+        if (inside) out[n++] = i;
+    }
+    return n;
+}
+
+#ifdef CPU_CULL_X86
+uint32_t cullSse(const Planes& P, const float* cx, const float* cy, const float* cz,
+                 const float* ex, const float* ey, const float* ez, uint32_t b, uint32_t e, uint32_t* out) {
+    uint32_t n = 0, i = b;
+    for (; i + 4 <= e; i += 4) {
+        const __m128 x = _mm_loadu_ps(cx + i), y = _mm_loadu_ps(cy + i), z = _mm_loadu_ps(cz + i);
+        const __m128 hx = _mm_loadu_ps(ex + i), hy = _mm_loadu_ps(ey + i), hz = _mm_loadu_ps(ez + i);
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            const __m128 s = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(P.nx[p]), x), _mm_mul_ps(_mm_set1_ps(P.ny[p]), y)),
+                                        _mm_add_ps(_mm_mul_ps(_mm_set1_ps(P.nz[p]), z), _mm_set1_ps(P.d[p])));
+            const __m128 r = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(P.ax[p]), hx), _mm_mul_ps(_mm_set1_ps(P.ay[p]), hy)),
+                                        _mm_mul_ps(_mm_set1_ps(P.az[p]), hz));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(s, r), _mm_setzero_ps()));
+        }
+        for (unsigned m = unsigned(_mm_movemask_ps(inside)); m; m &= m - 1) out[n++] = i + unsigned(__builtin_ctz(m));
+    }
+    return n + cullScalar(P, cx, cy, cz, ex, ey, ez, i, e, out + n);
+}
+#endif
+
+#ifdef CPU_CULL_AVX2
+__attribute__((target("avx2,fma")))
+uint32_t cullAvx2(const Planes& P, const float* cx, const float* cy, const float* cz,
+                  const float* ex, const float* ey, const float* ez, uint32_t b, uint32_t e, uint32_t* out) {
+    uint32_t n = 0, i = b;
+    for (; i + 8 <= e; i += 8) {
+        const __m256 x = _mm256_loadu_ps(cx + i), y = _mm256_loadu_ps(cy + i), z = _mm256_loadu_ps(cz + i);
+        const __m256 hx = _mm256_loadu_ps(ex + i), hy = _mm256_loadu_ps(ey + i), hz = _mm256_loadu_ps(ez + i);
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; ++p) {
+            __m256 s = _mm256_fmadd_ps(_mm256_set1_ps(P.nx[p]), x, _mm256_set1_ps(P.d[p]));
+            s = _mm256_fmadd_ps(_mm256_set1_ps(P.ny[p]), y, s);
+            s = _mm256_fmadd_ps(_mm256_set1_ps(P.nz[p]), z, s);
+            s = _mm256_fmadd_ps(_mm256_set1_ps(P.ax[p]), hx, s);   // s + r
+            s = _mm256_fmadd_ps(_mm256_set1_ps(P.ay[p]), hy, s);
+            s = _mm256_fmadd_ps(_mm256_set1_ps(P.az[p]), hz, s);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(s, _mm256_setzero_ps(), _CMP_GE_OQ));
+        }
+        for (unsigned m = unsigned(_mm256_movemask_ps(inside)); m; m &= m - 1) out[n++] = i + unsigned(__builtin_ctz(m));
+    }
+    return n + cullScalar(P, cx, cy, cz, ex, ey, ez, i, e, out + n);
+}
+#endif
+
+using CullFn = uint32_t (*)(const Planes&, const float*, const float*, const float*,
+                            const float*, const float*, const float*, uint32_t, uint32_t, uint32_t*);
+
+CullFn pickCullFn(const char** name) {
+#ifdef CPU_CULL_AVX2
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) { *name = "avx2"; return cullAvx2; }
+#endif
+#ifdef CPU_CULL_X86
+    *name = "sse"; return cullSse;
+#else
+    *name = "scalar"; return cullScalar;
+#endif
+}
+
+const char* gSimdName = "scalar";
+const CullFn gCull = pickCullFn(&gSimdName);
+
+struct Soa { const float *cx, *cy, *cz, *ex, *ey, *ez; };
+
+// Depth-first walk of one treelet, tracking which planes still cut the current node;
+// writes instance indices (order[slot]) to out and returns how many.
+uint32_t cullTreelet(const Planes& P, const Soa& b, const instanceBvhClass::Node* nodes, uint32_t root,
+                     bool cullEnabled, const uint32_t* order, uint32_t* out) {
+    struct Entry { uint32_t node, mask; };
+    Entry stack[instanceBvhClass::kTreeletLeaves + 1];
+    int sp = 0;
+    stack[sp++] = {root, cullEnabled ? 0x3Fu : 0u};
+    uint32_t n = 0;
+    while (sp > 0) {
+        const Entry top = stack[--sp];
+        const instanceBvhClass::Node& node = nodes[top.node];
+        uint32_t mask = top.mask;
+        bool outside = false;
+        const glm::vec3 c = 0.5f * (node.bmin + node.bmax), h = 0.5f * (node.bmax - node.bmin);
+        for (int p = 0; p < 6 && mask && !outside; ++p) {
+            if (!(mask & (1u << p))) continue;
+            const float s = P.nx[p] * c.x + P.ny[p] * c.y + P.nz[p] * c.z + P.d[p];
+            const float r = P.ax[p] * h.x + P.ay[p] * h.y + P.az[p] * h.z;
+            if (s < -r) outside = true;
+            else if (s >= r) mask &= ~(1u << p); // entirely on the inner side of this plane
+        }
+        if (outside) continue;
+        if (node.left & instanceBvhClass::kLeafBit) {
+            const uint32_t first = node.left & ~instanceBvhClass::kLeafBit, last = first + node.right;
+            if (mask == 0) {
+                for (uint32_t k = first; k < last; ++k) out[n++] = order[k];
+            } else {
+                const uint32_t m = gCull(P, b.cx, b.cy, b.cz, b.ex, b.ey, b.ez, first, last, out + n);
+                for (uint32_t k = n; k < n + m; ++k) out[k] = order[out[k]];
+                n += m;
+            }
+        } else {
+            stack[sp++] = {node.right, mask};
+            stack[sp++] = {node.left, mask};
+        }
+    }
+    return n;
+}
+} // namespace
+
+const char* cpuCullerClass::simdPath() { return gSimdName; }
+
+void cpuCullerClass::setInstances(const glm::mat4* mats, const uint32_t* instanceObject, size_t count,
+                                  const glm::vec4* objectAabbs, size_t objectCount, const instanceBvhClass* bvh) {
+    count_ = count;
+    instanceObject_.assign(instanceObject, instanceObject + count);
+    objCenter_.resize(objectCount);
+    objExtent_.resize(objectCount);
+    for (size_t o = 0; o < objectCount; ++o) {
+        const glm::vec3 lo(objectAabbs[2 * o]), hi(objectAabbs[2 * o + 1]);
+        objCenter_[o] = 0.5f * (lo + hi);
+        objExtent_[o] = 0.5f * (hi - lo);
+    }
+
+    // object ranges, then work items that never straddle two objects
+    objectStart_.assign(objectCount, uint32_t(count));
+    objectVisible_.assign(objectCount, 0);
+    chunks_.clear();
+    for (size_t i = 0; i < count;) {
+        const uint32_t o = instanceObject[i];
+        size_t end = i;
+        while (end < count && instanceObject[end] == o) ++end;
+        objectStart_[o] = uint32_t(i);
+        if (!bvh) {
+            for (size_t b = i; b < end; b += kChunk) {
+                chunks_.push_back({uint32_t(b), uint32_t(min(end, b + kChunk)), o, kNoRoot, 0});
+            }
+        }
+        i = end;
+    }
+    order_.clear();
+    nodes_.clear();
+    if (bvh) {
+        order_ = bvh->order();
+        nodes_ = bvh->nodes();
+        for (const auto& t : bvh->treelets()) chunks_.push_back({t.slotBegin, t.slotEnd, t.object, t.root, 0});
+    }
+    // empty objects start where the next non-empty one does (zero-length regions)
+    for (size_t o = objectCount; o-- > 1;) {
+        objectStart_[o - 1] = min(objectStart_[o - 1], objectStart_[o]);
+    }
+
+    for (vector<float>* v : {&cx_, &cy_, &cz_, &ex_, &ey_, &ez_}) v->resize(count);
+    scratch_.resize(count);
+    visible_.resize(count);
+    updateTransforms(mats);
+}
+
+void cpuCullerClass::updateTransforms(const glm::mat4* mats) {
+    parallelFor(count_, [&](size_t b, size_t e) { computeBounds_(mats, b, e); });
+}
+
+// same proxy as aabbInFrustum(): center through M, extent through |M3x3|; i is a slot
+// (= instance without a BVH)
+void cpuCullerClass::computeBounds_(const glm::mat4* mats, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        const size_t inst = order_.empty() ? i : order_[i];
+        const glm::mat4& M = mats[inst];
+        const glm::vec3 c = objCenter_[instanceObject_[inst]], h = objExtent_[instanceObject_[inst]];
+        const glm::vec3 w = glm::vec3(M * glm::vec4(c, 1.0f));
+        cx_[i] = w.x; cy_[i] = w.y; cz_[i] = w.z;
+        ex_[i] = fabs(M[0][0]) * h.x + fabs(M[1][0]) * h.y + fabs(M[2][0]) * h.z;
+        ey_[i] = fabs(M[0][1]) * h.x + fabs(M[1][1]) * h.y + fabs(M[2][1]) * h.z;
+        ez_[i] = fabs(M[0][2]) * h.x + fabs(M[1][2]) * h.y + fabs(M[2][2]) * h.z;
+    }
+}
+
+size_t cpuCullerClass::cull(const glm::vec4 planes[6], bool cullEnabled) {
+    Planes P;
+    for (int p = 0; p < 6; ++p) {
+        P.nx[p] = planes[p].x; P.ny[p] = planes[p].y; P.nz[p] = planes[p].z; P.d[p] = planes[p].w;
+        P.ax[p] = fabs(planes[p].x); P.ay[p] = fabs(planes[p].y); P.az[p] = fabs(planes[p].z);
+    }
+
+    // 1) each work item compacts its visible indices in place at chunk.begin
+    const Soa soa{cx_.data(), cy_.data(), cz_.data(), ex_.data(), ey_.data(), ez_.data()};
+    parallelFor(chunks_.size(), [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; ++k) {
+            Chunk& c = chunks_[k];
+            if (c.root != kNoRoot) {
+                c.visible = cullTreelet(P, soa, nodes_.data(), c.root, cullEnabled, order_.data(), scratch_.data() + c.begin);
+            } else if (!cullEnabled) {
+                for (uint32_t i = c.begin; i < c.end; ++i) scratch_[i] = i;
+                c.visible = c.end - c.begin;
+            } else {
+                c.visible = gCull(P, soa.cx, soa.cy, soa.cz, soa.ex, soa.ey, soa.ez, c.begin, c.end, scratch_.data() + c.begin);
+            }
+        }
+    }, 1);
+
+    // 2) per-object running offsets (chunks are in instance order)
+    fill(objectVisible_.begin(), objectVisible_.end(), 0u);
+    vector<uint32_t> dst(chunks_.size());
+    size_t total = 0;
+    for (size_t k = 0; k < chunks_.size(); ++k) {
+        const Chunk& c = chunks_[k];
+        dst[k] = objectStart_[c.object] + objectVisible_[c.object];
+        objectVisible_[c.object] += c.visible;
+        total += c.visible;
+    }
+
+    // 3) gather into the GPU layout
+    parallelFor(chunks_.size(), [&](size_t b, size_t e) {
+        for (size_t k = b; k < e; ++k) {
+            const Chunk& c = chunks_[k];
+            copy(scratch_.begin() + c.begin, scratch_.begin() + c.begin + c.visible, visible_.begin() + dst[k]);
+        }
+    }, 1);
+    return total;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "instanceBvhClass.hpp"
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// CPU version of the cull shader's frustum test: each instance's object-space AABB is
+// turned into a world-space center/extent proxy (|M3x3| * extent), stored SoA, and tested
+// against the 6 planes 8 (AVX2) or 4 (SSE) instances at a time across worker threads.
+// The visible list has the same layout as the GPU's visibleIndices: object o's indices
+// start at the first instance of o's range, in instance order.
+// With a BVH the proxies are stored in its slot order and each work item is a treelet:
+// rejected nodes skip their instances, nodes inside every plane emit them untested, so the
+// cost follows the visible set (indices then come out in Morton order per object).
+class cpuCullerClass {
+public:
+    // instances must be grouped by object (instanceObject non-decreasing);
+    // objectAabbs holds min, max (xyz) per object; bvh (optional) must be built from the
+    // same instances and is copied
+    void setInstances(const glm::mat4* mats, const uint32_t* instanceObject, size_t count,
+                      const glm::vec4* objectAabbs, size_t objectCount, const instanceBvhClass* bvh = nullptr);
+    // same instances, new transforms (animation)
+    void updateTransforms(const glm::mat4* mats);
+
+    // planes: n.xyz, d (inside when dot(n, p) + d >= 0); cullEnabled = false emits everything
+    size_t cull(const glm::vec4 planes[6], bool cullEnabled);
+
+    const vector<uint32_t>& visible() const { return visible_; }
+    uint32_t objectStart(size_t o) const { return objectStart_[o]; }
+    uint32_t objectVisible(size_t o) const { return objectVisible_[o]; }
+    size_t   objectCount() const { return objectStart_.size(); }
+    size_t   instanceCount() const { return count_; }
+
+    static const char* simdPath(); // "avx2", "sse" or "scalar"
+
+private:
+    struct Chunk {
+        uint32_t begin, end;   // instance (or BVH slot) range, never crosses an object boundary
+        uint32_t object;
+        uint32_t root;         // BVH treelet root, kNoRoot for a flat range
+        uint32_t visible;      // written by cull()
+    };
+    static constexpr uint32_t kNoRoot = 0xFFFFFFFFu;
+
+    void computeBounds_(const glm::mat4* mats, size_t begin, size_t end);
+
+    size_t count_ = 0;
+    vector<float> cx_, cy_, cz_, ex_, ey_, ez_;   // world-space proxy AABB, SoA (BVH slot order with a BVH)
+    vector<uint32_t> order_;                      // slot -> instance, empty without a BVH
+    vector<instanceBvhClass::Node> nodes_;
+    vector<uint32_t> instanceObject_;
+    vector<glm::vec3> objCenter_, objExtent_;     // object space
+    vector<Chunk> chunks_;
+    vector<uint32_t> scratch_;                    // per-chunk compacted lists at chunk.begin
+    vector<uint32_t> visible_;
+    vector<uint32_t> objectStart_, objectVisible_;
+};
@@ -0,0 +1,161 @@
+#include "frameStatsClass.hpp"
+#include "traceRecorderClass.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+using namespace std;
+
+frameStatsClass::~frameStatsClass() {
+    if (!queries_.empty()) glDeleteQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+}
+
+int frameStatsClass::addStage(const string& name) {
+    if (!queries_.empty()) {
+        cerr << "frameStatsClass: stage '" << name << "' added after the first frame, ignored\n";
+        return -1;
+    }
+    stageNames_.push_back(name);
+    return static_cast<int>(stageNames_.size()) - 1;
+}
+
+void frameStatsClass::setWindow(size_t frames) {
+    window_ = max<size_t>(frames, 1);
+    history_.clear();
+    historyHead_ = 0;
+}
+
+const frameStatsClass::FrameRecord& frameStatsClass::record(size_t i) const {
+    static const FrameRecord kEmpty;
+    if (i >= history_.size()) return kEmpty;
+    return history_[(historyHead_ + i) % history_.size()];
+}
+
+bool frameStatsClass::openCsv(const string& path) {
+    csv_.open(path, ios::trunc);
+    if (!csv_) { cerr << "frameStatsClass: cannot write " << path << "\n"; return false; }
+    csv_ << "frame";
+    for (const string& n : stageNames_) csv_ << "," << n << "_cpu_ms";
+    for (const string& n : stageNames_) csv_ << "," << n << "_gpu_ms";
+    csv_ << "\n";
+    return true;
+}
+
+void frameStatsClass::allocate_() {
+    queries_.resize(size_t(kLatency) * stageNames_.size() * 2);
+    if (!queries_.empty()) glGenQueries(static_cast<GLsizei>(queries_.size()), queries_.data());
+    for (Slot& s : slots_) {
+        s.issued.assign(stageNames_.size(), 0);
+        s.cpuMs.assign(stageNames_.size(), NAN);
+    }
+    cpuStart_.resize(stageNames_.size());
+    traceStartUs_.resize(stageNames_.size());
+}
+
+void frameStatsClass::beginFrame() {
+    if (queries_.empty() && !stageNames_.empty()) allocate_();
+    current_ = static_cast<int>(frame_ % kLatency);
+    Slot& slot = slots_[current_];
+    if (slot.pending) resolve_(slot, current_); // issued kLatency frames ago
+
+    slot.frame = frame_;
+    fill(slot.issued.begin(), slot.issued.end(), 0);
+    fill(slot.cpuMs.begin(), slot.cpuMs.end(), NAN);
+}
+
+void frameStatsClass::endFrame() {
+    if (current_ < 0) return;
+    slots_[current_].pending = true;
+    current_ = -1;
+    ++frame_;
+}
+
+void frameStatsClass::begin(int stage) {
+    if (current_ < 0 || stage < 0) return;
+    glQueryCounter(query_(current_, stage, 0), GL_TIMESTAMP);
+    cpuStart_[stage] = chrono::steady_clock::now();
+    if (traceRecorderClass::global().enabled()) traceStartUs_[stage] = traceRecorderClass::global().nowUs();
+}
+
+void frameStatsClass::end(int stage) {
+    if (current_ < 0 || stage < 0) return;
+    glQueryCounter(query_(current_, stage, 1), GL_TIMESTAMP);
+    Slot& slot = slots_[current_];
+    slot.issued[stage] = 1;
+    slot.cpuMs[stage] = chrono::duration<float, milli>(chrono::steady_clock::now() - cpuStart_[stage]).count();
+    traceRecorderClass& trace = traceRecorderClass::global();
+    if (trace.enabled()) trace.cpuEvent(stageNames_[stage], "frame", traceStartUs_[stage], trace.nowUs());
+}
+
+void frameStatsClass::flush() {
+    // oldest first so CSV rows stay in frame order
+    for (uint64_t f = frame_ >= kLatency ? frame_ - kLatency : 0; f < frame_; ++f) {
+        const int i = static_cast<int>(f % kLatency);
+        if (slots_[i].pending && slots_[i].frame == f) resolve_(slots_[i], i);
+    }
+}
+
+void frameStatsClass::resolve_(Slot& slot, int slotIndex) {
+    slot.pending = false;
+
+    FrameRecord rec;
+    rec.frame = slot.frame;
+    rec.cpuMs = slot.cpuMs;
+    rec.gpuMs.assign(stageNames_.size(), NAN);
+    for (size_t s = 0; s < stageNames_.size(); ++s) {
+        if (!slot.issued[s]) continue;
+        GLuint64 t0 = 0, t1 = 0; // blocks only if the GPU is more than kLatency frames behind
+        glGetQueryObjectui64v(query_(slotIndex, int(s), 0), GL_QUERY_RESULT, &t0);
+        glGetQueryObjectui64v(query_(slotIndex, int(s), 1), GL_QUERY_RESULT, &t1);
+        rec.gpuMs[s] = float(double(t1 - t0) * 1e-6);
+        traceRecorderClass::global().gpuEvent(stageNames_[s], t0, t1);
+    }
+
+    if (csv_) {
+        csv_ << rec.frame;
+        for (float v : rec.cpuMs) { csv_ << ","; if (!std::isnan(v)) csv_ << v; }
+        for (float v : rec.gpuMs) { csv_ << ","; if (!std::isnan(v)) csv_ << v; }
+        csv_ << "\n";
+    }
+
+    if (history_.size() < window_) {
+        history_.push_back(move(rec));
+    } else {
+        history_[historyHead_] = move(rec);
+        historyHead_ = (historyHead_ + 1) % window_;
+    }
+    ++resolved_;
+}
+
+void frameStatsClass::printSummary(ostream& os) const {
+    auto line = [&](const string& name, const char* kind, auto&& pick) {
+        vector<float> v;
+        v.reserve(history_.size());
+        for (const FrameRecord& r : history_) {
+            float x = pick(r);
+            if (!std::isnan(x)) v.push_back(x);
+        }
+        if (v.empty()) return;
+        sort(v.begin(), v.end());
+        double sum = 0.0; for (float x : v) sum += x;
+        os << "[stats] " << left << setw(10) << name << right << " " << kind << " ms: avg "
+           << fixed << setprecision(3) << sum / v.size()
+           << " min " << v.front() << " p50 " << v[v.size() / 2]
+           << " p95 " << v[min(v.size() - 1, v.size() * 95 / 100)] << " max " << v.back()
+           << defaultfloat << "\n";
+    };
+
+    os << "[stats] last " << history_.size() << " frames\n";
+    for (size_t s = 0; s < stageNames_.size(); ++s) {
+        line(stageNames_[s], "cpu", [s](const FrameRecord& r) { return r.cpuMs[s]; });
+        line(stageNames_[s], "gpu", [s](const FrameRecord& r) { return r.gpuMs[s]; });
+    }
+}
+
+bool frameStatsClass::printIfDue(ostream& os, double intervalSec) {
+    const auto now = chrono::steady_clock::now();
+    if (chrono::duration<double>(now - lastPrint_).count() < intervalSec) return false;
+    lastPrint_ = now;
+    printSummary(os);
+    return true;
+}
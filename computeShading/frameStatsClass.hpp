@@ -0,0 +1,92 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Per-stage frame timings: GPU via GL_TIMESTAMP query pairs, CPU via steady_clock.
+// Queries live in a small ring of frames so results are read kLatency frames later,
+// when they are (almost always) ready, instead of stalling the pipeline.
+// Resolved frames feed a rolling window (summary / percentiles), an optional CSV and,
+// when recording, the CPU/GPU tracks of traceRecorderClass.
+class frameStatsClass {
+public:
+    static constexpr int kLatency = 3; // frames in flight before a slot is read back
+
+    struct FrameRecord {
+        uint64_t      frame = 0;
+        vector<float> cpuMs;   // per stage, NaN if the stage did not run
+        vector<float> gpuMs;
+    };
+
+    // CPU + GPU timing of one stage for the enclosing scope (a stage runs at most once per frame)
+    class Scope {
+    public:
+        Scope(frameStatsClass& stats, int stage) : stats_(stats), stage_(stage) { stats_.begin(stage_); }
+        ~Scope() { stats_.end(stage_); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        frameStatsClass& stats_;
+        int stage_;
+    };
+
+    frameStatsClass() = default;
+    ~frameStatsClass();
+    frameStatsClass(const frameStatsClass&) = delete;
+    frameStatsClass& operator=(const frameStatsClass&) = delete;
+
+    // stages must be added before the first beginFrame()
+    int  addStage(const string& name);
+    void setWindow(size_t frames);           // rolling window size (default 240)
+    bool openCsv(const string& path);        // one row per resolved frame
+
+    void beginFrame();                       // resolves the slot about to be reused
+    void endFrame();
+    void begin(int stage);
+    void end(int stage);
+    void flush();                            // waits for and resolves every frame in flight
+
+    // rolling window, oldest first; out of range (or an empty window) gives an empty record
+    size_t             recordCount() const { return history_.size(); }
+    const FrameRecord& record(size_t i) const;
+    uint64_t           resolvedFrames() const { return resolved_; } // since construction, not reset by setWindow()
+
+    void printSummary(ostream& os) const;
+    bool printIfDue(ostream& os, double intervalSec); // true when it printed
+
+private:
+    struct Slot {
+        uint64_t      frame = 0;
+        bool          pending = false;
+        vector<char>  issued;                 // per stage: both queries recorded
+        vector<float> cpuMs;
+    };
+
+    void allocate_();
+    void resolve_(Slot& slot, int slotIndex);
+    GLuint query_(int slot, int stage, int edge) const {
+        return queries_[(size_t(slot) * stageNames_.size() + size_t(stage)) * 2 + size_t(edge)];
+    }
+
+    vector<string> stageNames_;
+    vector<GLuint> queries_;                  // [slot][stage][begin/end]
+    Slot           slots_[kLatency];
+    int            current_ = -1;             // slot of the frame being recorded
+    uint64_t       frame_   = 0;
+    vector<chrono::steady_clock::time_point> cpuStart_;
+    vector<double> traceStartUs_;             // same instant on the trace clock
+
+    vector<FrameRecord> history_;
+    size_t   historyHead_ = 0;
+    size_t   window_      = 240;
+    uint64_t resolved_    = 0;
+
+    ofstream csv_;
+    chrono::steady_clock::time_point lastPrint_ = chrono::steady_clock::now();
+};
@@ -0,0 +1,174 @@
+#include "instanceBvhClass.hpp"
+#include "mortonUtil.hpp"
+#include "parallelUtil.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+using namespace std;
+
+namespace {
+// Karras' delta: length of the common key prefix of leaves i and j (the index breaks
+// ties between equal keys), -1 when j is out of range
+inline int commonPrefix(const uint32_t* keys, int n, int i, int j) {
+    if (j < 0 || j >= n) return -1;
+    const uint32_t a = keys[i], b = keys[j];
+    return a != b ? __builtin_clz(a ^ b) : 32 + __builtin_clz(uint32_t(i) ^ uint32_t(j));
+}
+
+using Node = instanceBvhClass::Node;
+constexpr uint32_t kLeafSize = instanceBvhClass::kLeafSize;
+constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+
+// One object's tree over sorted slots [s, e). Local node indices: internal 0..L-2 (root 0),
+// leaves L-1..2L-2; a single-leaf tree is just the leaf, so the root is always local 0.
+void buildTree(const uint32_t* codes, const uint32_t* order, const glm::vec3* lo, const glm::vec3* hi,
+               uint32_t s, uint32_t e, uint32_t object, vector<Node>& nodes, vector<instanceBvhClass::Treelet>& treelets) {
+    const int L = int((e - s + kLeafSize - 1) / kLeafSize);
+    const uint32_t base = uint32_t(nodes.size());
+    const uint32_t leaf0 = uint32_t(L - 1);
+    nodes.resize(nodes.size() + size_t(2 * L - 1));
+    Node* tree = nodes.data() + base;
+
+    vector<uint32_t> keys(L);
+    for (int j = 0; j < L; ++j) keys[size_t(j)] = codes[s + uint32_t(j) * kLeafSize];
+    vector<uint32_t> parent(size_t(2 * L - 1), kNoParent);
+    vector<uint32_t> rangeFirst(size_t(L - 1)), rangeLast(size_t(L - 1)); // leaves under internal i
+
+    // leaves: bounds of their instances
+    parallelFor(size_t(L), [&](size_t b, size_t end) {
+        for (size_t j = b; j < end; ++j) {
+            Node& n = tree[leaf0 + j];
+            const uint32_t first = s + uint32_t(j) * kLeafSize, last = min(e, first + kLeafSize);
+            n.left = instanceBvhClass::kLeafBit | first;
+            n.right = last - first;
+            n.bmin = glm::vec3(FLT_MAX);
+            n.bmax = glm::vec3(-FLT_MAX);
+            for (uint32_t k = first; k < last; ++k) {
+                n.bmin = glm::min(n.bmin, lo[order[k]]);
+                n.bmax = glm::max(n.bmax, hi[order[k]]);
+            }
+        }
+    }, 64);
+
+    // internal nodes: each one finds its leaf range and split on its own
+    parallelFor(size_t(L - 1), [&](size_t b, size_t end) {
+        for (int i = int(b); i < int(end); ++i) {
+            const int d = commonPrefix(keys.data(), L, i, i + 1) > commonPrefix(keys.data(), L, i, i - 1) ? 1 : -1;
+            const int dMin = commonPrefix(keys.data(), L, i, i - d);
+            int lMax = 2;
+            while (commonPrefix(keys.data(), L, i, i + lMax * d) > dMin) lMax *= 2;
+            int l = 0;
+            for (int t = lMax / 2; t >= 1; t /= 2) {
+                if (commonPrefix(keys.data(), L, i, i + (l + t) * d) > dMin) l += t;
+            }
+            const int j = i + l * d;
+            const int dNode = commonPrefix(keys.data(), L, i, j);
+            int split = 0, t = l;
+            do {
+                t = (t + 1) / 2;
+                if (commonPrefix(keys.data(), L, i, i + (split + t) * d) > dNode) split += t;
+            } while (t > 1);
+            const int gamma = i + split * d + min(d, 0);
+
+            const int first = min(i, j), last = max(i, j);
+            const uint32_t left  = first == gamma     ? leaf0 + uint32_t(gamma)     : uint32_t(gamma);
+            const uint32_t right = last  == gamma + 1 ? leaf0 + uint32_t(gamma + 1) : uint32_t(gamma + 1);
+            tree[i].left  = base + left;
+            tree[i].right = base + right;
+            parent[left] = parent[right] = uint32_t(i);
+            rangeFirst[size_t(i)] = uint32_t(first);
+            rangeLast[size_t(i)]  = uint32_t(last);
+        }
+    }, 1024);
+
+    // bounds bottom-up: the second child to arrive at a node merges both and moves on
+    vector<atomic<uint32_t>> visits(size_t(L - 1));
+    for (auto& v : visits) v.store(0, memory_order_relaxed);
+    parallelFor(size_t(L), [&](size_t b, size_t end) {
+        for (size_t j = b; j < end; ++j) {
+            for (uint32_t cur = leaf0 + uint32_t(j); parent[cur] != kNoParent;) {
+                const uint32_t p = parent[cur];
+                if (visits[p].fetch_add(1, memory_order_acq_rel) == 0) break;
+                Node& n = tree[p];
+                n.bmin = glm::min(nodes[n.left].bmin, nodes[n.right].bmin);
+                n.bmax = glm::max(nodes[n.left].bmax, nodes[n.right].bmax);
+                cur = p;
+            }
+        }
+    }, 256);
+
+    // treelets: the highest subtrees with at most kTreeletLeaves leaves, left to right
+    vector<uint32_t> stack{0};
+    while (!stack.empty()) {
+        const uint32_t local = stack.back();
+        stack.pop_back();
+        const bool isLeaf = local >= leaf0;
+        const uint32_t first = isLeaf ? local - leaf0 : rangeFirst[local];
+        const uint32_t last  = isLeaf ? local - leaf0 : rangeLast[local];
+        if (last - first + 1 <= instanceBvhClass::kTreeletLeaves) {
+            treelets.push_back({base + local, s + first * kLeafSize, min(e, s + (last + 1) * kLeafSize), object});
+        } else {
+            stack.push_back(tree[local].right - base);
+            stack.push_back(tree[local].left - base);
+        }
+    }
+}
+} // namespace
+
+void instanceBvhClass::build(const glm::mat4* mats, const uint32_t* instanceObject, size_t count,
+                             const glm::vec4* objectAabbs) {
+    const auto t0 = chrono::steady_clock::now();
+    nodes_.clear();
+    treelets_.clear();
+    leafCount_ = 0;
+    order_.resize(count);
+
+    // world AABB per instance, the cull shader's center / |M3x3| * extent proxy
+    vector<glm::vec3> lo(count), hi(count);
+    glm::vec3 sceneLo(FLT_MAX), sceneHi(-FLT_MAX);
+    mutex boundsMutex;
+    parallelFor(count, [&](size_t b, size_t e) {
+        glm::vec3 cLo(FLT_MAX), cHi(-FLT_MAX);
+        for (size_t i = b; i < e; ++i) {
+            const glm::mat4& M = mats[i];
+            const glm::vec3 bMin(objectAabbs[2 * instanceObject[i]]), bMax(objectAabbs[2 * instanceObject[i] + 1]);
+            const glm::vec3 c = 0.5f * (bMin + bMax), h = 0.5f * (bMax - bMin);
+            const glm::vec3 w(M * glm::vec4(c, 1.0f));
+            const glm::vec3 ext(fabs(M[0][0]) * h.x + fabs(M[1][0]) * h.y + fabs(M[2][0]) * h.z,
+                                fabs(M[0][1]) * h.x + fabs(M[1][1]) * h.y + fabs(M[2][1]) * h.z,
+                                fabs(M[0][2]) * h.x + fabs(M[1][2]) * h.y + fabs(M[2][2]) * h.z);
+            lo[i] = w - ext;
+            hi[i] = w + ext;
+            cLo = glm::min(cLo, w);
+            cHi = glm::max(cHi, w);
+        }
+        lock_guard<mutex> lock(boundsMutex);
+        sceneLo = glm::min(sceneLo, cLo);
+        sceneHi = glm::max(sceneHi, cHi);
+    });
+
+    vector<uint32_t> codes(count);
+    const glm::vec3 invSize = mortonInvSize(sceneLo, sceneHi);
+    parallelFor(count, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            codes[i] = morton3D(0.5f * (lo[i] + hi[i]), sceneLo, invSize);
+            order_[i] = uint32_t(i);
+        }
+    });
+
+    // one tree per object range; sorting within the range keeps the regions in place
+    for (size_t s = 0; s < count;) {
+        const uint32_t object = instanceObject[s];
+        size_t e = s;
+        while (e < count && instanceObject[e] == object) ++e;
+        radixSortPairs(codes.data() + s, order_.data() + s, e - s, 30);
+        buildTree(codes.data(), order_.data(), lo.data(), hi.data(), uint32_t(s), uint32_t(e), object, nodes_, treelets_);
+        leafCount_ += (e - s + kLeafSize - 1) / kLeafSize;
+        s = e;
+    }
+    buildMs_ = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Static linear BVH (Karras 2012) over instance world AABBs, one tree per object so the
+// object's visibleIndices region stays contiguous. Each object's instances are sorted by
+// the Morton code of their center and cut into leaves of kLeafSize consecutive "slots";
+// the internal nodes are built over the leaves in parallel, bounds are propagated
+// bottom-up with one atomic per node.
+// Trees are traversed from "treelets": subtrees of at most kTreeletLeaves leaves that
+// cover a contiguous slot range, one GPU thread / CPU work item each.
+class instanceBvhClass {
+public:
+    static constexpr uint32_t kLeafSize      = 128;  // = cull CS workgroup size (one group per leaf)
+    static constexpr uint32_t kTreeletLeaves = 32;   // bounds the traversal stack depth
+    static constexpr uint32_t kLeafBit       = 0x80000000u;
+
+    // std430 {vec3 bmin; uint left; vec3 bmax; uint right;}
+    struct Node {
+        glm::vec3 bmin; uint32_t left;    // internal: left child node; leaf: kLeafBit | first slot
+        glm::vec3 bmax; uint32_t right;   // internal: right child node; leaf: instance count
+    };
+    struct Treelet {
+        uint32_t root;
+        uint32_t slotBegin, slotEnd;      // every slot under root
+        uint32_t object;
+    };
+
+    // instances grouped by object; objectAabbs holds min, max (xyz) per object
+    void build(const glm::mat4* mats, const uint32_t* instanceObject, size_t count, const glm::vec4* objectAabbs);
+
+    const vector<Node>&     nodes() const    { return nodes_; }
+    const vector<uint32_t>& order() const    { return order_; }    // slot -> instance index
+    const vector<Treelet>&  treelets() const { return treelets_; }
+    size_t leafCount() const { return leafCount_; }
+    bool   empty() const     { return nodes_.empty(); }
+    double buildMs() const   { return buildMs_; }
+
+private:
+    vector<Node>     nodes_;
+    vector<uint32_t> order_;
+    vector<Treelet>  treelets_;
+    size_t leafCount_ = 0;
+    double buildMs_ = 0.0;
+};
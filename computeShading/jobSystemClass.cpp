@@ -0,0 +1,162 @@
+#include "jobSystemClass.hpp"
+
+#include <algorithm>
+using namespace std;
+
+namespace {
+// which system / worker the current thread belongs to
+thread_local const jobSystemClass* tlsSystem = nullptr;
+thread_local int tlsIndex = -1;
+// inside a background job (or something it spawned)
+thread_local bool tlsInBackground = false;
+
+struct BackgroundScope {
+    bool prev;
+    explicit BackgroundScope(bool on) : prev(tlsInBackground) { tlsInBackground = on; }
+    ~BackgroundScope() { tlsInBackground = prev; }
+};
+} // namespace
+
+jobSystemClass& jobSystemClass::global() {
+    static jobSystemClass jobs(max(thread::hardware_concurrency(), 1u) - 1);
+    return jobs;
+}
+
+jobSystemClass::jobSystemClass(unsigned workers) : backgroundLimit_(max(workers / 2, 1u)) {
+    for (unsigned i = 0; i < workers; ++i) local_.push_back(make_unique<Queue>());
+    for (unsigned i = 0; i < workers; ++i) threads_.emplace_back([this, i] { workerLoop_(i); });
+}
+
+jobSystemClass::~jobSystemClass() {
+    {
+        lock_guard<mutex> lock(sleepMutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& t : threads_) t.join();
+}
+
+int jobSystemClass::selfIndex_() const {
+    return tlsSystem == this ? tlsIndex : -1;
+}
+
+void jobSystemClass::push_(Queue& q, Job job) {
+    {
+        lock_guard<mutex> lock(q.m);
+        q.jobs.push_back(move(job));
+    }
+    (&q == &background_ ? bgQueued_ : fgQueued_).fetch_add(1);
+    { lock_guard<mutex> lock(sleepMutex_); } // a worker between its check and its wait sees the count
+    wake_.notify_one();
+}
+
+void jobSystemClass::submit(function<void()> job, Counter* counter) {
+    if (counter) counter->pending.fetch_add(1);
+    const int self = selfIndex_();
+    push_(self >= 0 ? *local_[size_t(self)] : inject_, Job{move(job), counter, tlsInBackground});
+}
+
+void jobSystemClass::submitBackground(function<void()> job, Counter* counter) {
+    if (threads_.empty()) { // single core: nobody else would ever run it
+        BackgroundScope scope(true);
+        job();
+        return;
+    }
+    if (counter) counter->pending.fetch_add(1);
+    push_(background_, Job{move(job), counter, true});
+}
+
+// newest: the owner's LIFO end; otherwise the oldest eligible job (injection / stealing)
+bool jobSystemClass::pop_(Queue& q, Job& out, bool newest, bool allowBackground) {
+    lock_guard<mutex> lock(q.m);
+    const size_t n = q.jobs.size();
+    for (size_t k = 0; k < n; ++k) {
+        const size_t i = newest ? n - 1 - k : k;
+        if (q.jobs[i].background && !allowBackground) continue;
+        out = move(q.jobs[i]);
+        q.jobs.erase(q.jobs.begin() + ptrdiff_t(i));
+        return true;
+    }
+    return false;
+}
+
+bool jobSystemClass::tryRun_(int self, bool idle) {
+    // a wait outside background work must not pick up any of it: it would block its caller
+    const bool allowBackground = idle || tlsInBackground;
+    Job job;
+    bool got = self >= 0 && pop_(*local_[size_t(self)], job, true, allowBackground);
+    if (!got) got = pop_(inject_, job, false, allowBackground);
+    const size_t n = local_.size();
+    for (size_t k = 1; !got && k <= n; ++k) {
+        const size_t victim = (size_t(max(self, 0)) + k) % n;
+        if (int(victim) != self) got = pop_(*local_[victim], job, false, allowBackground);
+    }
+    if (got) {
+        fgQueued_.fetch_sub(1);
+    } else {
+        if (!idle || backgroundRunning_.fetch_add(1) >= backgroundLimit_ || !pop_(background_, job, false, true)) {
+            if (idle) backgroundRunning_.fetch_sub(1);
+            return false;
+        }
+        bgQueued_.fetch_sub(1);
+    }
+
+    {
+        BackgroundScope scope(job.background);
+        job.fn();
+    }
+    if (job.counter) job.counter->pending.fetch_sub(1, memory_order_release);
+    if (!got) {
+        backgroundRunning_.fetch_sub(1);
+        { lock_guard<mutex> lock(sleepMutex_); }
+        wake_.notify_one(); // a slot opened for the next background job
+    }
+    return true;
+}
+
+void jobSystemClass::wait(Counter& counter) {
+    const int self = selfIndex_();
+    while (counter.pending.load(memory_order_acquire) > 0) {
+        if (!tryRun_(self, false)) this_thread::yield();
+    }
+}
+
+void jobSystemClass::workerLoop_(unsigned index) {
+    tlsSystem = this;
+    tlsIndex  = int(index);
+    while (!stop_) {
+        if (tryRun_(int(index), true)) continue;
+        unique_lock<mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] {
+            return stop_ || fgQueued_ > 0 || (bgQueued_ > 0 && backgroundRunning_ < backgroundLimit_);
+        });
+    }
+}
+
+jobSystemClass::Graph::Node jobSystemClass::Graph::add(function<void()> fn, initializer_list<Node> deps) {
+    const Node id = nodes_.size();
+    nodes_.emplace_back();
+    nodes_.back().fn   = move(fn);
+    nodes_.back().deps = deps.size();
+    for (Node d : deps) nodes_[d].next.push_back(id);
+    return id;
+}
+
+// a node submits its successors before its own job completes, so `done` only drains at the end
+void jobSystemClass::Graph::schedule_(jobSystemClass& jobs, Node n, Counter& done) {
+    jobs.submit([this, &jobs, n, &done] {
+        nodes_[n].fn();
+        for (Node s : nodes_[n].next) {
+            if (nodes_[s].waiting.fetch_sub(1) == 1) schedule_(jobs, s, done);
+        }
+    }, &done);
+}
+
+void jobSystemClass::Graph::run(jobSystemClass& jobs) {
+    Counter done;
+    for (Entry& e : nodes_) e.waiting = e.deps;
+    for (Node n = 0; n < nodes_.size(); ++n) {
+        if (nodes_[n].deps == 0) schedule_(jobs, n, done);
+    }
+    jobs.wait(done);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+using namespace std;
+
+// Work-stealing job system behind parallelFor() and the load pipeline. Each worker owns a
+// deque: it pops its newest job (LIFO, cache-warm) and steals the oldest one of another
+// worker (FIFO, the biggest remaining pieces). Threads outside the pool submit through a
+// shared injection queue. wait() runs jobs until its counter drains, so jobs may nest
+// parallelFor / graphs without deadlocking and the waiting thread is never idle.
+// Background jobs (long ones, e.g. async mesh loads) sit in their own queue: only idle
+// workers take them, at most half the pool at a time. Jobs submitted from inside one are
+// background work too: they go through the normal deques, but only idle workers and waits
+// that are themselves inside background work run them, so a frame's parallelFor on the
+// render thread can not end up inside a mesh import.
+class jobSystemClass {
+public:
+    // unfinished jobs submitted with this counter
+    struct Counter { atomic<size_t> pending{0}; };
+
+    static jobSystemClass& global(); // workerCount() - 1 workers: the submitting thread helps in wait()
+    explicit jobSystemClass(unsigned workers);
+    ~jobSystemClass();               // queued jobs are dropped, running ones finish
+    jobSystemClass(const jobSystemClass&) = delete;
+    jobSystemClass& operator=(const jobSystemClass&) = delete;
+
+    void submit(function<void()> job, Counter* counter = nullptr);
+    void submitBackground(function<void()> job, Counter* counter = nullptr);
+    void wait(Counter& counter);
+    unsigned workers() const { return unsigned(threads_.size()); }
+
+    // Dependency graph: add() nodes (each after the listed earlier ones), then run() executes
+    // every node once all of its dependencies finished; independent nodes run concurrently.
+    class Graph {
+    public:
+        using Node = size_t;
+        Node add(function<void()> fn, initializer_list<Node> deps = {});
+        void run(jobSystemClass& jobs = jobSystemClass::global()); // returns when every node ran
+    private:
+        struct Entry {
+            function<void()> fn;
+            vector<Node> next;
+            size_t deps = 0;
+            atomic<size_t> waiting{0};
+        };
+        void schedule_(jobSystemClass& jobs, Node n, Counter& done);
+        deque<Entry> nodes_; // stable addresses for the atomics
+    };
+
+private:
+    struct Job {
+        function<void()> fn;
+        Counter* counter;
+        bool background;                         // submitted from within a background job
+    };
+    struct Queue {
+        mutex m;
+        deque<Job> jobs;
+    };
+
+    int  selfIndex_() const;                     // worker index on this system's threads, else -1
+    void push_(Queue& q, Job job);
+    bool tryRun_(int self, bool idle);           // idle: worker loop, may take any job
+    bool pop_(Queue& q, Job& out, bool newest, bool allowBackground);
+    void workerLoop_(unsigned index);
+
+    vector<unique_ptr<Queue>> local_;            // one per worker
+    Queue inject_;                               // from threads outside the pool
+    Queue background_;
+    vector<thread> threads_;
+    mutex sleepMutex_;
+    condition_variable wake_;
+    atomic<size_t> fgQueued_{0};                 // queued jobs, for sleeping workers
+    atomic<size_t> bgQueued_{0};
+    atomic<unsigned> backgroundRunning_{0};
+    unsigned backgroundLimit_ = 1;
+    atomic<bool> stop_{false};
+};
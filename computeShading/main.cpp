@@ -1,4 +1,5 @@
 // main.cpp
+#include <cmath>
 #include <cstdlib>
 #include <iostream>
 #include <memory>
@@ -10,6 +11,9 @@
 
 #include "sceneBuilderClass.hpp"
 #include "modelClass.hpp"
+#include "traceRecorderClass.hpp"
+#include "parallelUtil.hpp"
+#include "programCacheClass.hpp"
 
 using std::string;
 using std::vector;
@@ -17,46 +21,237 @@ using std::shared_ptr;
 using std::make_shared;
 
 int main(int argc, char** argv) {
-    if (argc < 3) {
+    // usage: computeShading <mesh> [<mesh> ...] <num_instances_per_mesh> [--flags]
+    //   --bench-load     time Assimp vs the native STL reader vs the mesh cache, then exit
+    //   --bench-instances=N  time instance generation (old serial vs parallel Philox), then exit
+    //   --no-mesh-cache  always import, never read or write <mesh>.meshcache
+    //   --no-mesh-opt    keep the loader's index / vertex order (no cache, overdraw or fetch reordering)
+    //   --async-load     load the first mesh up front, the others on worker threads while rendering
+    //   --no-short-indices  32-bit indices for every mesh (default: 16-bit for meshes under 64K vertices)
+    //   --no-shader-cache  compile every program, never read or write .shadercache/*.glprog
+    //   --quantized      12-byte vertices (unorm16 positions, octahedral normals) instead of 24
+    //   --headless       no visible window (EGL on GLFW's null platform without a display)
+    //   --frames=N       render N frames on a scripted orbit, print CPU/GPU timings and exit
+    //                    (--headless alone implies --frames=300)
+    //   --stats-csv=F    write per-frame, per-stage CPU/GPU ms to F
+    //   --trace=F        record a Chrome trace (chrome://tracing, ui.perfetto.dev) to F on exit
+    //   --animate        spin every instance, streaming transforms through a persistent-mapped ring
+    //   --inverse-normals  per-vertex inverse(model) instead of precomputed normal matrices (A/B timing)
+    //   --packed-instances  28-byte translate/rotate/scale per instance instead of a 64-byte mat4
+    //   --layout=L       grid (default), box, sphere, poisson, spiral or clustered
+    //   --bench-layouts  run the --frames benchmark once per layout (visible/total, cull ms)
+    //   --occlusion      start with Hi-Z occlusion culling on (otherwise toggle with 'O')
+    //   --cpu-cull       frustum-cull on the CPU (SIMD, all cores) instead of the cull CS ('G' toggles)
+    //   --bvh            hierarchical culling over a per-object instance BVH (static scenes, 'B' toggles)
+    //   --atomic-cull    append visible indices with atomics instead of the ordered prefix-sum compaction
+    //   --bench-compaction  run the --frames benchmark with atomic appends, then ordered compaction
+    //   --morton         store each object's instances in Morton order (memory coherence)
+    //   --bench-morton   run the --frames benchmark in generation order, then in Morton order
+    //   --bench-cull     run the --frames benchmark for GPU / CPU culling, flat and with the BVH
+    //   --no-lod         no simplified LODs: every instance draws the full mesh
+    //   --lod-error=PX   screen-space error (pixels) a LOD may introduce before a finer one is drawn (1)
+    //   --bench-lod      run the --frames benchmark with LOD 0 only, then with LOD selection
+    //   --no-meshlets    do not split high-poly meshes into meshlets
+    //   --meshlet-px=N   screen radius (pixels) from which an instance is culled per meshlet (100, 0 = off)
+    //   --bench-meshlets run the --frames benchmark drawing whole meshes, then with meshlet culling
+    vector<string> args;
+    string statsCsv;
+    bool animate = false;
+    bool inverseNormals = false;
+    bool packedInstances = false;
+    bool benchLayouts = false;
+    bool occlusion = false;
+    bool cpuCull = false;
+    bool benchCull = false;
+    bool bvh = false;
+    bool morton = false;
+    bool atomicCull = false;
+    bool benchCompaction = false;
+    bool benchMorton = false;
+    bool benchLod = false;
+    float lodError = 1.0f;
+    bool benchMeshlets = false;
+    bool asyncLoad = false;
+    float meshletPx = 100.0f;
+    string layout = "grid";
+    bool benchLoad = false;
+    bool headless = false;
+    int  benchFrames = 0;
+    VertexFormat vertexFormat = VertexFormat::Float;
+    for (int i = 1; i < argc; ++i) {
+        string a = argv[i];
+        if (a == "--bench-load") benchLoad = true;
+        else if (a.rfind("--bench-instances=", 0) == 0) {
+            sceneBuilderClass::benchmarkInstanceGeneration(std::strtoull(a.c_str() + 18, nullptr, 10));
+            return EXIT_SUCCESS;
+        }
+        else if (a == "--quantized") vertexFormat = VertexFormat::Quantized;
+        else if (a == "--headless") headless = true;
+        else if (a == "--animate") animate = true;
+        else if (a == "--inverse-normals") inverseNormals = true;
+        else if (a == "--packed-instances") packedInstances = true;
+        else if (a == "--bench-layouts") benchLayouts = true;
+        else if (a == "--occlusion") occlusion = true;
+        else if (a == "--cpu-cull") cpuCull = true;
+        else if (a == "--bench-cull") benchCull = true;
+        else if (a == "--bvh") bvh = true;
+        else if (a == "--morton") morton = true;
+        else if (a == "--atomic-cull") atomicCull = true;
+        else if (a == "--bench-compaction") benchCompaction = true;
+        else if (a == "--bench-morton") benchMorton = true;
+        else if (a == "--no-lod") ModelObject::setLodEnabled(false);
+        else if (a.rfind("--lod-error=", 0) == 0) lodError = std::strtof(a.c_str() + 12, nullptr);
+        else if (a == "--bench-lod") benchLod = true;
+        else if (a == "--no-meshlets") ModelObject::setMeshletsEnabled(false);
+        else if (a.rfind("--meshlet-px=", 0) == 0) meshletPx = std::strtof(a.c_str() + 13, nullptr);
+        else if (a == "--bench-meshlets") benchMeshlets = true;
+        else if (a.rfind("--layout=", 0) == 0) layout = a.substr(9);
+        else if (a.rfind("--frames=", 0) == 0) benchFrames = std::atoi(a.c_str() + 9);
+        else if (a.rfind("--stats-csv=", 0) == 0) statsCsv = a.substr(12);
+        else if (a.rfind("--trace=", 0) == 0) traceRecorderClass::global().start(a.substr(8));
+        else if (a == "--no-mesh-cache") ModelObject::setMeshCacheEnabled(false);
+        else if (a == "--no-mesh-opt") ModelObject::setMeshOptimizeEnabled(false);
+        else if (a == "--async-load") asyncLoad = true;
+        else if (a == "--no-short-indices") ModelObject::setShortIndicesEnabled(false);
+        else if (a == "--no-shader-cache") programCacheClass::setDiskCacheEnabled(false);
+        else args.push_back(a);
+    }
+
+    if (benchLoad) {
+        for (const string& path : args) {
+            if (path.find_first_not_of("0123456789") == string::npos) continue; // instance count
+            ModelObject::benchmarkLoad(path);
+        }
+        return EXIT_SUCCESS;
+    }
+
+    if (args.size() < 2) {
         return EXIT_FAILURE;
     }
 
-    const string stlPath = argv[1];
-    const long long numInstancesLL = std::atoll(argv[2]);
+    vector<string> meshPaths(args.begin(), args.end() - 1);
+    const long long numInstancesLL = std::atoll(args.back().c_str());
     if (numInstancesLL <= 0) {
         return EXIT_FAILURE;
     }
     const std::size_t numInstances = static_cast<std::size_t>(numInstancesLL);
 
-    sceneBuilderClass scene;
+    if ((headless || benchLayouts || benchCull || benchMorton || benchCompaction || benchLod || benchMeshlets) && benchFrames <= 0) benchFrames = 300;
+    sceneBuilderClass scene(headless);
+    if (!statsCsv.empty()) scene.setStatsCsv(statsCsv);
+    if (inverseNormals) scene.setPrecomputedNormals(false);
+    if (packedInstances) scene.setPackedInstances(true);
+    if (occlusion) scene.setOcclusionCulling(true);
+    if (cpuCull) scene.setCpuCulling(true);
+    if (bvh) scene.setHierarchicalCulling(true);
+    if (morton) scene.setMortonOrder(true);
+    if (atomicCull) scene.setOrderedCompaction(false);
+    scene.setLodPixelError(lodError);
+    scene.setMeshletCulling(meshletPx);
 
-    shared_ptr<ModelObject> model = make_shared<ModelObject>(stlPath);
-
-    scene.addObject(model);
-
-    //see if needed
-    scene.setModelBounds(glm::vec3(-0.5f), glm::vec3(0.5f)); // fallback; replace with real bounds if available
+    // --async-load: only the first mesh is loaded up front, the rest stream in while rendering
+    vector<shared_ptr<ModelObject>> models;
+    for (const string& path : meshPaths) {
+        if (asyncLoad && !models.empty()) break;
+        models.push_back(make_shared<ModelObject>(path, vertexFormat));
+        scene.addObject(models.back());
+    }
 
-    std::string layout = "grid";   // Make sure this string matches your logic
     float spacing = 100.0f;         // Big spacing to visually confirm culling
+    // the other layouts cover roughly the grid's footprint
+    const std::size_t total = numInstances * meshPaths.size();
+    const float extent = 0.5f * spacing * std::cbrt(float(total));
 
-    vector<glm::mat4> mats = scene.makeInstanceTransforms(
-        numInstances,
-        layout,
-        spacing,
-        25.0f,
-        glm::vec3(-20.0f),
-        glm::vec3( 20.0f)
-    );
+    // One shared layout, dealt round-robin so different meshes end up interleaved
+    auto placeInstances = [&](const string& name) {
+        vector<glm::mat4> mats = sceneBuilderClass::makeInstanceTransforms(
+            total, name, spacing, extent, glm::vec3(-extent), glm::vec3(extent));
 
+        // Upload instances to the scene (compute shader will cull them each frame);
+        // meshes still loading keep the share they were requested with
+        for (std::size_t m = 0; m < models.size(); ++m) {
+            vector<glm::mat4> mine;
+            mine.reserve(numInstances);
+            for (std::size_t i = m; i < mats.size(); i += meshPaths.size()) mine.push_back(mats[i]);
+            scene.setInstanceTransforms(models[m], mine);
+        }
+        return mats;
+    };
+    {
+        const vector<glm::mat4> mats = placeInstances(layout);
+        for (std::size_t m = models.size(); m < meshPaths.size(); ++m) {
+            vector<glm::mat4> mine;
+            mine.reserve(numInstances);
+            for (std::size_t i = m; i < mats.size(); i += meshPaths.size()) mine.push_back(mats[i]);
+            scene.addObjectAsync(meshPaths[m], vertexFormat, move(mine));
+        }
+    }
 
-    // Upload instances to the scene (compute shader will cull them each frame)
-    scene.setInstanceTransforms(mats);
+    if (animate) {
+        // each instance spins about its own Y axis at one of a few speeds
+        scene.setInstanceAnimator([](double t, const glm::mat4* base, glm::mat4* dst, std::size_t count) {
+            parallelFor(count, [&](std::size_t b, std::size_t e) {
+                for (std::size_t i = b; i < e; ++i) {
+                    const float speed = 0.5f + 0.25f * float(i % 7);
+                    dst[i] = glm::rotate(base[i], float(t) * speed, glm::vec3(0.0f, 1.0f, 0.0f));
+                }
+            });
+        });
+    }
 
     // Sensible camera defaults for this scene scale (aspect will update on resize)
     scene.setCamera(60.0f, 1280.0f/720.0f, 0.05f, 2000.0f);
 
-    scene.run();
+    if (benchLayouts) {
+        for (const char* name : {"grid", "box", "sphere", "poisson", "spiral", "clustered"}) {
+            std::cout << "[bench] layout " << name << "\n";
+            placeInstances(name);
+            scene.runBenchmark(benchFrames);
+        }
+    }
+    else if (benchCompaction) {
+        for (bool ordered : {false, true}) {
+            std::cout << "[bench] visible list via " << (ordered ? "ordered prefix-sum compaction" : "atomic append") << "\n";
+            scene.setOrderedCompaction(ordered);
+            scene.runBenchmark(benchFrames);
+        }
+    }
+    else if (benchMorton) {
+        for (bool sorted : {false, true}) {
+            std::cout << "[bench] instances in " << (sorted ? "morton" : "generation") << " order\n";
+            if (!sorted) placeInstances(layout); // setMortonOrder() reorders in place
+            scene.setMortonOrder(sorted);
+            scene.runBenchmark(benchFrames);
+        }
+    }
+    else if (benchLod) {
+        for (bool lods : {false, true}) {
+            std::cout << "[bench] " << (lods ? "lod selection" : "lod 0 only") << "\n";
+            scene.setLodPixelError(lods ? lodError : 0.0f);
+            scene.runBenchmark(benchFrames);
+        }
+    }
+    else if (benchMeshlets) {
+        for (bool meshlets : {false, true}) {
+            std::cout << "[bench] " << (meshlets ? "meshlet culling" : "whole meshes") << "\n";
+            scene.setMeshletCulling(meshlets ? meshletPx : 0.0f);
+            scene.runBenchmark(benchFrames);
+        }
+    }
+    else if (benchCull) {
+        for (bool hierarchical : {false, true}) {
+            for (bool cpu : {false, true}) {
+                std::cout << "[bench] culling on the " << (cpu ? "cpu" : "gpu") << (hierarchical ? ", bvh" : ", flat") << "\n";
+                scene.setCpuCulling(cpu);
+                scene.setHierarchicalCulling(hierarchical);
+                scene.runBenchmark(benchFrames);
+            }
+        }
+    }
+    else if (benchFrames > 0) scene.runBenchmark(benchFrames);
+    else scene.run();
+
+    traceRecorderClass::global().stop();
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,38 @@
+#pragma once
+#include "mappedFileClass.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <memory>
+#include <string>
+using namespace std;
+
+// Preprocessed mesh stored next to the source as "<mesh>.meshcache".
+// Layout: header, section table, then 64-byte aligned sections that can be handed to
+// glBufferSubData straight from the mapping. Keyed by a hash of the source file and the
+// import pipeline key; anything else (old version, edited mesh, other flags) is a miss.
+class meshCacheClass {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    // what a loaded mesh looks like, whether it points into vectors or into a mapping
+    struct MeshView {
+        const float*    vertices    = nullptr; // pos(3) + normal(3)
+        size_t          vertexCount = 0;
+        const unsigned* indices     = nullptr;
+        size_t          indexCount  = 0;
+        glm::vec3       bboxMin{0.0f}, bboxMax{0.0f};
+    };
+
+    static string   cachePathFor(const string& meshPath);
+    static uint64_t hashFile(const string& path);
+
+    // maps the cache and fills `out` if it matches; returns null on any mismatch
+    static unique_ptr<mappedFileClass> open(const string& cachePath, uint64_t sourceHash,
+                                            uint32_t importKey, MeshView& out);
+    // writes to a temp file and renames it into place; false if the directory is read-only
+    static bool write(const string& cachePath, uint64_t sourceHash, uint32_t importKey,
+                      const MeshView& mesh);
+
+private:
+    enum SectionId : uint32_t { kVertices = 1, kIndices = 2 };
+};
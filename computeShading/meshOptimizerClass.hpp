@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Load-time mesh optimisation, run in this order on an indexed triangle list:
+//  1. optimizeVertexCache: Forsyth's linear-speed reorder for the post-transform cache
+//     (LRU-scored, so it holds up for any real FIFO size).
+//  2. optimizeOverdraw: Sander et al. - cut the cache-ordered list into clusters where a
+//     fresh start costs little ACMR, then draw clusters facing away from the mesh centre
+//     first (they tend to occlude the rest). Triangle order inside a cluster is kept.
+//  3. optimizeVertexFetch: renumber vertices in first-use order so vertex fetch streams
+//     through the buffer; unreferenced vertices are dropped.
+// Positions are the first 3 floats of every `strideFloats`-float vertex.
+class meshOptimizerClass {
+public:
+    static constexpr uint32_t kCacheSize = 16; // FIFO simulated for the statistics and cluster cuts
+
+    struct CacheStats {
+        float acmr; // vertex shader invocations per triangle (0.5 ideal, 3 worst)
+        float atvr; // invocations per referenced vertex (1 ideal)
+    };
+    static CacheStats analyzeVertexCache(const unsigned* indices, size_t indexCount, size_t vertexCount,
+                                         uint32_t cacheSize = kCacheSize);
+
+    static void optimizeVertexCache(unsigned* indices, size_t indexCount, size_t vertexCount);
+    // `threshold`: how much a cluster's ACMR may exceed the whole list's before it is cut
+    static void optimizeOverdraw(unsigned* indices, size_t indexCount, const float* vertices,
+                                 size_t vertexCount, size_t strideFloats, float threshold = 1.05f);
+    // rewrites `vertices` and `indices` in place; returns the new vertex count
+    static size_t optimizeVertexFetch(float* vertices, size_t vertexCount, size_t strideFloats,
+                                      unsigned* indices, size_t indexCount);
+};
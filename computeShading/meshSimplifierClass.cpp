@@ -0,0 +1,195 @@
+#include "meshSimplifierClass.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+using namespace std;
+
+namespace {
+struct Vec3d { double x, y, z; };
+inline Vec3d sub(const Vec3d& a, const Vec3d& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Vec3d cross(const Vec3d& a, const Vec3d& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline double dot(const Vec3d& a, const Vec3d& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+// bit pattern for welding; -0 folds into +0
+inline uint32_t floatKey(float f) {
+    if (f == 0.0f) f = 0.0f;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    return u;
+}
+} // namespace
+
+meshSimplifierClass::meshSimplifierClass(const float* vertices, size_t vertexCount, size_t strideFloats,
+                                         const unsigned* indices, size_t indexCount)
+    : vertices_(vertices), stride_(strideFloats) {
+    auto pos = [&](uint32_t v) { const float* p = vertices_ + size_t(v) * stride_; return Vec3d{p[0], p[1], p[2]}; };
+
+    // weld: sort by position, the first vertex of each run represents it
+    remap_.resize(vertexCount);
+    vector<uint32_t> order(vertexCount);
+    iota(order.begin(), order.end(), 0u);
+    auto key = [&](uint32_t v, int k) { return floatKey(vertices_[size_t(v) * stride_ + size_t(k)]); };
+    auto less3 = [&](uint32_t a, uint32_t b) {
+        for (int k = 0; k < 3; ++k) if (key(a, k) != key(b, k)) return key(a, k) < key(b, k);
+        return a < b;
+    };
+    sort(order.begin(), order.end(), less3);
+    for (size_t i = 0; i < vertexCount; ++i) {
+        const bool same = i > 0 && key(order[i], 0) == key(order[i - 1], 0) &&
+                          key(order[i], 1) == key(order[i - 1], 1) && key(order[i], 2) == key(order[i - 1], 2);
+        remap_[order[i]] = same ? remap_[order[i - 1]] : order[i];
+    }
+
+    indices_.reserve(indexCount);
+    for (size_t t = 0; t + 2 < indexCount; t += 3) {
+        const unsigned a = remap_[indices[t]], b = remap_[indices[t + 1]], c = remap_[indices[t + 2]];
+        if (a == b || b == c || a == c) continue;
+        indices_.insert(indices_.end(), {a, b, c});
+    }
+
+    // area-weighted plane quadrics
+    quadrics_.assign(vertexCount, Quadric{});
+    for (size_t t = 0; t < indices_.size(); t += 3) {
+        const Vec3d p0 = pos(indices_[t]), p1 = pos(indices_[t + 1]), p2 = pos(indices_[t + 2]);
+        Vec3d n = cross(sub(p1, p0), sub(p2, p0));
+        const double len = sqrt(dot(n, n));
+        if (len <= 0.0) continue;
+        n = {n.x / len, n.y / len, n.z / len};
+        const double d = -dot(n, p0), w = 0.5 * len;
+        for (int k = 0; k < 3; ++k) {
+            Quadric& q = quadrics_[indices_[t + size_t(k)]];
+            q.a00 += w * n.x * n.x; q.a01 += w * n.x * n.y; q.a02 += w * n.x * n.z;
+            q.a11 += w * n.y * n.y; q.a12 += w * n.y * n.z; q.a22 += w * n.z * n.z;
+            q.b0  += w * n.x * d;   q.b1  += w * n.y * d;   q.b2  += w * n.z * d;
+            q.c   += w * d * d;     q.weight += w;
+        }
+    }
+
+    // border: an edge used by a single triangle
+    vector<uint64_t> edges;
+    edges.reserve(indices_.size());
+    for (size_t t = 0; t < indices_.size(); t += 3) {
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t a = indices_[t + size_t(k)], b = indices_[t + size_t((k + 1) % 3)];
+            edges.push_back((uint64_t(min(a, b)) << 32) | max(a, b));
+        }
+    }
+    sort(edges.begin(), edges.end());
+    border_.assign(vertexCount, 0);
+    for (size_t i = 0; i < edges.size();) {
+        size_t j = i;
+        while (j < edges.size() && edges[j] == edges[i]) ++j;
+        if (j - i == 1) border_[size_t(edges[i] >> 32)] = border_[size_t(edges[i] & 0xFFFFFFFFu)] = 1;
+        i = j;
+    }
+}
+
+double meshSimplifierClass::cost_(uint32_t from, uint32_t to) const {
+    const Quadric& a = quadrics_[from];
+    const Quadric& b = quadrics_[to];
+    const float* p = vertices_ + size_t(to) * stride_;
+    const double x = p[0], y = p[1], z = p[2];
+    const double e =
+        (a.a00 + b.a00) * x * x + (a.a11 + b.a11) * y * y + (a.a22 + b.a22) * z * z +
+        2.0 * ((a.a01 + b.a01) * x * y + (a.a02 + b.a02) * x * z + (a.a12 + b.a12) * y * z) +
+        2.0 * ((a.b0 + b.b0) * x + (a.b1 + b.b1) * y + (a.b2 + b.b2) * z) + (a.c + b.c);
+    const double w = a.weight + b.weight;
+    return w > 0.0 ? max(e, 0.0) / w : 0.0;
+}
+
+// true when moving `from` onto `to` turns any surviving triangle around `from` over
+bool meshSimplifierClass::flips_(uint32_t from, uint32_t to, const uint32_t* tris, size_t triCount) const {
+    auto pos = [&](uint32_t v) { const float* p = vertices_ + size_t(v) * stride_; return Vec3d{p[0], p[1], p[2]}; };
+    for (size_t i = 0; i < triCount; ++i) {
+        const unsigned* t = &indices_[size_t(tris[i]) * 3];
+        if (t[0] == to || t[1] == to || t[2] == to) continue; // collapses away
+        const Vec3d p0 = pos(t[0]), p1 = pos(t[1]), p2 = pos(t[2]);
+        const Vec3d before = cross(sub(p1, p0), sub(p2, p0));
+        const Vec3d q0 = pos(t[0] == from ? to : t[0]), q1 = pos(t[1] == from ? to : t[1]), q2 = pos(t[2] == from ? to : t[2]);
+        const Vec3d after = cross(sub(q1, q0), sub(q2, q0));
+        if (dot(before, after) <= 0.0) return true;
+    }
+    return false;
+}
+
+size_t meshSimplifierClass::simplifyTo(size_t targetIndexCount) {
+    const size_t vertexCount = remap_.size();
+    struct Collapse { uint32_t from, to; double cost; };
+    vector<uint32_t> start, adj, target;
+    vector<uint64_t> edges;
+    vector<Collapse> candidates;
+    vector<uint8_t> locked;
+
+    while (indices_.size() > targetIndexCount) {
+        // vertex -> triangles
+        start.assign(vertexCount + 1, 0);
+        for (unsigned v : indices_) ++start[v + 1];
+        for (size_t v = 0; v < vertexCount; ++v) start[v + 1] += start[v];
+        adj.resize(indices_.size());
+        {
+            vector<uint32_t> cursor(start.begin(), start.end() - 1);
+            for (size_t i = 0; i < indices_.size(); ++i) adj[cursor[indices_[i]]++] = uint32_t(i / 3);
+        }
+
+        // every edge once, collapsed in its cheaper direction
+        edges.clear();
+        for (size_t t = 0; t < indices_.size(); t += 3) {
+            for (int k = 0; k < 3; ++k) {
+                const uint32_t a = indices_[t + size_t(k)], b = indices_[t + size_t((k + 1) % 3)];
+                edges.push_back((uint64_t(min(a, b)) << 32) | max(a, b));
+            }
+        }
+        sort(edges.begin(), edges.end());
+        edges.erase(unique(edges.begin(), edges.end()), edges.end());
+
+        candidates.clear();
+        const double inf = numeric_limits<double>::infinity();
+        for (uint64_t e : edges) {
+            const uint32_t a = uint32_t(e >> 32), b = uint32_t(e & 0xFFFFFFFFu);
+            const double ab = border_[a] ? inf : cost_(a, b);
+            const double ba = border_[b] ? inf : cost_(b, a);
+            if (ab == inf && ba == inf) continue;
+            candidates.push_back(ab <= ba ? Collapse{a, b, ab} : Collapse{b, a, ba});
+        }
+        sort(candidates.begin(), candidates.end(), [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // each collapse removes about two triangles; the 1-ring lock keeps the flip tests valid
+        const size_t budget = max<size_t>(1, (indices_.size() - targetIndexCount) / 6);
+        target.resize(vertexCount);
+        iota(target.begin(), target.end(), 0u);
+        locked.assign(vertexCount, 0);
+        size_t done = 0;
+        for (const Collapse& c : candidates) {
+            if (done >= budget) break;
+            if (locked[c.from] || locked[c.to]) continue;
+            const uint32_t* tris = adj.data() + start[c.from];
+            const size_t triCount = start[c.from + 1] - start[c.from];
+            if (flips_(c.from, c.to, tris, triCount)) continue;
+
+            target[c.from] = c.to;
+            Quadric& q = quadrics_[c.to];
+            const Quadric& f = quadrics_[c.from];
+            q.a00 += f.a00; q.a01 += f.a01; q.a02 += f.a02; q.a11 += f.a11; q.a12 += f.a12; q.a22 += f.a22;
+            q.b0 += f.b0; q.b1 += f.b1; q.b2 += f.b2; q.c += f.c; q.weight += f.weight;
+            error_ = max(error_, float(sqrt(c.cost)));
+            for (size_t i = 0; i < triCount; ++i) {
+                const unsigned* t = &indices_[size_t(tris[i]) * 3];
+                locked[t[0]] = locked[t[1]] = locked[t[2]] = 1;
+            }
+            ++done;
+        }
+        if (done == 0) break;
+
+        size_t out = 0;
+        for (size_t t = 0; t < indices_.size(); t += 3) {
+            const unsigned a = target[indices_[t]], b = target[indices_[t + 1]], c = target[indices_[t + 2]];
+            if (a == b || b == c || a == c) continue;
+            indices_[out++] = a; indices_[out++] = b; indices_[out++] = c;
+        }
+        indices_.resize(out);
+    }
+    return indices_.size();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Quadric edge-collapse simplifier (Garland-Heckbert) that only ever collapses a vertex onto
+// one of its neighbours, so every LOD indexes the original vertex buffer and only needs
+// its own index range. Positions are welded first (split normals / UV seams share one
+// quadric); border vertices stay put so open meshes keep their outline.
+// Collapses run in passes: every candidate edge is costed, the cheapest ones are applied
+// while locking the 1-ring of each collapsed vertex, then the index list is rewritten.
+// Calls to simplifyTo() continue from the previous result, so a LOD chain accumulates
+// error the way a single long run would.
+class meshSimplifierClass {
+public:
+    // positions are the first 3 floats of every `strideFloats`-float vertex
+    meshSimplifierClass(const float* vertices, size_t vertexCount, size_t strideFloats,
+                        const unsigned* indices, size_t indexCount);
+
+    // collapses until at most targetIndexCount indices remain or no edge can go;
+    // returns the index count reached
+    size_t simplifyTo(size_t targetIndexCount);
+
+    const vector<unsigned>& indices() const { return indices_; }
+    // largest collapse cost so far, as an object-space distance
+    float error() const { return error_; }
+
+private:
+    struct Quadric {
+        double a00, a01, a02, a11, a12, a22; // symmetric 3x3
+        double b0, b1, b2, c;                // plane offsets
+        double weight;                       // summed triangle area
+    };
+
+    double cost_(uint32_t from, uint32_t to) const;      // mean squared distance of `to` to from+to's planes
+    bool   flips_(uint32_t from, uint32_t to, const uint32_t* tris, size_t triCount) const;
+
+    const float* vertices_;
+    size_t stride_;
+    vector<uint32_t> remap_;    // vertex -> welded representative
+    vector<Quadric>  quadrics_; // per representative, merged on collapse
+    vector<uint8_t>  border_;
+    vector<unsigned> indices_;
+    float error_ = 0.0f;
+};
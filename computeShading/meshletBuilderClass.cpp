@@ -0,0 +1,170 @@
+#include "meshletBuilderClass.hpp"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+using namespace std;
+
+namespace {
+// bounding sphere and normal cone of one meshlet
+void finishMeshlet(meshletBuilderClass::Meshlet& m, const float* vertices, size_t strideFloats,
+                   const unsigned* indices, const vector<uint32_t>& tris, const vector<uint32_t>& verts) {
+    auto pos = [&](uint32_t v) { return vertices + size_t(v) * strideFloats; };
+
+    // sphere around the AABB center
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX}, hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (uint32_t v : verts) {
+        for (int k = 0; k < 3; ++k) { lo[k] = min(lo[k], pos(v)[k]); hi[k] = max(hi[k], pos(v)[k]); }
+    }
+    const float c[3] = {0.5f * (lo[0] + hi[0]), 0.5f * (lo[1] + hi[1]), 0.5f * (lo[2] + hi[2])};
+    float r2 = 0.0f;
+    for (uint32_t v : verts) {
+        const float dx = pos(v)[0] - c[0], dy = pos(v)[1] - c[1], dz = pos(v)[2] - c[2];
+        r2 = max(r2, dx * dx + dy * dy + dz * dz);
+    }
+    m.sphere = glm::vec4(c[0], c[1], c[2], sqrt(r2));
+
+    // normal cone: mean of the unit face normals, cutoff from the widest deviation;
+    // cutoff 1 never passes the test (cluster too curved to reject as a whole)
+    vector<float> normals;
+    normals.reserve(tris.size() * 3);
+    double ax = 0.0, ay = 0.0, az = 0.0;
+    for (uint32_t t : tris) {
+        const float* p0 = pos(indices[size_t(t) * 3]);
+        const float* p1 = pos(indices[size_t(t) * 3 + 1]);
+        const float* p2 = pos(indices[size_t(t) * 3 + 2]);
+        const float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+        const float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+        float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+        const float len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (len <= 0.0f) continue;
+        for (float& x : n) x /= len;
+        normals.insert(normals.end(), n, n + 3);
+        ax += n[0]; ay += n[1]; az += n[2];
+    }
+    const double alen = sqrt(ax * ax + ay * ay + az * az);
+    float cutoff = 1.0f;
+    if (alen > 1e-6) {
+        ax /= alen; ay /= alen; az /= alen;
+        double minDot = 1.0;
+        for (size_t i = 0; i < normals.size(); i += 3) {
+            minDot = min(minDot, normals[i] * ax + normals[i + 1] * ay + normals[i + 2] * az);
+        }
+        if (minDot > 0.1) cutoff = float(sqrt(1.0 - minDot * minDot));
+    }
+    m.cone = glm::vec4(float(ax), float(ay), float(az), cutoff);
+}
+} // namespace
+
+void meshletBuilderClass::build(const float* vertices, size_t vertexCount, size_t strideFloats,
+                                const unsigned* indices, size_t indexCount,
+                                vector<unsigned>& reordered, vector<Meshlet>& meshlets, bool keepOrder) {
+    const size_t triCount = indexCount / 3;
+    reordered.clear();
+    meshlets.clear();
+
+    if (keepOrder) {
+        vector<uint32_t> owner(vertexCount, UINT32_MAX);
+        vector<uint32_t> verts, tris;
+        uint32_t id = 0;
+        auto flush = [&](size_t end) {
+            Meshlet m{};
+            m.firstIndex = tris.front() * 3;
+            m.indexCount = uint32_t(end - tris.front()) * 3;
+            finishMeshlet(m, vertices, strideFloats, indices, tris, verts);
+            meshlets.push_back(m);
+            verts.clear();
+            tris.clear();
+            ++id;
+        };
+        for (size_t t = 0; t < triCount; ++t) {
+            const unsigned* tri = indices + t * 3;
+            uint32_t cost = 0;
+            for (int k = 0; k < 3; ++k) cost += owner[tri[k]] != id ? 1u : 0u;
+            if (!tris.empty() && (tris.size() >= kMaxTriangles || verts.size() + cost > kMaxVertices ||
+                                  (cost == 3 && tris.size() >= kMaxTriangles / 4))) {
+                flush(t);
+                cost = 3;
+            }
+            tris.push_back(uint32_t(t));
+            for (int k = 0; k < 3; ++k) {
+                if (owner[tri[k]] == id) continue;
+                owner[tri[k]] = id;
+                verts.push_back(tri[k]);
+            }
+        }
+        if (!tris.empty()) flush(triCount);
+        return;
+    }
+    reordered.reserve(triCount * 3);
+
+    // vertex -> triangles
+    vector<uint32_t> start(vertexCount + 1, 0), adj(triCount * 3);
+    for (size_t i = 0; i < triCount * 3; ++i) ++start[indices[i] + 1];
+    for (size_t v = 0; v < vertexCount; ++v) start[v + 1] += start[v];
+    {
+        vector<uint32_t> cursor(start.begin(), start.end() - 1);
+        for (size_t i = 0; i < triCount * 3; ++i) adj[cursor[indices[i]]++] = uint32_t(i / 3);
+    }
+
+    vector<uint8_t>  emitted(triCount, 0);
+    vector<uint32_t> owner(vertexCount, UINT32_MAX); // meshlet currently holding the vertex
+    vector<uint32_t> verts, tris, candidates;
+    verts.reserve(kMaxVertices);
+    tris.reserve(kMaxTriangles);
+    uint32_t id = 0;
+
+    auto newVertices = [&](uint32_t t) {
+        uint32_t n = 0;
+        for (int k = 0; k < 3; ++k) n += owner[indices[size_t(t) * 3 + size_t(k)]] != id ? 1u : 0u;
+        return n;
+    };
+    auto add = [&](uint32_t t) {
+        emitted[t] = 1;
+        tris.push_back(t);
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = indices[size_t(t) * 3 + size_t(k)];
+            if (owner[v] == id) continue;
+            owner[v] = id;
+            verts.push_back(v);
+            for (uint32_t a = start[v]; a < start[v + 1]; ++a) {
+                if (!emitted[adj[a]]) candidates.push_back(adj[a]);
+            }
+        }
+    };
+
+    for (size_t seed = 0;; ++id) {
+        while (seed < triCount && emitted[seed]) ++seed;
+        if (seed >= triCount) break;
+        verts.clear();
+        tris.clear();
+        candidates.clear();
+        add(uint32_t(seed));
+
+        // grow over shared vertices: the candidate adding the fewest new vertices wins
+        while (tris.size() < kMaxTriangles) {
+            uint32_t best = UINT32_MAX, bestCost = 4;
+            for (size_t c = 0; c < candidates.size();) {
+                const uint32_t t = candidates[c];
+                if (emitted[t]) { candidates[c] = candidates.back(); candidates.pop_back(); continue; }
+                const uint32_t cost = newVertices(t);
+                if (verts.size() + cost <= kMaxVertices && cost < bestCost) {
+                    best = t;
+                    bestCost = cost;
+                    if (cost == 0) break;
+                }
+                ++c;
+            }
+            if (best == UINT32_MAX) break;
+            add(best);
+        }
+
+        Meshlet m{};
+        m.firstIndex = uint32_t(reordered.size());
+        m.indexCount = uint32_t(tris.size() * 3);
+        for (uint32_t t : tris) reordered.insert(reordered.end(), indices + size_t(t) * 3, indices + size_t(t) * 3 + 3);
+
+        finishMeshlet(m, vertices, strideFloats, indices, tris, verts);
+        meshlets.push_back(m);
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+// Splits a triangle list into meshlets: clusters of at most kMaxVertices unique vertices
+// and kMaxTriangles triangles. By default they are grown greedily over shared vertices so
+// each one is a compact surface patch, and the index list is rewritten in meshlet order.
+// keepOrder instead cuts the list as it is (for indices already optimized for the vertex
+// cache and overdraw, which growth would throw away); a triangle sharing no vertex with the
+// running meshlet also ends it once it is a quarter full, as such jumps are usually far.
+// Either way every meshlet is a contiguous index range and the list still draws the full
+// mesh. Each meshlet gets a bounding sphere and a normal cone (for backface rejection of
+// the whole cluster).
+// Sizes are larger than the usual mesh-shader ones: without mesh shaders every surviving
+// meshlet is its own indirect draw, and fewer, larger clusters amortise the per-draw cost.
+class meshletBuilderClass {
+public:
+    static constexpr uint32_t kMaxVertices  = 128;
+    static constexpr uint32_t kMaxTriangles = 256;
+
+    // std430 {vec4 sphere; vec4 cone; uint firstIndex; uint indexCount; uint baseVertex; uint wide;}
+    struct Meshlet {
+        glm::vec4 sphere;      // object-space center, radius
+        glm::vec4 cone;        // axis, cutoff: backfacing from eye when
+                               //   dot(c - eye, axis) >= cutoff * |c - eye| + radius
+        uint32_t  firstIndex;  // into the reordered list (the scene makes it absolute)
+        uint32_t  indexCount;
+        uint32_t  baseVertex;  // filled in by the scene
+        uint32_t  wide;        // 1: the scene stores this mesh's indices as 32-bit
+    };
+
+    // positions are the first 3 floats of every `strideFloats`-float vertex;
+    // `reordered` receives the indices in meshlet order (left empty with keepOrder)
+    static void build(const float* vertices, size_t vertexCount, size_t strideFloats,
+                      const unsigned* indices, size_t indexCount,
+                      vector<unsigned>& reordered, vector<Meshlet>& meshlets, bool keepOrder = false);
+};
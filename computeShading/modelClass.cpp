@@ -1,48 +1,101 @@
 #include "modelClass.hpp"
+#include "stlLoaderClass.hpp"
+#include "parallelUtil.hpp"
+#include "traceRecorderClass.hpp"
+#include "packedInstanceUtil.hpp"
+#include "meshSimplifierClass.hpp"
+#include "meshOptimizerClass.hpp"
+#include "jobSystemClass.hpp"
+#include "programCacheClass.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 using namespace std;
 //contructor from just name of file
-ModelObject::ModelObject(const string& meshPath) {
+ModelObject::ModelObject(const string& meshPath, VertexFormat format) : format_(format) {
+    TRACE_SCOPE("ModelObject");
     loadMesh(meshPath);
-    uploadMesh();
+    // lods, meshlets and quantization only read the loaded mesh: run them side by side and
+    // switch lod 0 to meshlet order once the simplifier is done with it
+    jobSystemClass::Graph post;
+    const auto lods     = post.add([this] { buildLods_(); });
+    const auto meshlets = post.add([this] { buildMeshlets_(); });
+    if (format_ == VertexFormat::Quantized) post.add([this] { quantizeVertices_(); });
+    post.add([this] { useMeshletOrder_(); }, {lods, meshlets});
+    post.run();
+    // no GL here (the object may be built on a loader thread): the program comes with the
+    // first setInstanceShading()
+}
+
+void ModelObject::buildProgram_() {
+    TRACE_SCOPE("model shader compile");
 
-    GLuint vs = compile(GL_VERTEX_SHADER, kDefaultVS);
-    GLuint fs = compile(GL_FRAGMENT_SHADER, kDefaultFS);
-    program_ = link(vs, fs);
+    // the VS decodes whichever layout was uploaded and picks the normal-matrix source
+    string defines;
+    if (format_ == VertexFormat::Quantized)        defines += "#define QUANTIZED_VERTICES 1\n";
+    if (normalMode_ == NormalMode::Precomputed)    defines += "#define NORMAL_MATRIX_SSBO 1\n";
+    if (normalMode_ == NormalMode::UniformScale)   defines += "#define NORMAL_UNIFORM_SCALE 1\n";
+    if (packedInstances_) defines += string("#define PACKED_INSTANCES 1\n") + kPackedInstanceGLSL;
+    string vsSrc = kDefaultVS;
+    vsSrc.insert(vsSrc.find('\n') + 1, defines);
+
+    // shared with every other model using the same variant
+    GLuint program = programCacheClass::global().graphics(vsSrc, kDefaultFS);
+    if (!program) throw runtime_error("Model program build failed");
+    if (program_) programCacheClass::global().release(program_);
+    program_ = program;
 
     uView_ = glGetUniformLocation(program_, "view");
     uProj_ = glGetUniformLocation(program_, "projection");
 }
 
-static void checkCompile(GLuint sh, GLenum type) {
-    GLint ok = 0; glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        char log[2048]; glGetShaderInfoLog(sh, 2048, nullptr, log);
-        cerr << "Shader compile error (" << (type==GL_VERTEX_SHADER?"VS":"FS") << "):\n" << log << "\n";
-        throw runtime_error("Shader compile failed");
-    }
-}
-static void checkLink(GLuint prog) {
-    GLint ok = 0; glGetProgramiv(prog, GL_LINK_STATUS, &ok);
-    if (!ok) {
-        char log[2048]; glGetProgramInfoLog(prog, 2048, nullptr, log);
-        cerr << "Program link error:\n" << log << "\n";
-        throw runtime_error("Program link failed");
-    }
+void ModelObject::setInstanceShading(NormalMode mode, bool packedInstances) {
+    if (program_ && mode == normalMode_ && packedInstances == packedInstances_) return;
+    normalMode_ = mode;
+    packedInstances_ = packedInstances;
+    buildProgram_();
 }
 
 //basic vertex
 const char* ModelObject::kDefaultVS = R"(#version 430 core
+#ifdef QUANTIZED_VERTICES
+layout (location = 0) in vec3 aPosQ;       // unorm16 within the mesh AABB
+layout (location = 1) in vec2 aNormalOct;  // octahedral, snorm16
+#else
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
+#endif
+
+// visibleIndices[] bound as an instanced attribute, so each draw's baseInstance
+// selects that object's region of the visible list
+layout (location = 2) in uint aInstance;
 
 // Per-instance data comes from SSBOs, not vertex attributes
+#ifndef PACKED_INSTANCES
 layout(std430, binding = 0) readonly buffer Matrices {
     mat4 worldMats[];
 };
+#endif
+
+#ifdef QUANTIZED_VERTICES
+layout(std430, binding = 1) readonly buffer InstanceObject { uint instanceObject[]; };
+// per object: offset (bboxMin), scale (bbox size)
+layout(std430, binding = 7) readonly buffer Dequant { vec4 dequant[]; };
+
+vec3 octDecode(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+#endif
 
-layout(std430, binding = 2) readonly buffer Visible {
-    uint visibleIndices[];
-};
+#ifdef NORMAL_MATRIX_SSBO
+// per instance: inverse-transpose of the upper 3x3, three columns (w unused)
+layout(std430, binding = 8) readonly buffer NormalMats { vec4 normalCols[]; };
+#endif
 
 out vec3 vNormal;
 
@@ -50,11 +103,29 @@ uniform mat4 view;
 uniform mat4 projection;
 
 void main() {
-    uint inst     = uint(gl_InstanceID);
-    uint matIndex = visibleIndices[inst];   // index into worldMats
-    mat4 iModel   = worldMats[matIndex];
-
-    vNormal    = mat3(transpose(inverse(iModel))) * aNormal;
+#ifdef PACKED_INSTANCES
+    InstanceTrs trs = loadInstance(aInstance);
+    mat4 iModel = instanceMatrix(trs);
+#else
+    mat4 iModel = worldMats[aInstance];
+#endif
+
+#ifdef QUANTIZED_VERTICES
+    uint obj     = instanceObject[aInstance];
+    vec3 aPos    = dequant[2u * obj].xyz + aPosQ * dequant[2u * obj + 1u].xyz;
+    vec3 aNormal = octDecode(aNormalOct);
+#endif
+
+#if defined(PACKED_INSTANCES)
+    vNormal = instanceNormalMatrix(trs) * aNormal;
+#elif defined(NORMAL_MATRIX_SSBO)
+    uint n = 3u * aInstance;
+    vNormal = mat3(normalCols[n].xyz, normalCols[n + 1u].xyz, normalCols[n + 2u].xyz) * aNormal;
+#elif defined(NORMAL_UNIFORM_SCALE)
+    vNormal = mat3(iModel) * aNormal; // scale only changes length; the FS normalises
+#else
+    vNormal = mat3(transpose(inverse(iModel))) * aNormal;
+#endif
     gl_Position = projection * view * iModel * vec4(aPos, 1.0);
 }
 )";
@@ -72,188 +143,296 @@ void main() {
 )";
 
 
-//works or frag and vertex
-GLuint ModelObject::compile(GLenum type, const char* src) {
-    GLuint sh = glCreateShader(type);
-    glShaderSource(sh, 1, &src, nullptr);
-    glCompileShader(sh);
-    checkCompile(sh, type);
-    return sh;
+bool ModelObject::meshCacheEnabled_ = true;
+bool ModelObject::lodEnabled_ = true;
+bool ModelObject::meshOptimizeEnabled_ = true;
+bool ModelObject::shortIndicesEnabled_ = true;
+bool ModelObject::meshletsEnabled_ = true;
+
+// index order is left to optimizeMesh_(), which treats every loader's output the same
+static const unsigned kAssimpFlags =
+    aiProcess_Triangulate |
+    aiProcess_GenNormals |
+    aiProcess_JoinIdenticalVertices |
+    aiProcess_OptimizeMeshes;
+
+// cache key for the import pipeline: bump kNativeStlKey when the STL loader's output changes,
+// kMeshOptKey when the optimizer's does
+static const uint32_t kNativeStlKey = 0x53544C01u; // 'STL' v1
+static const uint32_t kMeshOptKey   = 0x4F500000u; // 'OP' v0
+static uint32_t importKey(const string& path, bool optimized) {
+    return (stlLoaderClass::isStlPath(path) ? kNativeStlKey : kAssimpFlags) ^ (optimized ? kMeshOptKey : 0u);
 }
 
-//links shader to program
-GLuint ModelObject::link(GLuint vs, GLuint fs) {
-    GLuint p = glCreateProgram();
-    glAttachShader(p, vs);
-    glAttachShader(p, fs);
-    glLinkProgram(p);
-    checkLink(p);
-    glDeleteShader(vs);
-    glDeleteShader(fs);
-    return p;
-}
-
-//importer
-void ModelObject::loadMesh(const string& path) {
+//assimp importer, used for everything that is not STL
+static void loadWithAssimp(const string& path, vector<float>& interleaved, vector<unsigned>& indices,
+                           glm::vec3& bboxMin, glm::vec3& bboxMax) {
     Assimp::Importer importer;
-    const aiScene* scene = importer.ReadFile(
-        path,
-        aiProcess_Triangulate |
-        aiProcess_GenNormals |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ImproveCacheLocality |
-        aiProcess_OptimizeMeshes
-    );
+    TRACE_SCOPE("assimp import");
+    const aiScene* scene = importer.ReadFile(path, kAssimpFlags);
     if (!scene || !scene->mNumMeshes) {
         throw runtime_error("Assimp failed to load: " + path);
     }
     const aiMesh* m = scene->mMeshes[0];
-    interleaved_.reserve(m->mNumVertices * 6);
+    interleaved.reserve(m->mNumVertices * 6);
     for (unsigned i = 0; i < m->mNumVertices; ++i) {
         const aiVector3D& p = m->mVertices[i];
         const aiVector3D& n = m->mNormals[i];
 
         // === NEW: update bounds ===
-        bboxMin_.x = min(bboxMin_.x, p.x);
-        bboxMin_.y = min(bboxMin_.y, p.y);
-        bboxMin_.z = min(bboxMin_.z, p.z);
-        bboxMax_.x = max(bboxMax_.x, p.x);
-        bboxMax_.y = max(bboxMax_.y, p.y);
-        bboxMax_.z = max(bboxMax_.z, p.z);
-
-        interleaved_.insert(end(interleaved_), {p.x,p.y,p.z, n.x,n.y,n.z});
+        bboxMin.x = min(bboxMin.x, p.x);
+        bboxMin.y = min(bboxMin.y, p.y);
+        bboxMin.z = min(bboxMin.z, p.z);
+        bboxMax.x = max(bboxMax.x, p.x);
+        bboxMax.y = max(bboxMax.y, p.y);
+        bboxMax.z = max(bboxMax.z, p.z);
+
+        interleaved.insert(end(interleaved), {p.x,p.y,p.z, n.x,n.y,n.z});
     }
-    indices_.reserve(m->mNumFaces * 3);
+    indices.reserve(m->mNumFaces * 3);
     for (unsigned f = 0; f < m->mNumFaces; ++f) {
         const aiFace& face = m->mFaces[f];
         if (face.mNumIndices == 3) {
-            indices_.push_back(face.mIndices[0]);
-            indices_.push_back(face.mIndices[1]);
-            indices_.push_back(face.mIndices[2]);
+            indices.push_back(face.mIndices[0]);
+            indices.push_back(face.mIndices[1]);
+            indices.push_back(face.mIndices[2]);
         }
     }
 }
 
-//send mesh to gpu
-void ModelObject::uploadMesh() {
-    glGenVertexArrays(1, &vao_);
-    glBindVertexArray(vao_);
-
-    glGenBuffers(1, &vbo_);
-    glBindBuffer(GL_ARRAY_BUFFER, vbo_);
-    glBufferData(GL_ARRAY_BUFFER, interleaved_.size() * sizeof(float), interleaved_.data(), GL_STATIC_DRAW);
-
-    glGenBuffers(1, &ebo_);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo_);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(unsigned), indices_.data(), GL_STATIC_DRAW);
+//importer: mapped .meshcache if it is current, else native reader for STL, Assimp for the rest
+void ModelObject::loadMesh(const string& path) {
+    TRACE_SCOPE("mesh load");
+    const string cachePath = meshCacheClass::cachePathFor(path);
+    uint64_t hash = 0;
+    if (meshCacheEnabled_) {
+        hash = meshCacheClass::hashFile(path);
+        cacheFile_ = meshCacheClass::open(cachePath, hash, importKey(path, meshOptimizeEnabled_), mesh_);
+        if (cacheFile_) {
+            bboxMin_ = mesh_.bboxMin;
+            bboxMax_ = mesh_.bboxMax;
+            return;
+        }
+    }
 
-    // pos (0), normal (1)
-    const GLsizei stride = sizeof(float) * 6;
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(float)*3));
+    if (stlLoaderClass::isStlPath(path)) {
+        stlLoaderClass::load(path, interleaved_, indices_, bboxMin_, bboxMax_);
+    } else {
+        loadWithAssimp(path, interleaved_, indices_, bboxMin_, bboxMax_);
+    }
+    if (meshOptimizeEnabled_) optimizeMesh_();
+    mesh_.vertices    = interleaved_.data();
+    mesh_.vertexCount = interleaved_.size() / 6;
+    mesh_.indices     = indices_.data();
+    mesh_.indexCount  = indices_.size();
+    mesh_.bboxMin     = bboxMin_;
+    mesh_.bboxMax     = bboxMax_;
+
+    if (meshCacheEnabled_ && !meshCacheClass::write(cachePath, hash, importKey(path, meshOptimizeEnabled_), mesh_)) {
+        cerr << "[cache] could not write " << cachePath << "\n";
+    }
+}
 
-    glBindVertexArray(0);
+// vertex cache order, then overdraw order, then vertices in first-use order; the result is
+// what gets cached, so a cache hit is already optimized
+void ModelObject::optimizeMesh_() {
+    TRACE_SCOPE("mesh optimize");
+    const auto t0 = chrono::steady_clock::now();
+    const size_t vertexCount = interleaved_.size() / 6;
+    const auto before = meshOptimizerClass::analyzeVertexCache(indices_.data(), indices_.size(), vertexCount);
+    meshOptimizerClass::optimizeVertexCache(indices_.data(), indices_.size(), vertexCount);
+    meshOptimizerClass::optimizeOverdraw(indices_.data(), indices_.size(), interleaved_.data(), vertexCount, 6);
+    const size_t used = meshOptimizerClass::optimizeVertexFetch(interleaved_.data(), vertexCount, 6,
+                                                                indices_.data(), indices_.size());
+    interleaved_.resize(used * 6);
+    const auto after = meshOptimizerClass::analyzeVertexCache(indices_.data(), indices_.size(), used);
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "[meshopt] " << indices_.size() / 3 << " tris: acmr " << before.acmr << " -> " << after.acmr
+         << ", atvr " << before.atvr << " -> " << after.atvr << " (fifo " << meshOptimizerClass::kCacheSize << ")";
+    if (used != vertexCount) cout << ", " << vertexCount - used << " unused verts dropped";
+    cout << ", " << ms << " ms\n";
 }
 
-void ModelObject::setupInstanceBuffer() {
-    if (!instanceVbo_) glGenBuffers(1, &instanceVbo_);
-    glBindVertexArray(vao_);
-    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
-    glBufferData(GL_ARRAY_BUFFER, instanceMats_.size() * sizeof(glm::mat4), instanceMats_.data(), GL_DYNAMIC_DRAW);
-
-    // mat4 takes 4 attribute locations (2..5)
-    constexpr GLuint baseLoc = 2;
-    constexpr GLsizei vec4Size = sizeof(glm::vec4);
-    for (int i = 0; i < 4; ++i) {
-        glEnableVertexAttribArray(baseLoc + i);
-        const uintptr_t offset = static_cast<uintptr_t>(i) * static_cast<uintptr_t>(vec4Size);
-        glVertexAttribPointer(baseLoc + i, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
-                              reinterpret_cast<void*>(offset));
-        glVertexAttribDivisor(baseLoc + i, 1);
+// halves the triangle count per level until kMaxLods, a tiny mesh, or the simplifier stalls;
+// each level continues from the previous one so errors accumulate
+void ModelObject::buildLods_() {
+    lodIndices_.clear();
+    lodErrors_.clear();
+    if (!lodEnabled_ || mesh_.indexCount < 3 * 64) return;
+    TRACE_SCOPE("mesh lods");
+    const auto t0 = chrono::steady_clock::now();
+    meshSimplifierClass simplifier(mesh_.vertices, mesh_.vertexCount, 6, mesh_.indices, mesh_.indexCount);
+    size_t prev = mesh_.indexCount;
+    for (int l = 1; l < kMaxLods && prev >= 3 * 32; ++l) {
+        const size_t got = simplifier.simplifyTo(prev / 6 * 3);
+        if (got > prev - prev / 10) break; // nothing left to take away cheaply
+        lodIndices_.push_back(simplifier.indices());
+        if (meshOptimizeEnabled_) {
+            meshOptimizerClass::optimizeVertexCache(lodIndices_.back().data(), lodIndices_.back().size(), mesh_.vertexCount);
+        }
+        lodErrors_.push_back(simplifier.error());
+        prev = got;
     }
-    glBindVertexArray(0);
-
-    instanceCount_ = static_cast<GLsizei>(instanceMats_.size());
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    if (lodIndices_.empty()) {
+        cout << "[lod] " << mesh_.indexCount / 3 << " tris: no cheaper level found (" << ms << " ms)\n";
+        return;
+    }
+    cout << "[lod] " << mesh_.indexCount / 3;
+    for (size_t l = 0; l < lodIndices_.size(); ++l) cout << " -> " << lodIndices_[l].size() / 3;
+    cout << " tris, error";
+    for (float e : lodErrors_) cout << " " << e;
+    cout << " (mesh extent " << maxExtent() << "), " << ms << " ms\n";
 }
 
-//destructor
-ModelObject::~ModelObject() {
-    if (program_)     glDeleteProgram(program_);
-    if (instanceVbo_) glDeleteBuffers(1, &instanceVbo_);
-    if (ebo_)         glDeleteBuffers(1, &ebo_);
-    if (vbo_)         glDeleteBuffers(1, &vbo_);
-    if (vao_)         glDeleteVertexArrays(1, &vao_);
+// meshlets over lod 0; an optimized lod 0 is cut in order (growth would undo the cache and
+// overdraw order), otherwise the grown order waits in meshletOrder_ while the lods read lod 0
+void ModelObject::buildMeshlets_() {
+    meshlets_.clear();
+    if (!meshletsEnabled_ || mesh_.indexCount < 3 * kMeshletMinTriangles) return;
+    TRACE_SCOPE("meshlets");
+    const auto t0 = chrono::steady_clock::now();
+    meshletBuilderClass::build(mesh_.vertices, mesh_.vertexCount, 6, mesh_.indices, mesh_.indexCount, meshletOrder_, meshlets_,
+                               meshOptimizeEnabled_);
+    const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    // lod 0 as it will be uploaded
+    const unsigned* drawn = meshletOrder_.empty() ? mesh_.indices : meshletOrder_.data();
+    const float acmr = meshOptimizerClass::analyzeVertexCache(drawn, mesh_.indexCount, mesh_.vertexCount).acmr;
+    cout << "[meshlet] " << meshlets_.size() << " meshlets, " << double(mesh_.indexCount / 3) / double(max<size_t>(meshlets_.size(), 1))
+         << " tris each on average, lod 0 acmr " << acmr << (meshletOrder_.empty() ? " (order kept)" : " (regrown)")
+         << ", " << ms << " ms\n";
 }
 
-//gets camera for render
-void ModelObject::bindCamera(const glm::mat4* viewPtr, const glm::mat4* projPtr) {
-    view_ = viewPtr;
-    proj_ = projPtr;
+// lod 0 in grown meshlet order: owned from here on, even when the mesh came from the cache
+void ModelObject::useMeshletOrder_() {
+    if (meshletOrder_.empty()) return;
+    indices_.swap(meshletOrder_);
+    mesh_.indices = indices_.data();
+    vector<unsigned>().swap(meshletOrder_);
 }
 
+static uint16_t toUnorm16(float v) {
+    return static_cast<uint16_t>(clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f);
+}
+static int16_t toSnorm16(float v) {
+    return static_cast<int16_t>(lround(clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
 
-void ModelObject::setInstanceTransforms(const vector<glm::mat4>& transforms) {
-    instanceMats_ = transforms;
-    if (instanceMats_.empty()) {
-        instanceMats_.push_back(glm::mat4(1.0f)); // ensure at least one
-    }
-    setupInstanceBuffer();
+// builds the 12-byte stream from the float one; positions span the mesh's own AABB
+void ModelObject::quantizeVertices_() {
+    TRACE_SCOPE("vertex quantize");
+    static_assert(sizeof(QuantizedVertex) == 12, "quantized vertex must stay 12 bytes");
+    const glm::vec3 ext = quantScale();
+    const glm::vec3 inv(ext.x > 0.0f ? 1.0f / ext.x : 0.0f,
+                        ext.y > 0.0f ? 1.0f / ext.y : 0.0f,
+                        ext.z > 0.0f ? 1.0f / ext.z : 0.0f);
+    const float* src = mesh_.vertices;
+    quantized_.resize(mesh_.vertexCount);
+
+    parallelFor(quantized_.size(), [&](size_t begin, size_t end) {
+        for (size_t v = begin; v < end; ++v) {
+            const float* s = src + v * 6;
+            QuantizedVertex& q = quantized_[v];
+            q.px  = toUnorm16((s[0] - bboxMin_.x) * inv.x);
+            q.py  = toUnorm16((s[1] - bboxMin_.y) * inv.y);
+            q.pz  = toUnorm16((s[2] - bboxMin_.z) * inv.z);
+            q.pad = 0;
+
+            // octahedral: project onto |x|+|y|+|z| = 1, fold the lower hemisphere over
+            float l1 = fabs(s[3]) + fabs(s[4]) + fabs(s[5]);
+            float ox = l1 > 0.0f ? s[3] / l1 : 0.0f;
+            float oy = l1 > 0.0f ? s[4] / l1 : 0.0f;
+            if (s[5] < 0.0f) {
+                float fx = (1.0f - fabs(oy)) * (ox >= 0.0f ? 1.0f : -1.0f);
+                float fy = (1.0f - fabs(ox)) * (oy >= 0.0f ? 1.0f : -1.0f);
+                ox = fx; oy = fy;
+            }
+            q.nx = toSnorm16(ox);
+            q.ny = toSnorm16(oy);
+        }
+    });
 }
 
-void ModelObject::render() {
-    // We now rely on the indirect command buffer, not instanceCount_
-    if (!program_ || !vao_ || !view_ || !proj_ || indirectBuffer_ == 0) return;
+const void* ModelObject::vertexStream() const {
+    if (format_ == VertexFormat::Quantized) return quantized_.data();
+    return mesh_.vertices;
+}
 
-    glUseProgram(program_);
-    glUniformMatrix4fv(uView_, 1, GL_FALSE, glm::value_ptr(*view_));
-    glUniformMatrix4fv(uProj_, 1, GL_FALSE, glm::value_ptr(*proj_));
+size_t ModelObject::vertexStride() const {
+    return format_ == VertexFormat::Quantized ? sizeof(QuantizedVertex) : sizeof(float) * 6;
+}
 
-    glBindVertexArray(vao_);
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer_);
-    glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr);
-    glBindVertexArray(0);
+void ModelObject::setVertexAttribs(VertexFormat format) {
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    if (format == VertexFormat::Quantized) {
+        const GLsizei stride = sizeof(QuantizedVertex);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, stride,
+                              reinterpret_cast<void*>(offsetof(QuantizedVertex, px)));
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, stride,
+                              reinterpret_cast<void*>(offsetof(QuantizedVertex, nx)));
+    } else {
+        const GLsizei stride = sizeof(float) * 6;
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(0));
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, reinterpret_cast<void*>(sizeof(float)*3));
+    }
 }
 
-void ModelObject::setVisibleCount(GLuint visibleCount) {
-    if (indirectBuffer_ == 0) {
-        return; // initIndirect not called yet
+//times the Assimp path against the native STL reader (no GL needed)
+void ModelObject::benchmarkLoad(const string& path) {
+    auto timeIt = [&](const char* name, auto&& fn) {
+        vector<float> v; vector<unsigned> idx;
+        glm::vec3 bmin(FLT_MAX), bmax(-FLT_MAX);
+        auto t0 = chrono::steady_clock::now();
+        fn(v, idx, bmin, bmax);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        cout << "[load] " << name << ": " << ms << " ms, "
+             << v.size() / 6 << " verts, " << idx.size() / 3 << " tris\n";
+        return ms;
+    };
+
+    double assimpMs = timeIt("assimp", [&](auto& v, auto& i, auto& bmin, auto& bmax) {
+        loadWithAssimp(path, v, i, bmin, bmax);
+    });
+    if (stlLoaderClass::isStlPath(path)) {
+        double nativeMs = timeIt("native", [&](auto& v, auto& i, auto& bmin, auto& bmax) {
+            stlLoaderClass::load(path, v, i, bmin, bmax);
+        });
+        cout << "[load] " << path << ": native is " << assimpMs / max(nativeMs, 1e-6)
+             << "x the speed of assimp (" << workerCount() << " threads)\n";
     }
 
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer_);
+    // cache hit: hash the source, validate and map; touch every page so the
+    // number includes what the upload would otherwise pay for faulting them in
+    const string cachePath = meshCacheClass::cachePathFor(path);
+    auto t0 = chrono::steady_clock::now();
+    meshCacheClass::MeshView view;
+    auto file = meshCacheClass::open(cachePath, meshCacheClass::hashFile(path), importKey(path, meshOptimizeEnabled_), view);
+    if (!file) {
+        cout << "[load] cache: no current " << cachePath << " (run once without --bench-load to create it)\n";
+        return;
+    }
+    volatile unsigned sink = 0;
+    for (size_t off = 0; off < file->size(); off += 4096) sink += file->data()[off];
+    double cacheMs = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    cout << "[load] cache: " << cacheMs << " ms, " << view.vertexCount << " verts, "
+         << view.indexCount / 3 << " tris (" << assimpMs / max(cacheMs, 1e-6) << "x assimp)\n";
+}
 
-    // Only update the instanceCount field inside the command
-    glBufferSubData(GL_DRAW_INDIRECT_BUFFER,
-                    offsetof(DrawElementsIndirectCommand, instanceCount),
-                    sizeof(GLuint),
-                    &visibleCount);
+//destructor
+ModelObject::~ModelObject() {
+    if (program_)     programCacheClass::global().release(program_);
+}
 
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+//gets camera for render
+void ModelObject::bindCamera(const glm::mat4* viewPtr, const glm::mat4* projPtr) {
+    view_ = viewPtr;
+    proj_ = projPtr;
 }
 
-void ModelObject::initIndirect(GLsizei maxInstances) {
-    // Create the indirect draw buffer if it doesn't exist yet
-    if (indirectBuffer_ == 0) {
-        glGenBuffers(1, &indirectBuffer_);
-    }
 
-    // Set up the initial draw command.
-    // We draw all indices in the mesh, but with instanceCount = 0
-    // until culling tells us how many instances are visible.
-    DrawElementsIndirectCommand cmd{};
-    cmd.count         = static_cast<GLuint>(indices_.size());  // indices per instance
-    cmd.instanceCount = 0;                                     // will be set via setVisibleCount()
-    cmd.firstIndex    = 0;                                     // EBO starts at 0
-    cmd.baseVertex    = 0;                                     // VBO starts at 0
-    cmd.baseInstance  = 0;                                     // first instance ID
-
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer_);
-    glBufferData(GL_DRAW_INDIRECT_BUFFER,
-                 sizeof(DrawElementsIndirectCommand),
-                 &cmd,
-                 GL_DYNAMIC_DRAW);
-    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
-
-    (void)maxInstances; // currently unused, avoids a warning
+void ModelObject::bindProgram() const {
+    glUseProgram(program_);
+    if (view_) glUniformMatrix4fv(uView_, 1, GL_FALSE, glm::value_ptr(*view_));
+    if (proj_) glUniformMatrix4fv(uProj_, 1, GL_FALSE, glm::value_ptr(*proj_));
 }
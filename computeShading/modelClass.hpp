@@ -8,7 +8,10 @@
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <cfloat>
+#include "meshCacheClass.hpp"
+#include "meshletBuilderClass.hpp"
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -18,14 +21,31 @@ using namespace std;
 
 
 
+// writes animated transforms for `count` instances at time `t` from their static `base` ones
+using InstanceAnimator = function<void(double t, const glm::mat4* base, glm::mat4* dst, size_t count)>;
+
+// GPU vertex layout; every object in one scene must use the same one
+enum class VertexFormat {
+    Float,      // pos 3x f32 + normal 3x f32 (24 bytes)
+    Quantized,  // pos 3x unorm16 within the mesh AABB (+pad), normal octahedral 2x snorm16 (12 bytes)
+};
+
+// how the VS gets each instance's normal matrix
+enum class NormalMode {
+    Inverse,       // transpose(inverse(mat3)) per vertex (reference / A-B timing)
+    Precomputed,   // per-instance inverse-transpose read from an SSBO (binding 8)
+    UniformScale,  // every instance is rotation * uniform scale: mat3(model) is enough
+    FromTrs,       // packed TRS instances: R * inverse(S), rebuilt next to the matrix
+};
+
 class ModelObject{
 public:
 
-    ModelObject(const string& meshPath);
+    // CPU only (load, optimize, LODs, meshlets), safe on any thread; see asyncMeshLoaderClass
+    ModelObject(const string& meshPath, VertexFormat format = VertexFormat::Float);
     ~ModelObject();
 
     void bindCamera(const glm::mat4* viewPtr, const glm::mat4* projPtr);
-    void setInstanceTransforms(const vector<glm::mat4>& transforms);//here or in scene builder?
 
     //for spacing
     glm::vec3 bboxMin()  const { return bboxMin_; }
@@ -33,34 +53,106 @@ public:
     glm::vec3 bboxSize() const { return bboxMax_ - bboxMin_; }
     float     maxExtent() const { glm::vec3 s = bboxSize(); return max(s.x, max(s.y, s.z)); }
 
-    void render();
-    void initIndirect(GLsizei maxInstances);
-    void setVisibleCount(GLuint visibleCount); // helper for run()
+    // cpu mesh, packed into the scene's shared buffers by sceneBuilderClass;
+    // points into the mapped .meshcache when the cache was hit
+    const float*    vertexData()  const { return mesh_.vertices; }
+    size_t          vertexCount() const { return mesh_.vertexCount; }
+    const unsigned* indexData()   const { return mesh_.indices; }
+    size_t          indexCount()  const { return mesh_.indexCount; }
+    bool            fromCache()   const { return cacheFile_ != nullptr; }
+    // uploaded as 16-bit indices when every vertex is reachable (the draw adds baseVertex);
+    // bunny / fox sized meshes qualify, half the index memory and fetch bandwidth
+    static constexpr size_t kMaxShortVertices = 65536;
+    bool            shortIndices() const { return shortIndicesEnabled_ && vertexCount() <= kMaxShortVertices; }
+    static void     setShortIndicesEnabled(bool on) { shortIndicesEnabled_ = on; }
+
+    // discrete LODs over the same vertices, built at load time by quadric edge collapse:
+    // lod 0 is indexData(), each next one has about half the triangles of the one before;
+    // lodError(l) is the object-space deviation of lod l from the source mesh
+    static constexpr int kMaxLods = 4;
+    int             lodCount() const { return 1 + int(lodIndices_.size()); }
+    const unsigned* lodIndexData(int l) const  { return l == 0 ? indexData()  : lodIndices_[size_t(l - 1)].data(); }
+    size_t          lodIndexCount(int l) const { return l == 0 ? indexCount() : lodIndices_[size_t(l - 1)].size(); }
+    float           lodError(int l) const      { return l == 0 ? 0.0f : lodErrors_[size_t(l - 1)]; }
+    // generate LODs for meshes loaded after this call (on by default)
+    static void setLodEnabled(bool on) { lodEnabled_ = on; }
+
+    // meshlets over lod 0 for high-poly meshes (at least kMeshletMinTriangles); when present,
+    // indexData() is in meshlet order and each meshlet's firstIndex is relative to it
+    static constexpr size_t kMeshletMinTriangles = 8 * meshletBuilderClass::kMaxTriangles;
+    const vector<meshletBuilderClass::Meshlet>& meshlets() const { return meshlets_; }
+    static void setMeshletsEnabled(bool on) { meshletsEnabled_ = on; }
+
+    // the stream actually uploaded to the GPU, in vertexFormat()
+    VertexFormat vertexFormat() const { return format_; }
+    const void*  vertexStream() const;
+    size_t       vertexStride() const;
+    // quantized positions decode as bboxMin() + unorm * quantScale()
+    glm::vec3    quantScale()   const { return bboxSize(); }
+    // sets attributes 0 (pos) and 1 (normal) for the VAO/VBO currently bound
+    static void  setVertexAttribs(VertexFormat format);
+
+    // read/write "<mesh>.meshcache" next to the source (on by default)
+    static void setMeshCacheEnabled(bool on) { meshCacheEnabled_ = on; }
+    // vertex cache / overdraw / vertex fetch reordering at import, LODs reordered for the
+    // cache as well (on by default; cached meshes are keyed on it)
+    static void setMeshOptimizeEnabled(bool on) { meshOptimizeEnabled_ = on; }
+
+    // binds the draw program and uploads camera uniforms; geometry is drawn by the scene
+    void bindProgram() const;
+    // (re)compiles the draw program on first use or when either setting changes (the scene
+    // picks them per build); packed: binding 0 holds PackedInstance records instead of mat4s
+    void       setInstanceShading(NormalMode mode, bool packedInstances);
+    NormalMode normalMode() const { return normalMode_; }
+    bool       packedInstances() const { return packedInstances_; }
+
+    // prints Assimp vs native STL load times for a file (no GL context needed)
+    static void benchmarkLoad(const string& path);
 
 private:
-    // shader utils
-    static GLuint compile(GLenum type, const char* src);
-    static GLuint link(GLuint vs, GLuint fs);
+    void buildProgram_();
 
     // mesh utils
     void loadMesh(const string& path);
-    void uploadMesh();
-    void setupInstanceBuffer();
+    void quantizeVertices_();
+    void optimizeMesh_();
+    void buildLods_();
+    void buildMeshlets_();      // into meshletOrder_, lod 0 stays as is
+    void useMeshletOrder_();
 
     //for spacing
     glm::vec3 bboxMin_{  FLT_MAX,  FLT_MAX,  FLT_MAX };
     glm::vec3 bboxMax_{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
     // gpu
-    GLuint vao_ = 0, vbo_ = 0, ebo_ = 0, instanceVbo_ = 0, program_ = 0;
+    GLuint program_ = 0;            // from programCacheClass, shared between models
+    NormalMode normalMode_ = NormalMode::Inverse;
+    bool       packedInstances_ = false;
 
-    // cpu mesh
+    // cpu mesh: either owned vectors or a mapped cache file, viewed through mesh_
     vector<float> interleaved_;     // pos(3) + normal(3)
     vector<unsigned> indices_;
-
-    // instancing
-    vector<glm::mat4> instanceMats_;
-    GLsizei instanceCount_ = 0;
+    unique_ptr<mappedFileClass> cacheFile_;
+    meshCacheClass::MeshView mesh_;
+    static bool meshCacheEnabled_;
+    static bool meshOptimizeEnabled_;
+    static bool shortIndicesEnabled_;
+
+    // lods 1.. (lod 0 is mesh_)
+    vector<vector<unsigned>> lodIndices_;
+    vector<float> lodErrors_;
+    static bool lodEnabled_;
+
+    vector<meshletBuilderClass::Meshlet> meshlets_;
+    vector<unsigned> meshletOrder_; // until useMeshletOrder_()
+    static bool meshletsEnabled_;
+
+    struct QuantizedVertex {
+        uint16_t px, py, pz, pad;
+        int16_t  nx, ny;
+    };
+    VertexFormat format_ = VertexFormat::Float;
+    vector<QuantizedVertex> quantized_;
 
     // camera (not owned)
     const glm::mat4* view_ = nullptr;
@@ -73,14 +165,4 @@ private:
     // defaults
     static const char* kDefaultVS;
     static const char* kDefaultFS;
-
-    //for indirect
-    struct DrawElementsIndirectCommand {
-        GLuint count;          // number of indices per instance  (indices_.size())
-        GLuint instanceCount;  // how many instances to draw      (visCount)
-        GLuint firstIndex;     // 0
-        GLuint baseVertex;     // 0
-        GLuint baseInstance;   // 0
-    };
-    GLuint indirectBuffer_ = 0;
 };
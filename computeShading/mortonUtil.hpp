@@ -0,0 +1,119 @@
+#pragma once
+#include "parallelUtil.hpp"
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+using namespace std;
+
+// low 10 bits of v spread to every third bit (bit k -> bit 3k)
+inline uint32_t expandBits10(uint32_t v) {
+    v &= 0x3FFu;
+    v = (v | (v << 16)) & 0x030000FFu;
+    v = (v | (v << 8))  & 0x0300F00Fu;
+    v = (v | (v << 4))  & 0x030C30C3u;
+    v = (v | (v << 2))  & 0x09249249u;
+    return v;
+}
+
+// 30-bit Morton code of p quantised to a 1024^3 grid over [lo, lo + 1/invSize]
+inline uint32_t morton3D(const glm::vec3& p, const glm::vec3& lo, const glm::vec3& invSize) {
+    auto q = [](float t) { return uint32_t(min(max(t * 1024.0f, 0.0f), 1023.0f)); };
+    return (expandBits10(q((p.x - lo.x) * invSize.x)) << 2) |
+           (expandBits10(q((p.y - lo.y) * invSize.y)) << 1) |
+            expandBits10(q((p.z - lo.z) * invSize.z));
+}
+
+// 1/extent per axis, 0 for flat axes (every point then quantises to 0 there)
+inline glm::vec3 mortonInvSize(const glm::vec3& lo, const glm::vec3& hi) {
+    const glm::vec3 s = hi - lo;
+    return glm::vec3(s.x > 0.0f ? 1.0f / s.x : 0.0f, s.y > 0.0f ? 1.0f / s.y : 0.0f, s.z > 0.0f ? 1.0f / s.z : 0.0f);
+}
+
+// Stable LSD radix sort of n (key, value) pairs on the low keyBits bits, 8 bits per pass.
+// Each pass: per-part histograms, one exclusive scan in (digit, part) order, then every
+// part scatters its own items, so equal keys keep their input order.
+inline void radixSortPairs(uint32_t* keys, uint32_t* vals, size_t n, int keyBits = 32) {
+    if (n < 2) return;
+    const size_t parts = max<size_t>(1, min<size_t>(workerCount(), n / 16384));
+    const size_t per = (n + parts - 1) / parts;
+    vector<uint32_t> keyTmp(n), valTmp(n);
+    vector<size_t> offsets(parts * 256);
+
+    uint32_t* srcK = keys;          uint32_t* srcV = vals;
+    uint32_t* dstK = keyTmp.data(); uint32_t* dstV = valTmp.data();
+    for (int shift = 0; shift < keyBits; shift += 8) {
+        fill(offsets.begin(), offsets.end(), size_t(0));
+        parallelFor(parts, [&](size_t pb, size_t pe) {
+            for (size_t p = pb; p < pe; ++p) {
+                size_t* h = &offsets[p * 256];
+                for (size_t i = p * per, e = min(n, i + per); i < e; ++i) ++h[(srcK[i] >> shift) & 255u];
+            }
+        }, 1);
+
+        size_t sum = 0;
+        for (size_t d = 0; d < 256; ++d) {
+            for (size_t p = 0; p < parts; ++p) {
+                const size_t c = offsets[p * 256 + d];
+                offsets[p * 256 + d] = sum;
+                sum += c;
+            }
+        }
+
+        parallelFor(parts, [&](size_t pb, size_t pe) {
+            for (size_t p = pb; p < pe; ++p) {
+                size_t* o = &offsets[p * 256];
+                for (size_t i = p * per, e = min(n, i + per); i < e; ++i) {
+                    const size_t at = o[(srcK[i] >> shift) & 255u]++;
+                    dstK[at] = srcK[i];
+                    dstV[at] = srcV[i];
+                }
+            }
+        }, 1);
+        swap(srcK, dstK);
+        swap(srcV, dstV);
+    }
+    if (srcK != keys) {   // odd number of passes: result sits in the scratch arrays
+        copy(srcK, srcK + n, keys);
+        copy(srcV, srcV + n, vals);
+    }
+}
+
+// Stable reorder of mats by the Morton code of their translation (over the set's own
+// bounds): instances that are close in space end up close in memory.
+inline void sortByMorton(vector<glm::mat4>& mats) {
+    const size_t n = mats.size();
+    if (n < 2) return;
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    mutex boundsMutex;
+    parallelFor(n, [&](size_t b, size_t e) {
+        glm::vec3 cLo(FLT_MAX), cHi(-FLT_MAX);
+        for (size_t i = b; i < e; ++i) {
+            cLo = glm::min(cLo, glm::vec3(mats[i][3]));
+            cHi = glm::max(cHi, glm::vec3(mats[i][3]));
+        }
+        lock_guard<mutex> lock(boundsMutex);
+        lo = glm::min(lo, cLo);
+        hi = glm::max(hi, cHi);
+    });
+
+    vector<uint32_t> codes(n), order(n);
+    const glm::vec3 invSize = mortonInvSize(lo, hi);
+    parallelFor(n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            codes[i] = morton3D(glm::vec3(mats[i][3]), lo, invSize);
+            order[i] = uint32_t(i);
+        }
+    });
+    radixSortPairs(codes.data(), order.data(), n, 30);
+
+    vector<glm::mat4> sorted(n);
+    parallelFor(n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) sorted[i] = mats[order[i]];
+    });
+    mats.swap(sorted);
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <cmath>
+#include <cstdint>
+using namespace std;
+
+// Instance transform as translation + rotation + per-axis scale in 28 bytes instead of a
+// 64-byte mat4: position stays f32 (scenes span thousands of units), the unit quaternion
+// is snorm16 x4 (~3e-5 rad), scale is f16 x3 (~5e-4 relative). Only TRS matrices fit;
+// packInstance() rejects anything with shear or a projective row.
+// Read in GLSL as a flat uint[] with 7 words per instance (kPackedInstanceGLSL).
+struct PackedInstance {
+    float    px, py, pz;
+    uint32_t rotXY;     // packSnorm2x16(q.x, q.y)
+    uint32_t rotZW;     // packSnorm2x16(q.z, q.w)
+    uint32_t scaleXY;   // packHalf2x16(s.x, s.y)
+    uint32_t scaleZ;    // packHalf2x16(s.z, 0)
+};
+static_assert(sizeof(PackedInstance) == 28, "PackedInstance must stay 7 words (GLSL stride)");
+
+// exactly what the shaders rebuild from `p`
+inline glm::mat4 unpackInstance(const PackedInstance& p) {
+    const glm::vec2 qxy = glm::unpackSnorm2x16(p.rotXY), qzw = glm::unpackSnorm2x16(p.rotZW);
+    const glm::quat q = glm::normalize(glm::quat(qzw.y, qxy.x, qxy.y, qzw.x));
+    const glm::vec2 sxy = glm::unpackHalf2x16(p.scaleXY), sz = glm::unpackHalf2x16(p.scaleZ);
+    const glm::mat3 r = glm::mat3_cast(q);
+    return glm::mat4(glm::vec4(r[0] * sxy.x, 0.0f), glm::vec4(r[1] * sxy.y, 0.0f),
+                     glm::vec4(r[2] * sz.x, 0.0f), glm::vec4(p.px, p.py, p.pz, 1.0f));
+}
+
+// false when `m` is not translate * rotate * scale to within the packed precision
+inline bool packInstance(const glm::mat4& m, PackedInstance& out) {
+    if (m[0][3] != 0.0f || m[1][3] != 0.0f || m[2][3] != 0.0f || m[3][3] != 1.0f) return false;
+
+    glm::vec3 s(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1])), glm::length(glm::vec3(m[2])));
+    if (s.x <= 0.0f || s.y <= 0.0f || s.z <= 0.0f || max(s.x, max(s.y, s.z)) > 65504.0f) return false;
+    glm::mat3 r(glm::vec3(m[0]) / s.x, glm::vec3(m[1]) / s.y, glm::vec3(m[2]) / s.z);
+    if (glm::determinant(r) < 0.0f) { s.x = -s.x; r[0] = -r[0]; } // mirror goes into the scale
+
+    glm::quat q = glm::normalize(glm::quat_cast(r));
+    out.px = m[3][0]; out.py = m[3][1]; out.pz = m[3][2];
+    out.rotXY   = glm::packSnorm2x16(glm::vec2(q.x, q.y));
+    out.rotZW   = glm::packSnorm2x16(glm::vec2(q.z, q.w));
+    out.scaleXY = glm::packHalf2x16(glm::vec2(s.x, s.y));
+    out.scaleZ  = glm::packHalf2x16(glm::vec2(s.z, 0.0f));
+
+    // round trip: catches shear (r not orthonormal) as well as precision loss
+    const glm::mat4 back = unpackInstance(out);
+    const float tol = 2e-3f * max(fabs(s.x), max(fabs(s.y), fabs(s.z)));
+    for (int c = 0; c < 3; ++c) {
+        for (int k = 0; k < 3; ++k) {
+            if (fabs(back[c][k] - m[c][k]) > tol) return false;
+        }
+    }
+    return true;
+}
+
+// Shared by the cull CS and the draw VS: the packed buffer replaces Matrices at binding 0.
+inline constexpr const char* kPackedInstanceGLSL = R"(
+layout(std430, binding = 0) readonly buffer PackedInstances { uint packedWords[]; };
+
+struct InstanceTrs { vec3 pos; mat3 rot; vec3 scale; };
+
+InstanceTrs loadInstance(uint i) {
+    uint b = 7u * i;
+    InstanceTrs t;
+    t.pos = uintBitsToFloat(uvec3(packedWords[b], packedWords[b + 1u], packedWords[b + 2u]));
+    vec4 q = normalize(vec4(unpackSnorm2x16(packedWords[b + 3u]), unpackSnorm2x16(packedWords[b + 4u])));
+    vec3 q2 = q.xyz * 2.0;
+    vec3 qq = q.xyz * q2, qw = q.w * q2;
+    float xy = q.x * q2.y, xz = q.x * q2.z, yz = q.y * q2.z;
+    t.rot = mat3(1.0 - qq.y - qq.z, xy + qw.z,         xz - qw.y,
+                 xy - qw.z,         1.0 - qq.x - qq.z, yz + qw.x,
+                 xz + qw.y,         yz - qw.x,         1.0 - qq.x - qq.y);
+    t.scale = vec3(unpackHalf2x16(packedWords[b + 5u]), unpackHalf2x16(packedWords[b + 6u]).x);
+    return t;
+}
+
+mat4 instanceMatrix(InstanceTrs t) {
+    return mat4(vec4(t.rot[0] * t.scale.x, 0.0), vec4(t.rot[1] * t.scale.y, 0.0),
+                vec4(t.rot[2] * t.scale.z, 0.0), vec4(t.pos, 1.0));
+}
+
+// inverse-transpose of R*S is R*S^-1
+mat3 instanceNormalMatrix(InstanceTrs t) {
+    return mat3(t.rot[0] / t.scale.x, t.rot[1] / t.scale.y, t.rot[2] / t.scale.z);
+}
+)";
@@ -0,0 +1,47 @@
+#pragma once
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+using namespace std;
+
+// Streaming buffer for data rewritten every frame (instance transforms).
+// With GL 4.4 / ARB_buffer_storage: one immutable buffer holding kRegions regions, mapped
+// once with PERSISTENT|COHERENT; the CPU writes region N while the GPU may still read N-1
+// and N-2, and a fence per region keeps the CPU from overtaking the GPU.
+// Without it: a single region re-specified (orphaned) and filled with glBufferSubData.
+class persistentRingClass {
+public:
+    static constexpr int kRegions = 3;
+
+    persistentRingClass() = default;
+    ~persistentRingClass() { release_(); }
+    persistentRingClass(const persistentRingClass&) = delete;
+    persistentRingClass& operator=(const persistentRingClass&) = delete;
+
+    // regions of `bytes`, each starting on a multiple of `alignment` (range-binding offset rule)
+    void allocate(GLenum target, size_t bytes, size_t alignment);
+
+    void* beginWrite();   // waits for the next region to be free; returns memory to fill
+    void  endWrite();     // fallback path uploads here; persistent path needs nothing (coherent)
+    void  fence();        // call after the last GL command that reads the region
+
+    GLuint buffer()      const { return buffer_; }
+    size_t offset()      const { return persistent_ ? size_t(head_) * stride_ : 0; }
+    size_t regionBytes() const { return bytes_; }
+    bool   persistent()  const { return persistent_; }
+    bool   valid()       const { return buffer_ != 0; }
+
+private:
+    void release_();
+
+    GLenum target_ = GL_ARRAY_BUFFER;
+    GLuint buffer_ = 0;
+    unsigned char* mapped_ = nullptr;
+    size_t bytes_  = 0;
+    size_t stride_ = 0;                     // bytes rounded up to the alignment
+    int    head_   = 0;                     // region being written / read this frame
+    bool   persistent_ = false;
+    GLsync fences_[kRegions] = {nullptr, nullptr, nullptr};
+    vector<unsigned char> staging_;         // fallback only
+};
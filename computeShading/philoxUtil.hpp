@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+using namespace std;
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Counter-based: the output is a pure function of (counter, key), so item i can draw its
+// numbers from counter {i, stream, 0, 0} on any thread, in any order, and every thread
+// count produces the same values.
+struct philox4x32 {
+    uint32_t v[4];
+
+    static philox4x32 generate(uint32_t c0, uint32_t c1, uint32_t c2, uint32_t c3, uint32_t k0, uint32_t k1) {
+        uint32_t c[4] = {c0, c1, c2, c3};
+        for (int round = 0; round < 10; ++round) {
+            if (round > 0) { k0 += 0x9E3779B9u; k1 += 0xBB67AE85u; }
+            const uint64_t p0 = uint64_t(0xD2511F53u) * c[0];
+            const uint64_t p1 = uint64_t(0xCD9E8D57u) * c[2];
+            const uint32_t n0 = uint32_t(p1 >> 32) ^ c[1] ^ k0;
+            const uint32_t n2 = uint32_t(p0 >> 32) ^ c[3] ^ k1;
+            c[0] = n0; c[1] = uint32_t(p1); c[2] = n2; c[3] = uint32_t(p0);
+        }
+        return {{c[0], c[1], c[2], c[3]}};
+    }
+
+    // [0, 1) with 24 bits, exactly representable as float
+    static float unit(uint32_t u) { return float(u >> 8) * (1.0f / 16777216.0f); }
+    float uniform(int i, float lo, float hi) const { return lo + (hi - lo) * unit(v[i]); }
+};
@@ -0,0 +1,220 @@
+#include "programCacheClass.hpp"
+#include "traceRecorderClass.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+using namespace std;
+
+namespace {
+struct BinaryHeader {
+    char     magic[8];        // "GLPROGBN"
+    uint32_t version;
+    uint32_t format;          // from glGetProgramBinary
+    uint64_t driverHash;
+    uint64_t sourceHash;
+    uint64_t bytes;
+};
+
+const char kMagic[8] = {'G','L','P','R','O','G','B','N'};
+
+uint64_t hashBytes(const void* data, size_t n, uint64_t h = 0xcbf29ce484222325ull) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) { h ^= p[i]; h *= 0x100000001b3ull; }
+    return h;
+}
+
+const char* stageName(GLenum stage) {
+    switch (stage) {
+    case GL_VERTEX_SHADER:   return "VS";
+    case GL_FRAGMENT_SHADER: return "FS";
+    case GL_COMPUTE_SHADER:  return "CS";
+    default:                 return "shader";
+    }
+}
+} // namespace
+
+bool   programCacheClass::diskEnabled_ = true;
+string programCacheClass::dir_ = ".shadercache";
+
+programCacheClass& programCacheClass::global() {
+    static programCacheClass cache;
+    return cache;
+}
+
+GLuint programCacheClass::graphics(const string& vs, const string& fs) {
+    const string sources[2] = { vs, fs };
+    const GLenum stages[2]  = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    return acquire_(string("VS\n") + vs + '\0' + "FS\n" + fs, sources, stages, 2);
+}
+
+GLuint programCacheClass::compute(const string& cs) {
+    const GLenum stage = GL_COMPUTE_SHADER;
+    return acquire_("CS\n" + cs, &cs, &stage, 1);
+}
+
+void programCacheClass::release(GLuint program) {
+    auto k = keys_.find(program);
+    if (k == keys_.end()) return;
+    auto e = programs_.find(k->second);
+    if (--e->second.refs > 0) return;
+    glDeleteProgram(program);
+    programs_.erase(e);
+    keys_.erase(k);
+}
+
+GLuint programCacheClass::acquire_(const string& key, const string* sources, const GLenum* stages, int count) {
+    auto it = programs_.find(key);
+    if (it != programs_.end()) {
+        ++it->second.refs;
+        ++stats_.shared;
+        return it->second.program;
+    }
+
+    TRACE_SCOPE("program create");
+    const auto t0 = chrono::steady_clock::now();
+    const bool disk = diskEnabled_ && binariesSupported_();
+    const uint64_t sourceHash = hashBytes(key.data(), key.size());
+    string path;
+    GLuint program = 0;
+    if (disk) {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.glprog", (unsigned long long)(sourceHash ^ driverHash_));
+        path = dir_ + "/" + name;
+        program = loadBinary_(path, sourceHash);
+        if (program) ++stats_.loaded;
+    }
+    if (!program) {
+        program = build_(sources, stages, count, disk);
+        if (!program) return 0;
+        ++stats_.compiled;
+        if (disk) saveBinary_(path, sourceHash, program);
+    }
+    stats_.ms += chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+
+    programs_[key] = Entry{program, 1};
+    keys_[program] = key;
+    return program;
+}
+
+GLuint programCacheClass::build_(const string* sources, const GLenum* stages, int count, bool retrievable) {
+    GLuint prog = glCreateProgram();
+    vector<GLuint> shaders;
+    bool ok = true;
+    for (int s = 0; s < count && ok; ++s) {
+        GLuint sh = glCreateShader(stages[s]);
+        const char* src = sources[s].c_str();
+        glShaderSource(sh, 1, &src, nullptr);
+        glCompileShader(sh);
+        GLint status = 0; glGetShaderiv(sh, GL_COMPILE_STATUS, &status);
+        if (!status) {
+            GLint len = 0; glGetShaderiv(sh, GL_INFO_LOG_LENGTH, &len);
+            string log(size_t(max(len, 1)), '\0'); glGetShaderInfoLog(sh, len, nullptr, log.data());
+            cerr << "Shader compile error (" << stageName(stages[s]) << "):\n" << log << "\n";
+            ok = false;
+        }
+        glAttachShader(prog, sh);
+        shaders.push_back(sh);
+    }
+    if (ok) {
+        if (retrievable) glProgramParameteri(prog, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(prog);
+        GLint status = 0; glGetProgramiv(prog, GL_LINK_STATUS, &status);
+        if (!status) {
+            GLint len = 0; glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &len);
+            string log(size_t(max(len, 1)), '\0'); glGetProgramInfoLog(prog, len, nullptr, log.data());
+            cerr << "Program link error:\n" << log << "\n";
+            ok = false;
+        }
+    }
+    for (GLuint sh : shaders) { glDetachShader(prog, sh); glDeleteShader(sh); }
+    if (!ok) { glDeleteProgram(prog); return 0; }
+    return prog;
+}
+
+// first use: needs a context, so the driver key and the directory are set up here
+bool programCacheClass::binariesSupported_() {
+    if (binarySupport_ >= 0) return binarySupport_ != 0;
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binarySupport_ = formats > 0 ? 1 : 0;
+    if (!binarySupport_) {
+        cout << "[shader] driver has no program binary formats, compiling every launch\n";
+        return false;
+    }
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION }) {
+        const char* s = reinterpret_cast<const char*>(glGetString(name));
+        if (s) driverHash_ = hashBytes(s, strlen(s), driverHash_ ^ 0x9e3779b97f4a7c15ull);
+    }
+    error_code ec;
+    filesystem::create_directories(dir_, ec);
+    if (ec) {
+        cerr << "[shader] can not create " << dir_ << " (" << ec.message() << "), binaries not kept\n";
+        binarySupport_ = 0;
+    }
+    return binarySupport_ != 0;
+}
+
+GLuint programCacheClass::loadBinary_(const string& path, uint64_t sourceHash) {
+    ifstream f(path, ios::binary);
+    if (!f) return 0;
+    BinaryHeader hdr{};
+    f.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+    if (!f || memcmp(hdr.magic, kMagic, 8) != 0 || hdr.version != kVersion ||
+        hdr.driverHash != driverHash_ || hdr.sourceHash != sourceHash || hdr.bytes == 0) {
+        return 0;
+    }
+    vector<char> blob(hdr.bytes);
+    f.read(blob.data(), streamsize(blob.size()));
+    if (!f) return 0;
+
+    GLuint prog = glCreateProgram();
+    glProgramBinary(prog, hdr.format, blob.data(), GLsizei(blob.size()));
+    GLint ok = 0; glGetProgramiv(prog, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        cout << "[shader] " << path << " rejected by the driver, recompiling\n";
+        glDeleteProgram(prog);
+        return 0;
+    }
+    return prog;
+}
+
+// temp file + rename, like the mesh cache: a crash never leaves a torn binary behind
+void programCacheClass::saveBinary_(const string& path, uint64_t sourceHash, GLuint program) {
+    GLint len = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &len);
+    if (len <= 0) return;
+    vector<char> blob(static_cast<size_t>(len));
+    GLenum format = 0;
+    GLsizei got = 0;
+    glGetProgramBinary(program, len, &got, &format, blob.data());
+    if (got <= 0) return;
+
+    BinaryHeader hdr{};
+    memcpy(hdr.magic, kMagic, 8);
+    hdr.version    = kVersion;
+    hdr.format     = format;
+    hdr.driverHash = driverHash_;
+    hdr.sourceHash = sourceHash;
+    hdr.bytes      = uint64_t(got);
+
+    const string tmp = path + ".tmp";
+    {
+        ofstream f(tmp, ios::binary | ios::trunc);
+        if (!f) return;
+        f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        f.write(blob.data(), got);
+        if (!f) { f.close(); remove(tmp.c_str()); return; }
+    }
+    if (rename(tmp.c_str(), path.c_str()) != 0) remove(tmp.c_str());
+}
+
+void programCacheClass::printStats() const {
+    cout << "[shader] " << stats_.compiled + stats_.loaded << " programs (" << stats_.loaded << " from binaries, "
+         << stats_.compiled << " compiled), " << stats_.shared << " shared, " << stats_.ms << " ms\n";
+}
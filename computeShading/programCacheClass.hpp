@@ -0,0 +1,59 @@
+#pragma once
+#include <GL/glew.h>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+// Every GL program goes through here. Programs are shared by source: all ModelObjects with
+// the same shading variant use one program, released when the last of them lets go.
+// Linked programs are also saved with glGetProgramBinary as "<dir>/<key>.glprog", keyed
+// by the sources and the driver (vendor, renderer, version), so a warm start loads the
+// binary instead of compiling GLSL. A rejected binary (driver update) just recompiles.
+// Render thread only, like the rest of GL.
+class programCacheClass {
+public:
+    static constexpr uint32_t kVersion = 1;
+
+    static programCacheClass& global();
+
+    // linked program or 0 (the compile / link log goes to cerr); call release() when done
+    GLuint graphics(const string& vs, const string& fs);
+    GLuint compute(const string& cs);
+    void   release(GLuint program);
+
+    static void setDiskCacheEnabled(bool on) { diskEnabled_ = on; }
+    static void setDirectory(const string& dir) { dir_ = dir; }
+
+    struct Stats {
+        size_t compiled = 0;   // GLSL compile + link
+        size_t loaded   = 0;   // from a binary on disk
+        size_t shared   = 0;   // handed out again without any work
+        double ms       = 0.0; // spent creating programs
+    };
+    const Stats& stats() const { return stats_; }
+    void printStats() const;
+
+private:
+    programCacheClass() = default;
+
+    struct Entry {
+        GLuint program = 0;
+        size_t refs = 0;
+    };
+
+    GLuint acquire_(const string& key, const string* sources, const GLenum* stages, int count);
+    GLuint build_(const string* sources, const GLenum* stages, int count, bool retrievable);
+    GLuint loadBinary_(const string& path, uint64_t sourceHash);
+    void   saveBinary_(const string& path, uint64_t sourceHash, GLuint program);
+    bool   binariesSupported_();
+
+    unordered_map<string, Entry> programs_; // keyed by stage tags + sources
+    unordered_map<GLuint, string> keys_;
+    uint64_t driverHash_ = 0;
+    int      binarySupport_ = -1;           // unknown until the first program
+    Stats    stats_;
+
+    static bool   diskEnabled_;
+    static string dir_;
+};
@@ -1,6 +1,22 @@
 #include "sceneBuilderClass.hpp"
+#include "traceRecorderClass.hpp"
+#include "parallelUtil.hpp"
+#include "packedInstanceUtil.hpp"
+#include "philoxUtil.hpp"
+#include "cpuCullerClass.hpp"
+#include "mortonUtil.hpp"
+#include "programCacheClass.hpp"
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <random>
+#include <cstddef>
+#include <cstring>
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#endif
 using namespace std;
 
 static void checkGLErrOnce(const char* where) {
@@ -10,74 +26,67 @@ static void checkGLErrOnce(const char* where) {
     }
 }
 
-static GLuint compileShader_(GLenum type, const char* src) { //jut for compute rn
-    GLuint sh = glCreateShader(type);
-    glShaderSource(sh, 1, &src, nullptr);
-    glCompileShader(sh);
-    GLint ok = 0; glGetShaderiv(sh, GL_COMPILE_STATUS, &ok);
-    if (!ok) {
-        GLint len = 0; glGetShaderiv(sh, GL_INFO_LOG_LENGTH, &len);
-        string log(len, '\0'); glGetShaderInfoLog(sh, len, nullptr, log.data());
-        cerr << "Shader compile failed:\n" << log << endl;
-        glDeleteShader(sh);
-        return 0;
-    }
-    return sh;
-}
-
-static GLuint linkProgram_(GLuint cs) { //attatch compute shader and program
-    GLuint prog = glCreateProgram();
-    glAttachShader(prog, cs);
-    glLinkProgram(prog);
-    GLint ok = 0; glGetProgramiv(prog, GL_LINK_STATUS, &ok);
-    if (!ok) {
-        GLint len = 0; glGetProgramiv(prog, GL_INFO_LOG_LENGTH, &len);
-        string log(len, '\0'); glGetProgramInfoLog(prog, len, nullptr, log.data());
-        cerr << "Program link failed:\n" << log << endl;
-        glDeleteProgram(prog);
-        return 0;
-    }
-    return prog;
-}
-
 //initialize window and camera
-sceneBuilderClass::sceneBuilderClass() {
+sceneBuilderClass::sceneBuilderClass(bool headless) : headless_(headless) {
+    TRACE_SCOPE("scene setup");
     windowInit(1280, 720, "Instanced Scene");
+    traceRecorderClass::global().calibrateGpuClock();
     setCamera(60.0f, 1280.0f / 720.0f, 0.1f, 1000.0f);
 
     //for compute shader
     buildCullProgram_();
-    // Allocate UBOs (frustum + aabb)
+    buildHiZProgram_();
+    buildBvhProgram_();
+    buildCompactionPrograms_();
+
+    stFrame_     = stats_.addStage("frame");
+    stUpdate_    = stats_.addStage("update");    // frustum UBO
+    stCull_      = stats_.addStage("cull");      // reset + phase-1 dispatch
+    stDraw_      = stats_.addStage("draw");      // phase-1 multi-draw
+    stOcclusion_ = stats_.addStage("occlusion"); // Hi-Z builds + phase 2
+    stReadback_  = stats_.addStage("readback");
+    stPresent_   = stats_.addStage("present");   // blit + swap
+    stStream_    = stats_.addStage("stream");    // animated transforms into the ring
+    // Allocate UBO (frustum); per-object AABBs live in an SSBO built with the scene buffers
     glGenBuffers(1, &uboFrustum_);
     glBindBuffer(GL_UNIFORM_BUFFER, uboFrustum_);
     glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::vec4) * 6, nullptr, GL_DYNAMIC_DRAW);
     glBindBufferBase(GL_UNIFORM_BUFFER, 4, uboFrustum_); // binding=4 in shader
-
-    glGenBuffers(1, &uboAabb_);
-    glBindBuffer(GL_UNIFORM_BUFFER, uboAabb_);
-    glBufferData(GL_UNIFORM_BUFFER, sizeof(glm::vec4) * 2, nullptr, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 5, uboAabb_); // binding=5 in shader
-
-    glm::vec4 packInit[2] = { glm::vec4(aabbMinOS_, 0.0f), glm::vec4(aabbMaxOS_, 0.0f) };
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(packInit), packInit);
-
 }
 
 GLFWwindow* sceneBuilderClass::windowInit(int width, int height, string name) {
+    TRACE_SCOPE("window + GL context");
+#ifdef GLFW_PLATFORM_NULL
+    // no display server at all (build machines): GLFW's null platform with an EGL context
+    if (headless_ && !getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY")) {
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+    }
+#endif
     if (!glfwInit()) { cerr << "GLFW init failed\n"; return nullptr; }
 
     // Compute shaders need OpenGL 4.3+
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    if (headless_) {
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE); // everything renders into sceneFbo_ anyway
+#ifdef GLFW_PLATFORM_NULL
+        if (glfwGetPlatform() == GLFW_PLATFORM_NULL) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+    }
 
     window = glfwCreateWindow(width, height, name.c_str(), nullptr, nullptr);
     if (!window) { cerr << "GLFW window creation failed\n"; return nullptr; }
     glfwMakeContextCurrent(window);
+    if (headless_) glfwSwapInterval(0);
 
     // Important for GLEW with core profile
     glewExperimental = GL_TRUE;
-    if (glewInit() != GLEW_OK) { cerr << "GLEW init failed\n"; return nullptr; }
+    GLenum glewErr = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    if (glewErr == GLEW_ERROR_NO_GLX_DISPLAY) glewErr = GLEW_OK; // EGL context: GL entry points are loaded, GLX ones are not needed
+#endif
+    if (glewErr != GLEW_OK) { cerr << "GLEW init failed\n"; return nullptr; }
 
     glEnable(GL_DEPTH_TEST);
     return window;
@@ -96,35 +105,577 @@ void sceneBuilderClass::cameraRotate(glm::mat4& view){
 
 //add generic model
 void sceneBuilderClass::addObject(const shared_ptr<ModelObject>& obj) {
+    // one shared VBO, so one vertex layout per scene
+    if (!objects_.empty() && obj->vertexFormat() != objects_.front()->vertexFormat()) {
+        cerr << "addObject: vertex format differs from the scene's, object skipped\n";
+        return;
+    }
     objects_.push_back(obj);
+    objectInstances_.emplace_back();
+    sceneDirty_ = true;
+}
+
+void sceneBuilderClass::addObjectAsync(const string& path, VertexFormat format, vector<glm::mat4> mats) {
+    if (!loader_) loader_ = make_unique<asyncMeshLoaderClass>();
+    asyncInstances_.push_back(move(mats));
+    loader_->request(path, format, asyncInstances_.size() - 1);
+}
+
+bool sceneBuilderClass::joinLoadedObjects_() {
+    if (!loader_) return false;
+    bool rebuild = false;
+    for (asyncMeshLoaderClass::Result& r : loader_->takeFinished()) {
+        const bool built = !sceneDirty_;
+        const size_t before = objects_.size();
+        addObject(r.object);
+        if (objects_.size() == before) continue; // rejected, addObject said why
+        objectInstances_.back() = move(asyncInstances_[r.tag]);
+        asyncInstances_[r.tag].clear(); // no longer pending (buildSceneBuffers_ reserves for the rest)
+        const bool appended = built && appendObject_(objects_.size() - 1);
+        if (appended) sceneDirty_ = false;
+        else rebuild = true;
+        cout << "[async] " << r.path << " joined after " << r.ms << " ms, " << objectInstances_.back().size()
+             << " instances, " << (appended ? "appended" : "needs a rebuild") << ", " << loader_->pending() << " still loading\n";
+    }
+    return rebuild;
+}
+
+// Streams objects_[i] (already added) into the room buildSceneBuffers_ left: geometry,
+// instances, its visible-list seed and meshlets go through the staging buffer, the
+// per-object tables and commands (a few KB) are re-uploaded. No existing data moves.
+bool sceneBuilderClass::appendObject_(size_t i) {
+    TRACE_SCOPE("append object");
+    ModelObject& o = *objects_[i];
+    vector<glm::mat4>& inst = objectInstances_[i];
+    const bool narrow = o.shortIndices();
+    const size_t n = inst.size(), first = allInstances_.size();
+    const size_t lods = size_t(o.lodCount());
+    size_t indexCount = 0;
+    for (int l = 0; l < o.lodCount(); ++l) indexCount += o.lodIndexCount(l);
+    const auto& objMeshlets = o.meshlets();
+
+    // anything that does not fit, or would change a layout sized for the old scene, repacks
+    if (i == 0 || !megaVbo_ || animator_) return false; // (the ring holds exactly maxInstances_)
+    if (vertexUsed_ + o.vertexCount() > vertexCapacity_) return false;
+    if (narrow ? shortIndexUsed_ + indexCount > shortIndexCapacity_ : wideIndexUsed_ + indexCount > wideIndexCapacity_) return false;
+    if (first + n > instanceCapacity_ || visibleUsed_ + n * lods > visibleCapacity_) return false;
+    if (!objMeshlets.empty() && (meshletCount_ + objMeshlets.size() > meshletCapacity_ ||
+                                 objMeshlets.size() > maxMeshlets_ || !meshletSection_[narrow ? 0 : 1])) {
+        return false; // the queue holds meshletDrawCapacity_ / maxMeshlets_ instances
+    }
+    if (mortonOrder_) sortByMorton(inst); // harmless if a repack follows, it sorts again
+    if (normalMode_ == NormalMode::UniformScale && !allUniformScale(inst.data(), n)) return false;
+    vector<PackedInstance> packed(packed_ ? n : 0);
+    for (size_t k = 0; k < packed.size(); ++k) {
+        if (!packInstance(inst[k], packed[k])) return false;
+    }
+
+    const size_t stride = o.vertexStride();
+    const size_t wideBase = (shortIndexCapacity_ * sizeof(GLushort) + 3) / sizeof(GLuint);
+    size_t iOff = narrow ? shortIndexUsed_ : wideBase + wideIndexUsed_;
+    vector<StagedCopy> copies;
+    copies.push_back({megaVbo_, GLintptr(vertexUsed_ * stride), GLsizeiptr(o.vertexCount() * stride), o.vertexStream()});
+
+    ObjectLod objLods{};
+    objLods.firstCommand  = static_cast<GLuint>(narrow ? size_t(shortCommandCount_) : commands_.size());
+    objLods.lodCount      = static_cast<GLuint>(lods);
+    objLods.firstInstance = static_cast<GLuint>(first);
+    vector<DrawElementsIndirectCommand> cmds(lods);
+    vector<GLushort> narrowed;
+    if (narrow) narrowed.reserve(indexCount);
+    size_t visOff = visibleUsed_;
+    for (int l = 0; l < o.lodCount(); ++l) {
+        if (narrow) {
+            narrowed.insert(narrowed.end(), o.lodIndexData(l), o.lodIndexData(l) + o.lodIndexCount(l));
+        } else {
+            copies.push_back({megaEbo_, GLintptr(iOff * sizeof(GLuint)), GLsizeiptr(o.lodIndexCount(l) * sizeof(GLuint)), o.lodIndexData(l)});
+        }
+        DrawElementsIndirectCommand& cmd = cmds[size_t(l)];
+        cmd.count         = static_cast<GLuint>(o.lodIndexCount(l));
+        cmd.instanceCount = l == 0 ? static_cast<GLuint>(n) : 0u;
+        cmd.firstIndex    = static_cast<GLuint>(iOff);
+        cmd.baseVertex    = static_cast<GLuint>(vertexUsed_);
+        cmd.baseInstance  = static_cast<GLuint>(visOff);
+        objLods.error[l] = o.lodError(l);
+        iOff   += o.lodIndexCount(l);
+        visOff += n;
+    }
+    if (narrow) {
+        copies.push_back({megaEbo_, GLintptr(shortIndexUsed_ * sizeof(GLushort)), GLsizeiptr(narrowed.size() * sizeof(GLushort)), narrowed.data()});
+    }
+
+    // instances: same per-instance streams buildSceneBuffers_ writes, at the end of each
+    if (packed_) copies.push_back({ssboMatrices_, GLintptr(first * sizeof(PackedInstance)), GLsizeiptr(n * sizeof(PackedInstance)), packed.data()});
+    else         copies.push_back({ssboMatrices_, GLintptr(first * sizeof(glm::mat4)), GLsizeiptr(n * sizeof(glm::mat4)), inst.data()});
+    vector<NormalMatrix> normals(normalMode_ == NormalMode::Precomputed ? n : 0);
+    if (!normals.empty()) {
+        computeNormalMatrices(inst.data(), normals.data(), 0, n);
+        copies.push_back({ssboNormals_, GLintptr(first * sizeof(NormalMatrix)), GLsizeiptr(n * sizeof(NormalMatrix)), normals.data()});
+    }
+    const vector<GLuint> owner(n, static_cast<GLuint>(i));
+    copies.push_back({ssboInstObj_, GLintptr(first * sizeof(GLuint)), GLsizeiptr(n * sizeof(GLuint)), owner.data()});
+    vector<GLuint> seed(n); // LOD 0 draws every instance until the first cull (no-cull fallback)
+    for (size_t k = 0; k < n; ++k) seed[k] = static_cast<GLuint>(first + k);
+    copies.push_back({ssboVisible_, GLintptr(visibleUsed_ * sizeof(GLuint)), GLsizeiptr(n * sizeof(GLuint)), seed.data()});
+
+    objLods.firstMeshlet = static_cast<GLuint>(meshletCount_);
+    objLods.meshletCount = static_cast<GLuint>(objMeshlets.size());
+    vector<meshletBuilderClass::Meshlet> meshlets(objMeshlets);
+    for (meshletBuilderClass::Meshlet& m : meshlets) {
+        m.firstIndex += cmds[0].firstIndex;
+        m.baseVertex  = static_cast<GLuint>(vertexUsed_);
+        m.wide        = narrow ? 0u : 1u;
+    }
+    if (!meshlets.empty()) {
+        copies.push_back({ssboMeshlets_, GLintptr(meshletCount_ * sizeof(meshletBuilderClass::Meshlet)),
+                          GLsizeiptr(meshlets.size() * sizeof(meshletBuilderClass::Meshlet)), meshlets.data()});
+    }
+    stagedUpload_(copies);
+
+    // CPU mirrors; 16-bit commands stay in front, so the 32-bit objects' commands shift
+    commands_.insert(commands_.begin() + objLods.firstCommand, cmds.begin(), cmds.end());
+    if (narrow) {
+        for (ObjectLod& other : objectLods_) {
+            if (other.firstCommand >= objLods.firstCommand) other.firstCommand += objLods.lodCount;
+        }
+        shortCommandCount_ += GLsizei(lods);
+    }
+    objectLods_.push_back(objLods);
+    allInstances_.insert(allInstances_.end(), inst.begin(), inst.end());
+    instObj_.insert(instObj_.end(), owner.begin(), owner.end());
+    maxInstances_ = static_cast<GLsizei>(allInstances_.size());
+    bindInstanceObjects_(); // binding 1 grows to cover them
+    vertexUsed_ += o.vertexCount();
+    (narrow ? shortIndexUsed_ : wideIndexUsed_) += indexCount;
+    visibleUsed_ = visOff;
+    meshletCount_ += meshlets.size();
+
+    o.setInstanceShading(normalMode_, packed_);
+    uploadObjectTables_();
+    uploadCommands_();
+    cpuCullerValid_ = false;
+    bvhValid_ = false;
+    // hizValid_ stays: last frame's depth still occludes correctly, new instances it rejects get phase 2
+    return true;
+}
+
+// Copies through one staging buffer: reused without a sync when the fence of its previous
+// copies has signalled, orphaned otherwise, so an append never waits on the GPU.
+void sceneBuilderClass::stagedUpload_(const vector<StagedCopy>& copies) {
+    GLsizeiptr total = 0;
+    for (const StagedCopy& c : copies) total += (c.bytes + 15) & ~GLsizeiptr(15);
+    if (total == 0) return;
+
+    bool idle = false;
+    if (stagingFence_) {
+        const GLenum r = glClientWaitSync(stagingFence_, 0, 0);
+        idle = r == GL_ALREADY_SIGNALED || r == GL_CONDITION_SATISFIED;
+        glDeleteSync(stagingFence_);
+        stagingFence_ = nullptr;
+    }
+    if (!stagingBuf_) glGenBuffers(1, &stagingBuf_);
+    glBindBuffer(GL_COPY_READ_BUFFER, stagingBuf_);
+    if (!idle || total > stagingBytes_) {
+        stagingBytes_ = max(stagingBytes_, total);
+        glBufferData(GL_COPY_READ_BUFFER, stagingBytes_, nullptr, GL_STREAM_DRAW);
+    }
+    auto* dst = static_cast<unsigned char*>(glMapBufferRange(GL_COPY_READ_BUFFER, 0, total,
+        GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+    if (!dst) { // driver refused the mapping: plain sub-data uploads
+        for (const StagedCopy& c : copies) {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, c.dst);
+            glBufferSubData(GL_COPY_WRITE_BUFFER, c.offset, c.bytes, c.data);
+        }
+        return;
+    }
+    GLintptr at = 0;
+    for (const StagedCopy& c : copies) {
+        if (c.bytes > 0) memcpy(dst + at, c.data, size_t(c.bytes));
+        at += (c.bytes + 15) & ~GLsizeiptr(15);
+    }
+    glUnmapBuffer(GL_COPY_READ_BUFFER);
+    at = 0;
+    for (const StagedCopy& c : copies) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, c.dst);
+        if (c.bytes > 0) glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, at, c.offset, c.bytes);
+        at += (c.bytes + 15) & ~GLsizeiptr(15);
+    }
+    stagingFence_ = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void sceneBuilderClass::bindInstanceObjects_() {
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, ssboInstObj_, 0,
+                      GLsizeiptr(sizeof(GLuint) * size_t(max<GLsizei>(maxInstances_, 1))));
 }
 
 //should this be with models or is vector<glm::mat4>& fine?
 void sceneBuilderClass::setInstanceTransforms(const vector<glm::mat4>& mats) {
-    allInstances_ = mats;
+    for (auto& inst : objectInstances_) inst = mats;
+    sceneDirty_ = true;
+}
+
+void sceneBuilderClass::setInstanceTransforms(const shared_ptr<ModelObject>& obj, const vector<glm::mat4>& mats) {
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        if (objects_[i] == obj) {
+            objectInstances_[i] = mats;
+            sceneDirty_ = true;
+            return;
+        }
+    }
+    cerr << "setInstanceTransforms: object was never added to the scene\n";
+}
+
+// average distance between instances that are adjacent in memory (lower = more coherent)
+static double meanNeighbourDistance(const vector<glm::mat4>& mats) {
+    double sum = 0.0;
+    for (size_t i = 1; i < mats.size(); ++i) sum += glm::length(glm::vec3(mats[i][3]) - glm::vec3(mats[i - 1][3]));
+    return mats.size() > 1 ? sum / double(mats.size() - 1) : 0.0;
+}
+
+// Packs every mesh (all of its LODs) into one VBO/EBO, every object's instances into one
+// matrix SSBO, and builds one indirect command per (object, LOD) so the frame is one
+// dispatch + one draw. Each command owns a visibleIndices region of the object's size.
+void sceneBuilderClass::buildSceneBuffers_() {
+    TRACE_SCOPE("build scene buffers");
+    sceneDirty_ = false;
+    hizValid_ = false; // last frame's depth belongs to the old instances
+    cpuCullerValid_ = false;
+    bvhValid_ = false;
+
+    // --- geometry: concatenate meshes, remember where each one starts
+    // 16-bit meshes go first in both the index buffer and the command list, so each index
+    // type is one multi-draw; the 32-bit range starts on a 4-byte boundary
+    size_t totalVerts = 0, shortIdx = 0, wideIdx = 0, commandCount = 0;
+    shortCommandCount_ = 0;
+    for (auto& o : objects_) {
+        totalVerts += o->vertexCount();
+        for (int l = 0; l < o->lodCount(); ++l) (o->shortIndices() ? shortIdx : wideIdx) += o->lodIndexCount(l);
+        commandCount += size_t(o->lodCount());
+        if (o->shortIndices()) shortCommandCount_ += GLsizei(o->lodCount());
+    }
+    // while loads are pending, leave room to append them (appendObject_): their instances are
+    // known, their meshes are not, so each index section gets the whole scene's count again
+    const bool spare = loader_ && loader_->pending() > 0;
+    size_t pendingInstances = 0;
+    if (spare) {
+        for (const auto& inst : asyncInstances_) pendingInstances += inst.size(); // joined ones are cleared
+    }
+    vertexUsed_     = totalVerts; vertexCapacity_     = spare ? totalVerts * 2 : totalVerts;
+    shortIndexUsed_ = shortIdx;   shortIndexCapacity_ = spare ? shortIdx * 2 + wideIdx : shortIdx;
+    wideIndexUsed_  = wideIdx;    wideIndexCapacity_  = spare ? wideIdx * 2 + shortIdx : wideIdx;
+    const size_t shortBytes = (shortIndexCapacity_ * sizeof(GLushort) + 3) & ~size_t(3);
+    const VertexFormat format = objects_.empty() ? VertexFormat::Float : objects_.front()->vertexFormat();
+    const size_t stride = objects_.empty() ? sizeof(float) * 6 : objects_.front()->vertexStride();
+
+    if (!drawVao_) glGenVertexArrays(1, &drawVao_);
+    if (!megaVbo_) glGenBuffers(1, &megaVbo_);
+    if (!megaEbo_) glGenBuffers(1, &megaEbo_);
+
+    glBindVertexArray(drawVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, megaVbo_);
+    glBufferData(GL_ARRAY_BUFFER, vertexCapacity_ * stride, nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, megaEbo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortBytes + wideIndexCapacity_ * sizeof(GLuint), nullptr, GL_STATIC_DRAW);
+
+    // --- instances: one contiguous range per object, optionally in Morton order
+    if (mortonOrder_) {
+        TRACE_SCOPE("morton sort");
+        const auto t0 = chrono::steady_clock::now();
+        double before = 0.0, after = 0.0;
+        size_t total = 0;
+        for (auto& inst : objectInstances_) {
+            before += meanNeighbourDistance(inst) * double(inst.size());
+            sortByMorton(inst);
+            after += meanNeighbourDistance(inst) * double(inst.size());
+            total += inst.size();
+        }
+        const double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+        cout << "[scene] morton order: " << total << " instances in " << ms << " ms, mean neighbour distance "
+             << before / double(max<size_t>(total, 1)) << " -> " << after / double(max<size_t>(total, 1)) << "\n";
+    }
+    allInstances_.clear();
+    instObj_.clear();
+    commands_.assign(commandCount, DrawElementsIndirectCommand{});
+    objectLods_.assign(objects_.size(), ObjectLod{});
+    vector<meshletBuilderClass::Meshlet> meshlets; // every object's, index ranges made absolute
+    size_t maxMeshlets = 0;
+    bool meshletTypes[2] = {false, false}; // 16-bit, 32-bit meshes with meshlets
+    vector<GLushort> narrowed;
+
+    // firstIndex counts elements of the command's own index type
+    size_t vOff = 0, visOff = 0;
+    size_t shortOff = 0, wideOff = shortBytes / sizeof(GLuint);
+    size_t shortCmd = 0, wideCmd = size_t(shortCommandCount_);
+    for (size_t i = 0; i < objects_.size(); ++i) {
+        const ModelObject& o = *objects_[i];
+        glBufferSubData(GL_ARRAY_BUFFER, vOff * stride, o.vertexCount() * stride, o.vertexStream());
+        const bool narrow = o.shortIndices();
+        size_t& iOff = narrow ? shortOff : wideOff;
+        size_t& cmdAt = narrow ? shortCmd : wideCmd;
+
+        // LOD 0 starts out drawing every instance (the no-cull fallback), the rest nothing
+        ObjectLod& lods = objectLods_[i];
+        lods.firstCommand  = static_cast<GLuint>(cmdAt);
+        lods.lodCount      = static_cast<GLuint>(o.lodCount());
+        lods.firstInstance = static_cast<GLuint>(allInstances_.size());
+        for (int l = 0; l < o.lodCount(); ++l) {
+            if (narrow) {
+                narrowed.assign(o.lodIndexData(l), o.lodIndexData(l) + o.lodIndexCount(l));
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iOff * sizeof(GLushort), narrowed.size() * sizeof(GLushort), narrowed.data());
+            } else {
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, iOff * sizeof(GLuint), o.lodIndexCount(l) * sizeof(GLuint), o.lodIndexData(l));
+            }
+            DrawElementsIndirectCommand cmd;
+            cmd.count         = static_cast<GLuint>(o.lodIndexCount(l));
+            cmd.instanceCount = l == 0 ? static_cast<GLuint>(objectInstances_[i].size()) : 0u;
+            cmd.firstIndex    = static_cast<GLuint>(iOff);
+            cmd.baseVertex    = static_cast<GLuint>(vOff);
+            cmd.baseInstance  = static_cast<GLuint>(visOff);
+            commands_[cmdAt++] = cmd;
+            lods.error[l] = o.lodError(l);
+            iOff   += o.lodIndexCount(l);
+            visOff += objectInstances_[i].size();
+        }
+        lods.firstMeshlet = static_cast<GLuint>(meshlets.size());
+        lods.meshletCount = static_cast<GLuint>(o.meshlets().size());
+        for (meshletBuilderClass::Meshlet m : o.meshlets()) {
+            m.firstIndex += commands_[lods.firstCommand].firstIndex;
+            m.baseVertex  = static_cast<GLuint>(vOff);
+            m.wide        = narrow ? 0u : 1u;
+            meshlets.push_back(m);
+        }
+        maxMeshlets = max(maxMeshlets, o.meshlets().size());
+        if (!o.meshlets().empty()) meshletTypes[narrow ? 0 : 1] = true;
+
+        allInstances_.insert(allInstances_.end(), objectInstances_[i].begin(), objectInstances_[i].end());
+        instObj_.insert(instObj_.end(), objectInstances_[i].size(), static_cast<GLuint>(i));
+
+        vOff += o.vertexCount();
+    }
     maxInstances_ = static_cast<GLsizei>(allInstances_.size());
+    instanceCapacity_ = allInstances_.size() + pendingInstances;
+    visibleUsed_ = visOff;
+    visibleCapacity_ = visOff + pendingInstances * size_t(ModelObject::kMaxLods);
+    meshletCount_ = meshlets.size();
+    meshletCapacity_ = spare ? meshlets.size() * 2 : meshlets.size();
+    maxMeshlets_ = maxMeshlets;
+    // the queue is sized so that every queued instance can emit all of its meshlets
+    meshletDrawCapacity_  = maxMeshlets ? max<GLuint>(kMeshletDrawCapacity, GLuint(maxMeshlets)) : 0u;
+    meshletQueueCapacity_ = maxMeshlets ? meshletDrawCapacity_ / GLuint(maxMeshlets) : 0u;
+    for (int k = 0; k < 2; ++k) meshletSection_[k] = meshletTypes[k] ? meshletDrawCapacity_ : 0u;
+    cout << "[scene] vertex buffer: " << (totalVerts * stride) / (1024.0 * 1024.0) << " MiB ("
+         << (format == VertexFormat::Quantized ? "quantized" : "float") << ", " << stride << " B/vertex)\n";
+    cout << "[scene] index buffer: " << (shortBytes + wideIdx * sizeof(GLuint)) / (1024.0 * 1024.0) << " MiB ("
+         << shortIdx << " 16-bit, " << wideIdx << " 32-bit indices)\n";
+    if (spare) {
+        cout << "[scene] room for " << loader_->pending() << " streamed-in meshes: " << pendingInstances << " instances, "
+             << vertexCapacity_ - vertexUsed_ << " vertices, " << shortIndexCapacity_ - shortIndexUsed_ << " + "
+             << wideIndexCapacity_ - wideIndexUsed_ << " indices\n";
+    }
+
+    // pos (0), normal (1)
+    ModelObject::setVertexAttribs(format);
+
+    // packed TRS: 28 B per instance instead of 64, when every transform is a plain TRS
+    packed_ = false;
+    vector<PackedInstance> packed;
+    if (packedRequested_ && animator_) {
+        cerr << "[scene] packed instances need static transforms, using mat4\n";
+    } else if (packedRequested_) {
+        packed.resize(allInstances_.size());
+        atomic<bool> ok{true};
+        parallelFor(packed.size(), [&](size_t b, size_t e) {
+            for (size_t i = b; i < e && ok.load(memory_order_relaxed); ++i) {
+                if (!packInstance(allInstances_[i], packed[i])) ok.store(false, memory_order_relaxed);
+            }
+        });
+        packed_ = ok.load();
+        if (!packed_) cerr << "[scene] some transforms are not translate*rotate*scale, using mat4\n";
+    }
+    if (packed_ != cullPacked_) buildCullProgram_(); // cull CS reads the same layout as the VS
 
     // Create/resize SSBOs for inputs/outputs
     if (!ssboMatrices_) glGenBuffers(1, &ssboMatrices_);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboMatrices_);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * maxInstances_, allInstances_.data(), GL_DYNAMIC_DRAW);
+    if (packed_) {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(PackedInstance) * instanceCapacity_, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(PackedInstance) * packed.size(), packed.data());
+    } else {
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::mat4) * instanceCapacity_, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(glm::mat4) * allInstances_.size(), allInstances_.data());
+    }
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboMatrices_); // binding=0
+    const size_t instanceStride = packed_ ? sizeof(PackedInstance) : sizeof(glm::mat4);
+    cout << "[scene] instance buffer: " << (instanceStride * size_t(maxInstances_)) / (1024.0 * 1024.0) << " MiB ("
+         << (packed_ ? "packed TRS" : "mat4") << ", " << instanceStride << " B/instance)\n";
+
+    // normal matrices: chosen once per build, so the VS never inverts per vertex
+    normalMode_ = pickNormalMode_();
+    for (auto& o : objects_) o->setInstanceShading(normalMode_, packed_);
+    programCacheClass::global().printStats();
+    if (normalMode_ == NormalMode::Precomputed && !animator_) {
+        vector<NormalMatrix> normals(allInstances_.size());
+        parallelFor(normals.size(), [&](size_t b, size_t e) {
+            computeNormalMatrices(allInstances_.data(), normals.data(), b, e);
+        });
+        if (!ssboNormals_) glGenBuffers(1, &ssboNormals_);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboNormals_);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(NormalMatrix) * instanceCapacity_, nullptr, GL_STATIC_DRAW);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(NormalMatrix) * normals.size(), normals.data());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, ssboNormals_); // binding=8
+    }
+    cout << "[scene] normal matrices: "
+         << (normalMode_ == NormalMode::Precomputed  ? "precomputed per instance" :
+             normalMode_ == NormalMode::UniformScale ? "mat3(model), all instances uniform-scale" :
+             normalMode_ == NormalMode::FromTrs      ? "R * inverse(S) from the packed TRS" :
+                                                       "inverse per vertex") << "\n";
+
+    // streaming: three regions of the same size, offsets honouring the SSBO alignment;
+    // with precomputed normals each region is [matrices | normal matrices]
+    if (animator_) {
+        GLint align = 256;
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &align);
+        const size_t matBytes = sizeof(glm::mat4) * size_t(maxInstances_);
+        size_t regionBytes = matBytes;
+        ringNormalsOffset_ = 0;
+        if (normalMode_ == NormalMode::Precomputed) {
+            ringNormalsOffset_ = (matBytes + size_t(align) - 1) / size_t(align) * size_t(align);
+            regionBytes = ringNormalsOffset_ + sizeof(NormalMatrix) * size_t(maxInstances_);
+        }
+        animScratch_.resize(size_t(maxInstances_)); // cached copy for normals / the CPU culler
+        instanceRing_.allocate(GL_SHADER_STORAGE_BUFFER, regionBytes, size_t(align));
+        cout << "[scene] streaming " << maxInstances_ << " transforms through a "
+             << (instanceRing_.persistent() ? "persistent-mapped ring" : "orphaned buffer (no ARB_buffer_storage)") << "\n";
+    }
 
+    if (!ssboInstObj_) glGenBuffers(1, &ssboInstObj_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboInstObj_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * instanceCapacity_, nullptr, GL_STATIC_DRAW);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(GLuint) * instObj_.size(), instObj_.data());
+    bindInstanceObjects_(); // binding=1
+
+    // Seed every LOD 0 region with its object's instances so the no-cull fallback draws them all.
+    // Second half holds the occlusion phase-2 lists (commands offset by visibleCapacity_),
+    // then the meshlet queue.
+    vector<GLuint> identity(visibleCapacity_ * 2 + meshletQueueCapacity_);
+    for (const ObjectLod& lods : objectLods_) {
+        GLuint* dst = identity.data() + commands_[lods.firstCommand].baseInstance;
+        for (GLuint k = 0; k < commands_[lods.firstCommand].instanceCount; ++k) dst[k] = lods.firstInstance + k;
+    }
     if (!ssboVisible_) glGenBuffers(1, &ssboVisible_);
     glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboVisible_);
-    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * maxInstances_, nullptr, GL_DYNAMIC_DRAW);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, identity.size() * sizeof(GLuint), identity.data(), GL_DYNAMIC_DRAW);
     glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboVisible_); // binding=2
+    cout << "[scene] " << commands_.size() << " draw commands for " << objects_.size() << " objects, visible lists "
+         << (identity.size() * sizeof(GLuint)) / (1024.0 * 1024.0) << " MiB\n";
+
+    // occlusion re-test list: {groupsX, groupsY, groupsZ, count} header + indices
+    if (!ssboRetest_) glGenBuffers(1, &ssboRetest_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboRetest_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * (4 + instanceCapacity_), nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, ssboRetest_); // binding=6
+
+    uploadObjectTables_();
+
+    if (!ssboMeshlets_) glGenBuffers(1, &ssboMeshlets_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboMeshlets_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, max<size_t>(sizeof(meshletBuilderClass::Meshlet) * meshletCapacity_, 16),
+                 nullptr, GL_STATIC_DRAW);
+    if (!meshlets.empty()) {
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(meshletBuilderClass::Meshlet) * meshlets.size(), meshlets.data());
+    }
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, ssboMeshlets_); // binding=16
+
+    // draw counts header (16 B keeps the commands' offset aligned) + one command section per
+    // index type in use; queue header
+    if (!meshletDrawBuf_) glGenBuffers(1, &meshletDrawBuf_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletDrawBuf_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER,
+                 sizeof(GLuint) * 4 + sizeof(DrawElementsIndirectCommand) * (meshletSection_[0] + meshletSection_[1]),
+                 nullptr, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, meshletDrawBuf_); // binding=17
+    if (!ssboMeshletQueue_) glGenBuffers(1, &ssboMeshletQueue_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboMeshletQueue_);
+    const GLuint emptyQueue[4] = {0, 1, 1, 0};
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(emptyQueue), emptyQueue, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 18, ssboMeshletQueue_); // binding=18
+    if (!meshlets.empty()) {
+        cout << "[scene] " << meshlets.size() << " meshlets, queue of " << meshletQueueCapacity_ << " instances / "
+             << meshletDrawCapacity_ << " draws" << (GLEW_ARB_indirect_parameters ? "" : " (no ARB_indirect_parameters: full-size draw)") << "\n";
+    }
 
-    if (!ssboCounter_) glGenBuffers(1, &ssboCounter_);
-    glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, ssboCounter_);
-    GLuint zero = 0;
-    glBufferData(GL_ATOMIC_COUNTER_BUFFER, sizeof(GLuint), &zero, GL_DYNAMIC_DRAW);
-    glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 3, ssboCounter_); // binding=3
+    // visibleIndices doubles as the per-instance attribute that picks worldMats[] in the VS
+    glBindBuffer(GL_ARRAY_BUFFER, ssboVisible_);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 1, GL_UNSIGNED_INT, sizeof(GLuint), reinterpret_cast<void*>(0));
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
 
-  for (auto& obj : objects_) {
-        obj->initIndirect(maxInstances_);
+    uploadCommands_();
+}
+
+// Per-object tables the cull CS and VS index by object: AABB (binding 5), dequant offset/scale
+// for quantized positions (binding 7) and the LOD / meshlet ranges (binding 15).
+void sceneBuilderClass::uploadObjectTables_() {
+    objectAabbs_.clear();
+    vector<glm::vec4> dequant;
+    for (const auto& o : objects_) {
+        objectAabbs_.push_back(glm::vec4(hasModelBounds_ ? aabbMinOS_ : o->bboxMin(), 0.0f));
+        objectAabbs_.push_back(glm::vec4(hasModelBounds_ ? aabbMaxOS_ : o->bboxMax(), 0.0f));
+        dequant.push_back(glm::vec4(o->bboxMin(), 0.0f));
+        dequant.push_back(glm::vec4(o->quantScale(), 0.0f));
     }
 
+    if (!ssboObjects_) glGenBuffers(1, &ssboObjects_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboObjects_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4) * objectAabbs_.size(), objectAabbs_.data(), GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, ssboObjects_); // binding=5
+
+    if (!ssboDequant_) glGenBuffers(1, &ssboDequant_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboDequant_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(glm::vec4) * dequant.size(), dequant.data(), GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, ssboDequant_); // binding=7
+
+    if (!ssboObjectLods_) glGenBuffers(1, &ssboObjectLods_);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboObjectLods_);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ObjectLod) * objectLods_.size(), objectLods_.data(), GL_STATIC_DRAW);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, ssboObjectLods_); // binding=15
+}
+
+// Indirect commands: live, reset template (count 0) and draw-everything template, for both
+// phases; readback slots sized to match (any sample in flight is dropped).
+void sceneBuilderClass::uploadCommands_() {
+    const GLsizeiptr cmdBytes = sizeof(DrawElementsIndirectCommand) * commands_.size();
+    if (!cmdAll_) glGenBuffers(1, &cmdAll_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdAll_);
+    glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, commands_.data(), GL_STATIC_DRAW);
+
+    if (!cmdBuffer_) glGenBuffers(1, &cmdBuffer_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdBuffer_);
+    glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, commands_.data(), GL_DYNAMIC_DRAW);
+
+    vector<DrawElementsIndirectCommand> zeroed = commands_;
+    for (auto& c : zeroed) c.instanceCount = 0;
+    if (!cmdReset_) glGenBuffers(1, &cmdReset_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdReset_);
+    glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, zeroed.data(), GL_STATIC_DRAW);
+
+    for (auto& c : zeroed) c.baseInstance += static_cast<GLuint>(visibleCapacity_);
+    if (!cmdReset2_) glGenBuffers(1, &cmdReset2_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdReset2_);
+    glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, zeroed.data(), GL_STATIC_DRAW);
+    if (!cmdBuffer2_) glGenBuffers(1, &cmdBuffer2_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdBuffer2_);
+    glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes, zeroed.data(), GL_DYNAMIC_DRAW);
+
+    // readback slots hold both command arrays, the re-test header, the meshlet queue header
+    // and the meshlet draw counts
+    for (int k = 0; k < kReadbackSlots; ++k) {
+        if (readbackFence_[k]) { glDeleteSync(readbackFence_[k]); readbackFence_[k] = nullptr; }
+        if (!readbackBuf_[k]) glGenBuffers(1, &readbackBuf_[k]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuf_[k]);
+        glBufferData(GL_COPY_WRITE_BUFFER, cmdBytes * 2 + sizeof(GLuint) * 10, nullptr, GL_STREAM_READ);
+    }
 }
 
 void sceneBuilderClass::bindCameraPointers() {
@@ -135,6 +686,15 @@ void sceneBuilderClass::bindCameraPointers() {
     }
 }
 
+// true once per key press (edge-triggered)
+bool sceneBuilderClass::keyToggled_(int key) {
+    bool down = glfwGetKey(window, key) == GLFW_PRESS;
+    bool& latch = keyLatch_[key];
+    bool fired = down && !latch;
+    latch = down;
+    return fired;
+}
+
 void sceneBuilderClass::run() {
     if (!window) return;
 
@@ -142,37 +702,29 @@ void sceneBuilderClass::run() {
     glEnable(GL_DEPTH_TEST);
     glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
 
-    // Ensure base bindings are set
-    if (uboFrustum_)   glBindBufferBase(GL_UNIFORM_BUFFER,        4, uboFrustum_);
-    if (uboAabb_)      glBindBufferBase(GL_UNIFORM_BUFFER,        5, uboAabb_);
-    if (ssboMatrices_) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboMatrices_);
-    if (ssboVisible_)  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboVisible_);
-    if (ssboCounter_)  glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 3, ssboCounter_);
-
-    // Cached workgroup count (recompute if maxInstances_ changes)
-    auto groupsPerDispatch = [this]() -> GLuint {
-        return maxInstances_ ? (GLuint)((maxInstances_ + 127) / 128) : 0u;
-    };
-    GLuint cachedGroups = groupsPerDispatch();
+    if (sceneDirty_) buildSceneBuffers_();
 
     // Debug toggles
     bool   disableCulling = false;           // press 'C' to toggle
-    double startTime      = glfwGetTime();
 
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
 
-        // Toggle culling with 'C'
-        if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
-            static bool latch = false;
-            if (!latch) { disableCulling = !disableCulling; latch = true; }
-        } else {
-            static bool latch = true; latch = false;
+        // Toggle frustum culling with 'C', occlusion culling with 'O'
+        if (keyToggled_(GLFW_KEY_C)) disableCulling = !disableCulling;
+        if (keyToggled_(GLFW_KEY_O)) {
+            occlusionCulling_ = !occlusionCulling_;
+            hizValid_ = false; // pyramid was not kept up to date while off
+            cerr << "[cull] occlusion " << (occlusionCulling_ ? "on" : "off") << "\n";
+        }
+        if (keyToggled_(GLFW_KEY_G) && cullProgram_) {
+            cpuCulling_ = !cpuCulling_;
+            cerr << "[cull] " << (cpuCulling_ ? string("cpu (") + cpuCullerClass::simdPath() + ")" : string("gpu")) << "\n";
+        }
+        if (keyToggled_(GLFW_KEY_B)) {
+            setHierarchicalCulling(!bvhEnabled_);
+            cerr << "[cull] bvh " << (bvhEnabled_ ? (animator_ ? "on (ignored while animating)" : "on") : "off") << "\n";
         }
-
-        // If instance count changed elsewhere, refresh groups
-        GLuint neededGroups = groupsPerDispatch();
-        if (neededGroups != cachedGroups) cachedGroups = neededGroups;
 
         // camera default
         if (glm::length(glm::vec3(view[3])) == 0.0f) {
@@ -181,113 +733,982 @@ void sceneBuilderClass::run() {
                                glm::vec3(0.0f, 1.0f, 0.0f));
         }
 
-        bindCameraPointers(); // dont need anywhere else
+        animTime_ = glfwGetTime();
+        stats_.beginFrame();
+        bool drawn;
+        {
+            frameStatsClass::Scope t(stats_, stFrame_);
+            drawn = renderFrame_(disableCulling);
+            if (drawn) present_();
+            else glfwSwapBuffers(window); // minimised
+        }
+        stats_.endFrame();
+        traceRecorderClass::global().counter("visible", lastVisibleCount_);
+
+        // rolling summary (counts lag the GPU by a couple of frames)
+        if (drawn && stats_.printIfDue(cerr, statsInterval_)) {
+            cerr << "[cull] objects=" << objects_.size()
+                 << " instances=" << maxInstances_
+                 << " visible~=" << lastVisibleCount_
+                 << " occluded~=" << lastOccludedCount_
+                 << " recovered~=" << lastRecoveredCount_
+                 << " lods~=" << lastLodCounts_[0] << "/" << lastLodCounts_[1] << "/" << lastLodCounts_[2] << "/" << lastLodCounts_[3]
+                 << " meshlets~=" << lastMeshletDraws_ << " in " << lastMeshletInstances_ << " instances"
+                 << " culling=" << !disableCulling
+                 << " backend=" << (useCpuCulling_() ? "cpu" : "gpu") << (bvhActive_() ? "+bvh" : "")
+                 << " occlusion=" << occlusionCulling_ << "\n";
+            checkGLErrOnce("frame");
+        }
+    }
+}
+
+// Fixed-length run for perf regressions: the camera orbits the instance bounds once,
+// so every run sees the same frames regardless of wall-clock speed.
+void sceneBuilderClass::runBenchmark(int frameCount) {
+    if (!window || frameCount <= 0) return;
+
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
+    if (sceneDirty_) buildSceneBuffers_();
+
+    // keep every frame so the final summary covers the whole run
+    stats_.setWindow(size_t(frameCount));
+    uint64_t printed = stats_.resolvedFrames(); // frames of earlier runs are already out
+    auto printResolved = [&]() {
+        for (; printed < stats_.resolvedFrames(); ++printed) {
+            const size_t back = size_t(stats_.resolvedFrames() - printed);
+            if (back > stats_.recordCount()) continue; // fell out of the window
+            const auto& r = stats_.record(stats_.recordCount() - back);
+            cout << "[bench] frame " << r.frame << " cpu " << r.cpuMs[stFrame_] << " ms gpu "
+                 << r.gpuMs[stFrame_] << " ms visible~" << lastVisibleCount_ << "\n";
+        }
+    };
+
+    // culling efficiency: counters lag, so skip the frames before the first readback lands
+    double visibleSum = 0.0;
+    double lodSum[ModelObject::kMaxLods] = {};
+    double meshletInstSum = 0.0, meshletDrawSum = 0.0;
+    int    visibleFrames = 0;
+
+    const auto wall0 = chrono::steady_clock::now();
+    for (int f = 0; f < frameCount; ++f) {
+        glfwPollEvents();
+        view = orbitView_(f, frameCount);
+        animTime_ = f / 60.0; // animation follows the frame index, like the camera
+
+        stats_.beginFrame();
+        {
+            frameStatsClass::Scope t(stats_, stFrame_);
+            const bool drawn = renderFrame_(false);
+            if (drawn && !headless_) present_();
+            else glFlush();
+        }
+        stats_.endFrame();
+        printResolved();
+        if (f >= kReadbackSlots && debugReadback_) {
+            visibleSum += lastVisibleCount_;
+            for (int l = 0; l < ModelObject::kMaxLods; ++l) lodSum[l] += lastLodCounts_[l];
+            meshletInstSum += lastMeshletInstances_;
+            meshletDrawSum += lastMeshletDraws_;
+            ++visibleFrames;
+        }
+    }
+    stats_.flush();
+    printResolved();
+    glFinish();
+    const double wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - wall0).count();
+
+    cout << "[bench] " << frameCount << " frames, " << maxInstances_ << " instances, "
+         << targetW_ << "x" << targetH_ << (headless_ ? " headless" : "") << "\n";
+    stats_.printSummary(cout);
+    if (visibleFrames > 0 && maxInstances_ > 0) {
+        const double avg = visibleSum / visibleFrames;
+        cout << "[bench] visible avg " << size_t(avg) << " / " << maxInstances_
+             << " (" << 100.0 * avg / maxInstances_ << "%)" << (occlusionCulling_ ? ", occlusion on" : "") << "\n";
+        cout << "[bench] visible per lod";
+        for (int l = 0; l < ModelObject::kMaxLods; ++l) cout << " " << size_t(lodSum[l] / visibleFrames);
+        cout << " (pixel error " << lodPixelError_ << ")\n";
+        if (meshletInstSum > 0.0) {
+            cout << "[bench] meshlet instances avg " << size_t(meshletInstSum / visibleFrames)
+                 << ", meshlet draws avg " << size_t(meshletDrawSum / visibleFrames) << "\n";
+        }
+    }
+    cout << "[bench] wall " << wallMs << " ms (" << frameCount * 1000.0 / max(wallMs, 1e-6) << " fps)\n";
+}
+
+// Camera for frame `frame` of `frameCount`: one slightly raised orbit around the instances.
+glm::mat4 sceneBuilderClass::orbitView_(int frame, int frameCount) const {
+    glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+    for (const glm::mat4& m : allInstances_) {
+        lo = glm::min(lo, glm::vec3(m[3]));
+        hi = glm::max(hi, glm::vec3(m[3]));
+    }
+    if (allInstances_.empty()) { lo = glm::vec3(-1.0f); hi = glm::vec3(1.0f); }
+
+    float meshExtent = 0.0f;
+    for (auto& o : objects_) meshExtent = max(meshExtent, o->maxExtent());
+
+    const glm::vec3 center = 0.5f * (lo + hi);
+    const float radius = 0.75f * glm::length(hi - lo) + 2.0f * meshExtent + 1.0f;
+    const float a = 6.2831853f * float(frame) / float(frameCount);
+    const glm::vec3 eye = center + glm::vec3(sin(a) * radius, 0.25f * radius, cos(a) * radius);
+    return glm::lookAt(eye, center, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// Cull + draw one frame into sceneFbo_ with the current view
+bool sceneBuilderClass::renderFrame_(bool disableCulling) {
+    // streamed-in meshes: appended in place, or a repack when one did not fit
+    if (joinLoadedObjects_()) buildSceneBuffers_();
+    const GLsizeiptr cmdBytes = sizeof(DrawElementsIndirectCommand) * commands_.size();
+
+    bindCameraPointers(); // dont need anywhere else
 
-        int w, h; glfwGetFramebufferSize(window, &w, &h);
-        glViewport(0, 0, w, h);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    int w, h; glfwGetFramebufferSize(window, &w, &h);
+    if (w <= 0 || h <= 0) return false;
+    ensureRenderTargets_(w, h);
 
-        // Update frustum planes each frame
-        glm::vec4 planes[6];
+    if (bvhEnabled_ && !animator_ && !bvhValid_) buildBvh_();
+    if (useCpuCulling_() && !cpuCullerValid_) buildCpuCuller_();
+    streamInstances_();
+
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFbo_);
+    glViewport(0, 0, w, h);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Update frustum planes each frame
+    glm::vec4 planes[6];
+    {
+        frameStatsClass::Scope t(stats_, stUpdate_);
         updateFrustumPlanes_(planes);
         if (uboFrustum_) {
             glBindBuffer(GL_UNIFORM_BUFFER, uboFrustum_);
             glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(planes), planes);
         }
+    }
+    const glm::mat4 viewProj = projection * view;
+    const bool occlusion = occlusionCulling_ && !disableCulling && hizProgram_;
+
+    if (useCpuCulling_() && maxInstances_ > 0) {
+        // --- CPU CULLING PATH (frustum only) ---
+        {
+            frameStatsClass::Scope t(stats_, stCull_);
+            cpuCull_(planes, !disableCulling);
+        }
+        hizValid_ = false; // the pyramid is not maintained on this path
+        frameStatsClass::Scope t(stats_, stDraw_);
+        drawCommands_(cmdBuffer_);
+    } else if (cullProgram_ && maxInstances_ > 0) {
+        // --- GPU CULLING PATH ---
+        // Phase 1: frustum + last frame's Hi-Z. Occlusion rejects go to a re-test list.
+        // Close-up instances of meshlet meshes are queued instead of drawn; their meshlets
+        // are culled and drawn right after, before the Hi-Z build sees this phase's depth.
+        {
+            frameStatsClass::Scope t(stats_, stCull_);
+            dispatchCull_(0, occlusion && hizValid_, !disableCulling, hizViewProj_);
+            if (meshletsActive_()) dispatchMeshlets_();
+        }
+        {
+            frameStatsClass::Scope t(stats_, stDraw_);
+            drawCommands_(cmdBuffer_);
+            if (meshletsActive_()) drawMeshlets_();
+        }
 
-        // Default: draw all instances
-        GLuint visCount = static_cast<GLuint>(maxInstances_);
+        if (occlusion) {
+            frameStatsClass::Scope t(stats_, stOcclusion_);
+            // Phase 2: re-test the rejects against this frame's depth so far
+            buildHiZ_();
+            hizViewProj_ = viewProj;
+            dispatchCull_(1, true, true, viewProj);
+            drawCommands_(cmdBuffer2_);
+
+            // pyramid for next frame's phase 1
+            buildHiZ_();
+            hizValid_ = true;
+        }
 
-        if (!disableCulling && cullProgram_ && maxInstances_ > 0 && cachedGroups > 0) {
-            // --- GPU CULLING PATH ---
+        if (debugReadback_) {
+            frameStatsClass::Scope t(stats_, stReadback_);
+            queueVisibleReadback_(occlusion);
+            pollVisibleReadback_();
+        }
+    } else if (cmdAll_) {
+        // --- NO CULLING PATH → draw everything (visibleIndices holds identity) ---
+        frameStatsClass::Scope t(stats_, stDraw_);
+        glBindBuffer(GL_COPY_READ_BUFFER,  cmdAll_);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, cmdBuffer_);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, cmdBytes);
+        drawCommands_(cmdBuffer_);
+    }
+    if (animator_) instanceRing_.fence(); // region is free once this frame's cull + draws finish
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return true;
+}
 
-            // Reset counter
-            if (ssboCounter_) {
-                GLuint zero = 0;
-                glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, ssboCounter_);
-                glBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(GLuint), &zero);
-                glBindBufferBase(GL_ATOMIC_COUNTER_BUFFER, 3, ssboCounter_);
-            }
+// Writes this frame's transforms into the next ring region (no allocation, no driver copy)
+void sceneBuilderClass::streamInstances_() {
+    if (!animator_ || !instanceRing_.valid() || maxInstances_ <= 0) return;
+    frameStatsClass::Scope t(stats_, stStream_);
+    auto* region = static_cast<unsigned char*>(instanceRing_.beginWrite());
+    auto* dst = reinterpret_cast<glm::mat4*>(region);
+    const bool normals = normalMode_ == NormalMode::Precomputed;
+    const bool cpuCull = useCpuCulling_();
+    if (!normals && !cpuCull) {
+        animator_(animTime_, allInstances_.data(), dst, size_t(maxInstances_));
+    } else {
+        // the mapping may be write-combined: animate into cached memory, then one pass
+        // per chunk stores the matrices and their normal matrices without reading back
+        animator_(animTime_, allInstances_.data(), animScratch_.data(), animScratch_.size());
+        auto* normalDst = reinterpret_cast<NormalMatrix*>(region + ringNormalsOffset_);
+        parallelFor(animScratch_.size(), [&](size_t b, size_t e) {
+            copy(animScratch_.begin() + b, animScratch_.begin() + e, dst + b);
+            if (normals) computeNormalMatrices(animScratch_.data(), normalDst, b, e);
+        });
+    }
+    instanceRing_.endWrite();
+    if (cpuCull) cpuCuller_.updateTransforms(animScratch_.data());
+}
 
-            // Bind bases (harmless if already bound)
-            if (ssboMatrices_) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboMatrices_);
-            if (ssboVisible_)  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboVisible_);
-            if (uboFrustum_)   glBindBufferBase(GL_UNIFORM_BUFFER,        4, uboFrustum_);
-            if (uboAabb_)      glBindBufferBase(GL_UNIFORM_BUFFER,        5, uboAabb_);
-
-            glUseProgram(cullProgram_);
-            glDispatchCompute(cachedGroups, 1, 1);
-
-            // Ensure the writes are visible to subsequent CPU reads and draw
-            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT |
-                            GL_ATOMIC_COUNTER_BARRIER_BIT  |
-                            GL_BUFFER_UPDATE_BARRIER_BIT);
-
-            // Read visible count
-            visCount = 0;
-            if (ssboCounter_) {
-                glBindBuffer(GL_ATOMIC_COUNTER_BUFFER, ssboCounter_);
-                glGetBufferSubData(GL_ATOMIC_COUNTER_BUFFER, 0, sizeof(GLuint), &visCount);
-            }
+// Same inputs as the cull CS: instance -> object and each object's AABB (kept by buildSceneBuffers_).
+void sceneBuilderClass::buildCpuCuller_() {
+    TRACE_SCOPE("cpu culler setup");
+    cpuCuller_.setInstances(allInstances_.data(), instObj_.data(), allInstances_.size(),
+                            objectAabbs_.data(), objects_.size(), bvhActive_() ? &bvh_ : nullptr);
+    cpuCullerValid_ = true;
+    cout << "[scene] cpu culler: " << cpuCuller_.instanceCount() << " instances, "
+         << cpuCullerClass::simdPath() << ", " << workerCount() << " threads"
+         << (bvhActive_() ? ", bvh" : "") << "\n";
+}
 
-            // Debug print for first few secs
-            if (glfwGetTime() - startTime < 4.0) {
-                std::cerr << "[dbg] cullProgram=" << (int)(cullProgram_ != 0)
-                          << " maxInstances=" << maxInstances_
-                          << " groups=" << cachedGroups
-                          << " visible=" << visCount
-                          << " culling=" << (!disableCulling) << "\n";
-                checkGLErrOnce("after compute");
-            }
+// Per-object LBVH over the current (static) instances, uploaded for the treelet pass.
+void sceneBuilderClass::buildBvh_() {
+    TRACE_SCOPE("instance bvh build");
+    bvh_.build(allInstances_.data(), instObj_.data(), allInstances_.size(), objectAabbs_.data());
+    bvhValid_ = true;
+    cpuCullerValid_ = false; // rebuilt in BVH slot order
+
+    auto upload = [](GLuint& buf, GLsizeiptr bytes, const void* data, GLuint binding) {
+        if (!buf) glGenBuffers(1, &buf);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, buf);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, max<GLsizeiptr>(bytes, 16), data, data ? GL_STATIC_DRAW : GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buf);
+    };
+    vector<GLuint> roots;
+    roots.reserve(bvh_.treelets().size());
+    for (const auto& t : bvh_.treelets()) roots.push_back(t.root);
+    upload(ssboBvhNodes_, GLsizeiptr(sizeof(instanceBvhClass::Node) * bvh_.nodes().size()), bvh_.nodes().data(), 9);
+    upload(ssboBvhTreelets_, GLsizeiptr(sizeof(GLuint) * roots.size()), roots.data(), 10);
+    upload(ssboBvhLeaves_, GLsizeiptr(sizeof(GLuint) * (4 + 2 * bvh_.leafCount())), nullptr, 11);
+    upload(ssboBvhOrder_, GLsizeiptr(sizeof(GLuint) * bvh_.order().size()), bvh_.order().data(), 12);
+
+    cout << "[scene] instance bvh: " << bvh_.nodes().size() << " nodes, " << bvh_.leafCount() << " leaves of <= "
+         << instanceBvhClass::kLeafSize << ", " << bvh_.treelets().size() << " treelets, "
+         << bvh_.buildMs() << " ms\n";
+}
+
+float sceneBuilderClass::lodScale_() const {
+    if (lodPixelError_ <= 0.0f || targetH_ <= 0) return 0.0f;
+    return projection[1][1] * 0.5f * float(targetH_) / lodPixelError_;
+}
+
+// CPU twin of the cull shader's selectLod(): the coarsest LOD whose error, seen from the
+// nearest point of the instance's bounding sphere, stays within one (scaled) pixel
+static int selectLod(const sceneBuilderClass::ObjectLod& lods, const glm::mat4& M, const glm::vec3& minOS,
+                     const glm::vec3& maxOS, const glm::vec3& eye, float lodScale) {
+    if (lodScale <= 0.0f || lods.lodCount < 2) return 0;
+    const glm::vec3 c0(M[0]), c1(M[1]), c2(M[2]);
+    const float scale = sqrt(max(glm::dot(c0, c0), max(glm::dot(c1, c1), glm::dot(c2, c2))));
+    const glm::vec3 center(M * glm::vec4(0.5f * (minOS + maxOS), 1.0f));
+    const float radius = 0.5f * glm::length(maxOS - minOS) * scale;
+    const float pixelsPerUnit = lodScale * scale / max(glm::distance(center, eye) - radius, 1e-3f);
+    int lod = 0;
+    for (int l = 1; l < int(lods.lodCount); ++l) {
+        if (lods.error[l] * pixelsPerUnit > 1.0f) break;
+        lod = l;
+    }
+    return lod;
+}
+
+// CPU replacement for dispatchCull_(0, ...): writes the same visibleIndices regions and
+// instanceCounts, so drawCommands_() is unchanged. The count is exact, no readback lag.
+void sceneBuilderClass::cpuCull_(const glm::vec4 planes[6], bool cullEnabled) {
+    lastVisibleCount_ = static_cast<GLuint>(cpuCuller_.cull(planes, cullEnabled));
+    lastOccludedCount_ = lastRecoveredCount_ = 0;
+    lastMeshletInstances_ = lastMeshletDraws_ = 0;
+    fill(begin(lastLodCounts_), end(lastLodCounts_), 0u);
+
+    const vector<uint32_t>& visible = cpuCuller_.visible();
+    const glm::mat4* mats = animator_ ? animScratch_.data() : allInstances_.data();
+    const glm::vec3 eye(glm::inverse(view)[3]);
+    const float lodScale = lodScale_();
+    vector<DrawElementsIndirectCommand> cmds = commands_;
+    for (auto& c : cmds) c.instanceCount = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboVisible_);
+    for (size_t o = 0; o < objectLods_.size(); ++o) {
+        const ObjectLod& lods = objectLods_[o];
+        const GLuint n = cpuCuller_.objectVisible(o);
+        const uint32_t* src = visible.data() + cpuCuller_.objectStart(o);
+        if (n == 0) continue;
+        if (lods.lodCount < 2 || lodScale <= 0.0f) {
+            cmds[lods.firstCommand].instanceCount = n;
+            lastLodCounts_[0] += n;
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, GLintptr(sizeof(GLuint) * cmds[lods.firstCommand].baseInstance),
+                            GLsizeiptr(sizeof(GLuint) * n), src);
+            continue;
+        }
+
+        // bucket the object's list by LOD, keeping its order within each bucket
+        const glm::vec3 minOS = hasModelBounds_ ? aabbMinOS_ : objects_[o]->bboxMin();
+        const glm::vec3 maxOS = hasModelBounds_ ? aabbMaxOS_ : objects_[o]->bboxMax();
+        cpuLods_.resize(n);
+        parallelFor(n, [&](size_t b, size_t e) {
+            for (size_t k = b; k < e; ++k) cpuLods_[k] = uint8_t(selectLod(lods, mats[src[k]], minOS, maxOS, eye, lodScale));
+        });
+        GLuint offset[ModelObject::kMaxLods + 1] = {};
+        for (GLuint k = 0; k < n; ++k) ++offset[cpuLods_[k] + 1];
+        for (GLuint l = 0; l < lods.lodCount; ++l) {
+            cmds[lods.firstCommand + l].instanceCount = offset[l + 1];
+            lastLodCounts_[l] += offset[l + 1];
+            offset[l + 1] += offset[l];
+        }
+        cpuLodLists_.resize(n);
+        GLuint cursor[ModelObject::kMaxLods];
+        copy(offset, offset + ModelObject::kMaxLods, cursor);
+        for (GLuint k = 0; k < n; ++k) cpuLodLists_[cursor[cpuLods_[k]]++] = src[k];
+        for (GLuint l = 0; l < lods.lodCount; ++l) {
+            const DrawElementsIndirectCommand& c = cmds[lods.firstCommand + l];
+            if (c.instanceCount == 0) continue;
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, GLintptr(sizeof(GLuint) * c.baseInstance),
+                            GLsizeiptr(sizeof(GLuint) * c.instanceCount), cpuLodLists_.data() + offset[l]);
+        }
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdBuffer_);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, 0, GLsizeiptr(sizeof(DrawElementsIndirectCommand) * cmds.size()), cmds.data());
+}
+
+void sceneBuilderClass::bindMatrices_() {
+    const bool normals = normalMode_ == NormalMode::Precomputed;
+    if (animator_ && instanceRing_.valid()) {
+        const GLintptr base = GLintptr(instanceRing_.offset());
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, instanceRing_.buffer(),
+                          base, GLsizeiptr(sizeof(glm::mat4) * size_t(maxInstances_)));
+        if (normals) {
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 8, instanceRing_.buffer(), base + GLintptr(ringNormalsOffset_),
+                              GLsizeiptr(sizeof(NormalMatrix) * size_t(maxInstances_)));
+        }
+    } else {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, ssboMatrices_);
+        if (normals) glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, ssboNormals_);
+    }
+}
+
+// Animated transforms are unknown ahead of time, so they always get the precomputed stream.
+NormalMode sceneBuilderClass::pickNormalMode_() const {
+    if (packed_) return NormalMode::FromTrs;
+    if (!precomputeNormals_) return NormalMode::Inverse;
+    if (!animator_ && allUniformScale(allInstances_.data(), allInstances_.size())) return NormalMode::UniformScale;
+    return NormalMode::Precomputed;
+}
+
+void sceneBuilderClass::setInstanceAnimator(InstanceAnimator animator) {
+    animator_ = move(animator);
+    sceneDirty_ = true; // (re)allocates the ring at the current instance count
+}
+
+// present the offscreen target
+void sceneBuilderClass::present_() {
+    frameStatsClass::Scope t(stats_, stPresent_);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFbo_);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, targetW_, targetH_, 0, 0, targetW_, targetH_, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    glfwSwapBuffers(window);
+}
+
+// phase 0: every instance, phase 1: the re-test list written by phase 0
+void sceneBuilderClass::dispatchCull_(int phase, bool occlusion, bool cullEnabled, const glm::mat4& hizViewProj) {
+    const GLsizeiptr cmdBytes = sizeof(DrawElementsIndirectCommand) * commands_.size();
+    GLuint cmdBuf = phase == 0 ? cmdBuffer_ : cmdBuffer2_;
+
+    // Reset every instanceCount on the GPU timeline (no CPU round trip)
+    glBindBuffer(GL_COPY_READ_BUFFER,  phase == 0 ? cmdReset_ : cmdReset2_);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, cmdBuf);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, cmdBytes);
+    if (phase == 0) {
+        const GLuint header[4] = {0, 1, 1, 0}; // empty dispatch, empty list
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboRetest_);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboMeshletQueue_);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+    }
+
+    // Bind bases (harmless if already bound)
+    bindMatrices_();
+    bindInstanceObjects_();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboVisible_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, cmdBuf);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, ssboObjects_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, ssboRetest_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, ssboObjectLods_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 18, ssboMeshletQueue_);
+    if (uboFrustum_) glBindBufferBase(GL_UNIFORM_BUFFER, 4, uboFrustum_);
+
+    // ordered compaction covers phase 0 over every instance; the BVH and phase 1 append
+    const bool bvh = phase == 0 && bvhActive_() && bvhProgram_;
+    const bool ordered = phase == 0 && !bvh && orderedCompaction_ &&
+                         cullOrderedProgram_ && scanProgram_ && scatterProgram_;
+    const GLuint groups = GLuint((maxInstances_ + 127) / 128);
+    if (ordered && compactionCapacity_ < size_t(maxInstances_)) {
+        compactionCapacity_ = size_t(maxInstances_);
+        if (!ssboGroupSums_) glGenBuffers(1, &ssboGroupSums_);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboGroupSums_);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * 4 * groups, nullptr, GL_DYNAMIC_COPY);
+        if (!ssboLocalScan_) glGenBuffers(1, &ssboLocalScan_);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboLocalScan_);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(GLuint) * 2 * compactionCapacity_, nullptr, GL_DYNAMIC_COPY);
+    }
+
+    // With culling toggled off the shader still runs so visibleIndices stays valid
+    // (both cull programs share explicit uniform locations)
+    glUseProgram(ordered ? cullOrderedProgram_ : cullProgram_);
+    glUniform1i(uCullEnabled_, cullEnabled ? 1 : 0);
+    glUniform1i(uPhase_, phase);
+    glUniform1i(uOcclusion_, occlusion ? 1 : 0);
+    glUniformMatrix4fv(uHiZViewProj_, 1, GL_FALSE, glm::value_ptr(hizViewProj));
+    glUniform2f(uHiZSize_, float(targetW_), float(targetH_));
+    glUniform1i(uHiZLevels_, hizLevels_);
+    glUniform1i(uHiZ_, 0);
+    const glm::vec3 eye(glm::inverse(view)[3]);
+    glUniform3f(uCameraPos_, eye.x, eye.y, eye.z);
+    glUniform1f(uLodScale_, lodScale_());
+    // culling off is the reference mode: nothing goes to the meshlet pass, which always culls
+    const bool meshlets = phase == 0 && cullEnabled && meshletsActive_();
+    glUniform1f(uMeshletScale_, meshlets ? projection[1][1] * 0.5f * float(targetH_) / meshletMinPixels_ : 0.0f);
+    glUniform1ui(uMeshletBase_, GLuint(visibleCapacity_ * 2));
+    glUniform1ui(uMeshletCapacity_, meshletQueueCapacity_);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, hizTex_);
+    if (!ordered) glUniform1i(uBvh_, bvh ? 1 : 0); // not referenced by the ordered variant
+
+    if (bvh) {
+        // treelet pass: surviving leaves + one workgroup per leaf as dispatch args
+        const GLuint header[4] = {0, 1, 1, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, ssboBvhLeaves_);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(header), header);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, ssboBvhNodes_);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, ssboBvhTreelets_);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, ssboBvhLeaves_);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, ssboBvhOrder_);
+        glUseProgram(bvhProgram_);
+        glUniform1i(uBvhCullEnabled_, cullEnabled ? 1 : 0);
+        glDispatchCompute(GLuint((bvh_.treelets().size() + 63) / 64), 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+
+        glUseProgram(cullProgram_);
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ssboBvhLeaves_);
+        glDispatchComputeIndirect(0);
+    } else if (ordered) {
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 13, ssboGroupSums_);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, ssboLocalScan_);
+        glDispatchCompute(groups, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glUseProgram(scanProgram_);
+        glUniform1ui(uScanGroupCount_, groups);
+        glDispatchCompute(1, 1, 1);
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+        glUseProgram(scatterProgram_);
+        glDispatchCompute(groups, 1, 1);
+    } else if (phase == 0) {
+        glDispatchCompute(groups, 1, 1);
+    } else {
+        // group count was accumulated by phase 0
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ssboRetest_);
+        glDispatchComputeIndirect(0);
+    }
+
+    // visibleIndices is read as a vertex attribute, commands / retest header as indirect args
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT |
+                    GL_COMMAND_BARRIER_BIT            |
+                    GL_SHADER_STORAGE_BARRIER_BIT     |
+                    GL_BUFFER_UPDATE_BARRIER_BIT);
+}
+
+// One draw for every object: each command selects its mesh and visible range
+void sceneBuilderClass::drawCommands_(GLuint cmdBuf) {
+    if (objects_.empty() || !cmdBuf) return;
+    objects_.front()->bindProgram(); // every object shares kDefaultVS/kDefaultFS
+    bindMatrices_();
+    glBindVertexArray(drawVao_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, cmdBuf);
+    // 16-bit meshes' commands come first (see buildSceneBuffers_)
+    const GLsizei wide = static_cast<GLsizei>(commands_.size()) - shortCommandCount_;
+    if (shortCommandCount_ > 0) {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, nullptr, shortCommandCount_, 0);
+    }
+    if (wide > 0) {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT,
+                                    reinterpret_cast<const void*>(sizeof(DrawElementsIndirectCommand) * size_t(shortCommandCount_)),
+                                    wide, 0);
+    }
+    glBindVertexArray(0);
+}
+
+// (Re)creates the offscreen colour/depth target and the matching Hi-Z pyramid.
+void sceneBuilderClass::ensureRenderTargets_(int w, int h) {
+    if (sceneFbo_ && w == targetW_ && h == targetH_) return;
+    TRACE_SCOPE("render targets");
+    targetW_ = w; targetH_ = h;
+    hizValid_ = false;
+
+    if (!sceneFbo_) glGenFramebuffers(1, &sceneFbo_);
+    if (sceneColor_) glDeleteTextures(1, &sceneColor_);
+    if (sceneDepth_) glDeleteTextures(1, &sceneDepth_);
+    if (hizTex_)     glDeleteTextures(1, &hizTex_);
+
+    glGenTextures(1, &sceneColor_);
+    glBindTexture(GL_TEXTURE_2D, sceneColor_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, w, h);
+
+    glGenTextures(1, &sceneDepth_);
+    glBindTexture(GL_TEXTURE_2D, sceneDepth_);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, w, h);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFbo_);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, sceneColor_, 0);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,  GL_TEXTURE_2D, sceneDepth_, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        cerr << "[fbo] scene framebuffer incomplete\n";
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // full mip chain, level 0 matches the depth buffer texel for texel
+    hizLevels_ = 1;
+    for (int m = max(w, h); m > 1; m >>= 1) ++hizLevels_;
+    glGenTextures(1, &hizTex_);
+    glBindTexture(GL_TEXTURE_2D, hizTex_);
+    glTexStorage2D(GL_TEXTURE_2D, hizLevels_, GL_R32F, w, h);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Copies the current depth into Hi-Z level 0, then max-reduces level by level.
+void sceneBuilderClass::buildHiZ_() {
+    if (!hizProgram_ || !hizTex_) return;
+    glUseProgram(hizProgram_);
+    glActiveTexture(GL_TEXTURE0);
+    glUniform1i(uHizSrc_, 0);
+
+    int lw = targetW_, lh = targetH_;
+    for (int level = 0; level < hizLevels_; ++level) {
+        if (level == 0) {
+            glBindTexture(GL_TEXTURE_2D, sceneDepth_);
+            glUniform1i(uHizCopy_, 1);
+            glUniform1i(uHizSrcLevel_, 0);
         } else {
-            // --- NO CULLING PATH → draw everything ---
-            if (glfwGetTime() - startTime < 4.0) {
-                std::cerr << "[dbg] culling disabled or cullProgram==0, drawing all instances ("
-                          << maxInstances_ << ")\n";
-            }
+            glBindTexture(GL_TEXTURE_2D, hizTex_);
+            glUniform1i(uHizCopy_, 0);
+            glUniform1i(uHizSrcLevel_, level - 1);
+            lw = max(1, lw >> 1); lh = max(1, lh >> 1);
         }
+        glBindImageTexture(0, hizTex_, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((GLuint)((lw + 7) / 8), (GLuint)((lh + 7) / 8), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void sceneBuilderClass::buildHiZProgram_() {
+    TRACE_SCOPE("hiz shader compile");
+    static const char* kHiZCS = R"(#version 430
+layout(local_size_x = 8, local_size_y = 8) in;
+
+uniform sampler2D uSrc;     // depth texture (copy pass) or the pyramid itself
+uniform int uSrcLevel;
+uniform int uCopy;          // 1 = level 0, straight copy of the depth buffer
+layout(r32f, binding = 0) writeonly uniform image2D uDst;
+
+void main() {
+    ivec2 dst     = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 dstSize = imageSize(uDst);
+    if (dst.x >= dstSize.x || dst.y >= dstSize.y) return;
+
+    if (uCopy != 0) {
+        imageStore(uDst, dst, vec4(texelFetch(uSrc, dst, 0).r));
+        return;
+    }
+
+    // 2x2 max; on odd-sized sources the last row/column also folds in the extra texel
+    ivec2 srcSize = textureSize(uSrc, uSrcLevel);
+    ivec2 base    = dst * 2;
+    int ex = (dst.x == dstSize.x - 1 && (srcSize.x & 1) != 0) ? 2 : 1;
+    int ey = (dst.y == dstSize.y - 1 && (srcSize.y & 1) != 0) ? 2 : 1;
+    float d = 0.0;
+    for (int y = 0; y <= ey; ++y)
+        for (int x = 0; x <= ex; ++x)
+            d = max(d, texelFetch(uSrc, min(base + ivec2(x, y), srcSize - 1), uSrcLevel).r);
+    imageStore(uDst, dst, vec4(d));
+}
+)";
+
+    hizProgram_ = programCacheClass::global().compute(kHiZCS);
+
+    if (!hizProgram_) {
+        std::cerr << "[compute] Hi-Z link failed; occlusion culling unavailable.\n";
+        return;
+    }
+    uHizSrc_      = glGetUniformLocation(hizProgram_, "uSrc");
+    uHizSrcLevel_ = glGetUniformLocation(hizProgram_, "uSrcLevel");
+    uHizCopy_     = glGetUniformLocation(hizProgram_, "uCopy");
+}
+
+// Second and third pass of the ordered compaction (see ORDERED_COMPACTION in kCullCS).
+void sceneBuilderClass::buildCompactionPrograms_() {
+    TRACE_SCOPE("compaction shader compile");
+    static_assert(ModelObject::kMaxLods <= 4, "ordered compaction packs one 8-bit count per LOD into a uint");
+    // exclusive scan of the per-workgroup totals (one per LOD) in place: one workgroup
+    // walks them in blocks of 1024, carrying the running sums
+    static const char* kScanCS = R"(#version 430
+layout(local_size_x = 1024) in;
+
+layout(std430, binding = 13) buffer GroupSums { uvec4 groupSums[]; };
+uniform uint uGroupCount;
+
+shared uvec4 sScan[1024];
+shared uvec4 sCarry;
+#define SCAN_STEP(o) { uvec4 v = lid >= (o) ? sScan[lid - (o)] : uvec4(0u); barrier(); sScan[lid] += v; barrier(); }
+
+void main() {
+    uint lid = gl_LocalInvocationID.x;
+    if (lid == 0u) sCarry = uvec4(0u);
+    barrier();
+    for (uint base = 0u; base < uGroupCount; base += 1024u) {
+        uint i = base + lid;
+        uvec4 v = i < uGroupCount ? groupSums[i] : uvec4(0u);
+        sScan[lid] = v;
+        barrier();
+        SCAN_STEP(1u) SCAN_STEP(2u) SCAN_STEP(4u) SCAN_STEP(8u) SCAN_STEP(16u)
+        SCAN_STEP(32u) SCAN_STEP(64u) SCAN_STEP(128u) SCAN_STEP(256u) SCAN_STEP(512u)
+        uvec4 inclusive = sScan[lid];
+        if (i < uGroupCount) groupSums[i] = sCarry + inclusive - v;
+        barrier();
+        if (lid == 1023u) sCarry += inclusive;
+        barrier();
+    }
+}
+)";
+
+    // visible instance i of object o at LOD l lands at baseInstance(o, l) + prefix_l(i) -
+    // prefix_l(first of o); the last instance of each object writes every LOD's instanceCount
+    static const char* kScatterCS = R"(#version 430
+layout(local_size_x = 128) in;
 
-        // Clamp to valid range just in case
-        if (visCount > static_cast<GLuint>(maxInstances_)) {
-            visCount = static_cast<GLuint>(maxInstances_);
+layout(std430, binding = 1) readonly buffer InstanceObject { uint instanceObject[]; };
+layout(std430, binding = 2) writeonly buffer Visible { uint visibleIndices[]; };
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    uint baseVertex;
+    uint baseInstance;
+};
+layout(std430, binding = 3) buffer DrawCommands { DrawCommand cmds[]; };
+struct ObjectLod {
+    uint firstCommand;
+    uint lodCount;
+    uint firstInstance;
+    uint pad;
+    vec4 error;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint pad1;
+    uint pad2;
+};
+layout(std430, binding = 15) readonly buffer ObjectLods { ObjectLod objectLods[]; };
+layout(std430, binding = 13) readonly buffer GroupSums { uvec4 groupSums[]; };
+layout(std430, binding = 14) readonly buffer LocalScan { uvec2 localScan[]; };
+
+// visible instances before i, per LOD
+uvec4 prefixAt(uint i) {
+    uint x = localScan[i].x;
+    return groupSums[i / 128u] + uvec4(x & 255u, (x >> 8) & 255u, (x >> 16) & 255u, x >> 24);
+}
+
+void main() {
+    uint i = gl_GlobalInvocationID.x;
+    uint n = instanceObject.length();
+    if (i >= n) return;
+
+    uint obj      = instanceObject[i];
+    ObjectLod ol  = objectLods[obj];
+    uvec4 p       = prefixAt(i) - prefixAt(ol.firstInstance);
+    uint flags    = localScan[i].y;
+    bool vis      = (flags & 0x80000000u) != 0u;
+    uint lod      = flags & 0x7FFFFFFFu;
+
+    if (vis) visibleIndices[cmds[ol.firstCommand + lod].baseInstance + p[lod]] = i;
+    if (i + 1u == n || instanceObject[i + 1u] != obj) {
+        for (uint l = 0u; l < ol.lodCount; ++l) {
+            cmds[ol.firstCommand + l].instanceCount = p[l] + (vis && lod == l ? 1u : 0u);
         }
+    }
+}
+)";
+
+    scanProgram_    = programCacheClass::global().compute(kScanCS);
+    scatterProgram_ = programCacheClass::global().compute(kScatterCS);
+
+    if (!scanProgram_ || !scatterProgram_) {
+        std::cerr << "[compute] compaction link failed; visible lists use atomic appends.\n";
+        return;
+    }
+    uScanGroupCount_ = glGetUniformLocation(scanProgram_, "uGroupCount");
+}
+
+// Treelet traversal for hierarchical culling. Leaves are instanceBvhClass::kLeafSize = 128
+// instances, the cull CS workgroup size, so the second pass runs one group per leaf.
+void sceneBuilderClass::buildBvhProgram_() {
+    TRACE_SCOPE("bvh shader compile");
+    static const char* kBvhCS = R"(#version 430
+layout(local_size_x = 64) in;
+
+struct BvhNode {
+    vec3 bmin; uint left;    // internal: child node; leaf: 0x80000000 | first slot
+    vec3 bmax; uint right;   // internal: child node; leaf: instance count
+};
+layout(std430, binding = 9)  readonly buffer BvhNodes { BvhNode nodes[]; };
+layout(std430, binding = 10) readonly buffer BvhTreelets { uint treeletRoots[]; };
+layout(std430, binding = 11) buffer BvhLeaves {
+    uint  leafGroupsX;       // glDispatchComputeIndirect args for the instance pass
+    uint  leafGroupsY;
+    uint  leafGroupsZ;
+    uint  leafCount;
+    uvec2 leaves[];
+};
+layout(std140, binding = 4) uniform Frustum { vec4 planes[6]; };
+
+uniform int uCullEnabled;
+
+const uint kLeafBit = 0x80000000u;
 
-        // Indirect draw for each object
-        for (auto& obj : objects_) {
-            obj->setVisibleCount(visCount);
-            obj->render();
+void main() {
+    uint t = gl_GlobalInvocationID.x;
+    if (t >= treeletRoots.length()) return;
+
+    // treelets hold at most 32 leaves, so the depth (and stack) stays below 32
+    uint stackNode[32];
+    uint stackMask[32];      // planes the node still straddles
+    stackNode[0] = treeletRoots[t];
+    stackMask[0] = uCullEnabled != 0 ? 0x3Fu : 0u;
+    int sp = 1;
+
+    while (sp > 0) {
+        --sp;
+        BvhNode n = nodes[stackNode[sp]];
+        uint mask = stackMask[sp];
+        vec3 c = 0.5 * (n.bmin + n.bmax);
+        vec3 e = 0.5 * (n.bmax - n.bmin);
+
+        bool outside = false;
+        for (int p = 0; p < 6; ++p) {
+            if ((mask & (1u << p)) == 0u) continue;
+            float s = dot(planes[p].xyz, c) + planes[p].w;
+            float r = dot(abs(planes[p].xyz), e);
+            if (s < -r) { outside = true; break; }
+            if (s >= r) mask &= ~(1u << p); // entirely on the inner side
+        }
+        if (outside) continue;
+
+        if ((n.left & kLeafBit) != 0u) {
+            uint slot = atomicAdd(leafCount, 1u);
+            leaves[slot] = uvec2(n.left & ~kLeafBit, n.right | (mask == 0u ? kLeafBit : 0u));
+            atomicMax(leafGroupsX, slot + 1u);
+        } else {
+            stackNode[sp] = n.right; stackMask[sp] = mask; ++sp;
+            stackNode[sp] = n.left;  stackMask[sp] = mask; ++sp;
+        }
+    }
+}
+)";
+
+    bvhProgram_ = programCacheClass::global().compute(kBvhCS);
+
+    if (!bvhProgram_) {
+        std::cerr << "[compute] BVH link failed; hierarchical culling only on the CPU backend.\n";
+        return;
+    }
+    uBvhCullEnabled_ = glGetUniformLocation(bvhProgram_, "uCullEnabled");
+}
+
+// Copy this frame's commands into the next ring slot and fence it.
+void sceneBuilderClass::queueVisibleReadback_(bool twoPhase) {
+    const GLsizeiptr cmdBytes = sizeof(DrawElementsIndirectCommand) * commands_.size();
+    int slot = readbackHead_;
+    if (readbackFence_[slot]) {
+        // Ring is full (GPU is >2 frames behind); drop the oldest sample rather than wait
+        glDeleteSync(readbackFence_[slot]);
+        readbackFence_[slot] = nullptr;
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, readbackBuf_[slot]);
+    glBindBuffer(GL_COPY_READ_BUFFER,  cmdBuffer_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, cmdBytes);
+    // phase-2 commands are stale when occlusion is off; the reset template reads as zero
+    glBindBuffer(GL_COPY_READ_BUFFER,  twoPhase ? cmdBuffer2_ : cmdReset2_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, cmdBytes, cmdBytes);
+    glBindBuffer(GL_COPY_READ_BUFFER,  ssboRetest_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, cmdBytes * 2, sizeof(GLuint) * 4);
+    glBindBuffer(GL_COPY_READ_BUFFER,  ssboMeshletQueue_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, cmdBytes * 2 + sizeof(GLuint) * 4, sizeof(GLuint) * 4);
+    glBindBuffer(GL_COPY_READ_BUFFER,  meshletDrawBuf_);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, cmdBytes * 2 + sizeof(GLuint) * 8, sizeof(GLuint) * 2);
+    readbackFence_[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readbackHead_ = (slot + 1) % kReadbackSlots;
+}
+
+// Read back any slot whose fence already signalled; never blocks.
+void sceneBuilderClass::pollVisibleReadback_() {
+    const size_t n = commands_.size();
+    vector<DrawElementsIndirectCommand> cmds(n * 2);
+    GLuint retestHeader[4] = {0, 0, 0, 0};
+    GLuint meshletHeader[6] = {0, 0, 0, 0, 0, 0}; // queue dispatch args + count, 16-bit / 32-bit draw counts
+
+    // oldest pending slot first so the counters only move forward in time
+    for (int k = 0; k < kReadbackSlots; ++k) {
+        int slot = (readbackHead_ + k) % kReadbackSlots;
+        if (!readbackFence_[slot]) continue;
+
+        GLenum r = glClientWaitSync(readbackFence_[slot], 0, 0);
+        if (r != GL_ALREADY_SIGNALED && r != GL_CONDITION_SATISFIED) break;
+
+        glBindBuffer(GL_COPY_READ_BUFFER, readbackBuf_[slot]);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(DrawElementsIndirectCommand) * cmds.size(), cmds.data());
+        glGetBufferSubData(GL_COPY_READ_BUFFER, sizeof(DrawElementsIndirectCommand) * cmds.size(),
+                           sizeof(retestHeader), retestHeader);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, sizeof(DrawElementsIndirectCommand) * cmds.size() + sizeof(retestHeader),
+                           sizeof(meshletHeader), meshletHeader);
+        lastMeshletInstances_ = min(meshletHeader[3], meshletQueueCapacity_); // count runs past a full queue
+        lastMeshletDraws_     = min(meshletHeader[4], meshletSection_[0]) + min(meshletHeader[5], meshletSection_[1]);
+        GLuint phase1 = 0, phase2 = 0;
+        for (size_t i = 0; i < n; ++i) { phase1 += cmds[i].instanceCount; phase2 += cmds[n + i].instanceCount; }
+        fill(begin(lastLodCounts_), end(lastLodCounts_), 0u);
+        for (const ObjectLod& lods : objectLods_) {
+            for (GLuint l = 0; l < lods.lodCount; ++l) {
+                lastLodCounts_[l] += cmds[lods.firstCommand + l].instanceCount + cmds[n + lods.firstCommand + l].instanceCount;
+            }
         }
+        lastLodCounts_[0] += lastMeshletInstances_;
+        lastVisibleCount_   = phase1 + phase2 + lastMeshletInstances_;
+        lastRecoveredCount_ = phase2;
+        lastOccludedCount_  = retestHeader[3] - phase2;
 
-        glfwSwapBuffers(window);
+        glDeleteSync(readbackFence_[slot]);
+        readbackFence_[slot] = nullptr;
     }
 }
 
 
 
 void sceneBuilderClass::buildCullProgram_() {
+    TRACE_SCOPE("cull shader compile");
     // One thread per instance. Using AABB culling derived from object-space AABB.
     // We transform center & extents with |M3x3| for a tight world-space AABB proxy.
     static const char* kCullCS = R"(#version 430
 layout(local_size_x = 128) in;
 
 // Inputs
+#ifndef PACKED_INSTANCES
 layout(std430, binding = 0) readonly buffer Matrices { mat4 worldMats[]; };
+#endif
+layout(std430, binding = 1) readonly buffer InstanceObject { uint instanceObject[]; };
 
 // Outputs
 layout(std430, binding = 2) writeonly buffer Visible { uint visibleIndices[]; };
-layout(binding = 3, offset = 0) uniform atomic_uint visCount;
+
+// One command per (object, LOD), consumed by glMultiDrawElementsIndirect; we only touch instanceCount
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    uint baseVertex;
+    uint baseInstance;   // start of the (object, LOD) region in visibleIndices
+};
+layout(std430, binding = 3) buffer DrawCommands { DrawCommand cmds[]; };
+
+// LOD chain per object: cmds[firstCommand + l] draws LOD l
+struct ObjectLod {
+    uint firstCommand;
+    uint lodCount;
+    uint firstInstance;
+    uint pad;
+    vec4 error;          // object-space error per LOD
+    uint firstMeshlet;   // meshlet range, count 0 = none
+    uint meshletCount;
+    uint pad1;
+    uint pad2;
+};
+layout(std430, binding = 15) readonly buffer ObjectLods { ObjectLod objectLods[]; };
+
+// explicit locations: the ordered-compaction variant is a second program with the same uniforms
+layout(location = 0) uniform int uCullEnabled; // 0 = emit every instance (culling toggled off)
+
+// Hierarchical phase 0: one workgroup per BVH leaf that survived the treelet pass
+layout(location = 1) uniform int uBvh;
+layout(std430, binding = 11) readonly buffer BvhLeaves {
+    uint  leafGroupsX;
+    uint  leafGroupsY;
+    uint  leafGroupsZ;
+    uint  leafCount;
+    uvec2 leaves[];          // first slot, instance count | 0x80000000 when inside every plane
+};
+layout(std430, binding = 12) readonly buffer BvhOrder { uint bvhOrder[]; };
+
+// Two-phase Hi-Z occlusion
+layout(location = 2) uniform int  uPhase;         // 0 = every instance, 1 = re-test what phase 0 occluded
+layout(location = 3) uniform int  uOcclusion;     // 0 = frustum only
+layout(location = 4) uniform sampler2D uHiZ;      // max-depth mip pyramid
+layout(location = 5) uniform vec2 uHiZSize;       // level 0 size in texels
+layout(location = 6) uniform int  uHiZLevels;
+layout(location = 7) uniform mat4 uHiZViewProj;   // camera the pyramid was rendered with
+
+// LOD selection
+layout(location = 8) uniform vec3  uCameraPos;
+layout(location = 9) uniform float uLodScale;     // pixels per world unit at distance 1 / pixel error; 0 = LOD 0
+
+// Meshlet hand-off: close-up LOD 0 instances go to a queue instead of a draw command
+layout(location = 10) uniform float uMeshletScale;   // pixels per world unit at distance 1 / min radius; 0 = off
+layout(location = 11) uniform uint  uMeshletBase;    // queue region in visibleIndices
+layout(location = 12) uniform uint  uMeshletCapacity;
+layout(std430, binding = 18) buffer MeshletQueue {
+    uint queueGroupsX;       // glDispatchComputeIndirect args for kMeshletCS, one group per entry
+    uint queueGroupsY;
+    uint queueGroupsZ;
+    uint queueCount;
+};
+
+layout(std430, binding = 6) buffer Retest {
+    uint retestGroupsX;      // glDispatchComputeIndirect args for phase 1
+    uint retestGroupsY;
+    uint retestGroupsZ;
+    uint retestCount;
+    uint retestIndices[];
+};
 
 // Frustum planes
 layout(std140, binding = 4) uniform Frustum {
     vec4 planes[6]; // n.xyz, d
 };
 
-// Object-space AABB for the STL mesh used by all instances
-// Object-space AABB for the STL mesh used by all instances
-layout(std140, binding = 5) uniform AABB {
+// Object-space AABB per mesh
+struct ObjectBounds {
     vec4 aabbMinOS; // xyz + 0
     vec4 aabbMaxOS; // xyz + 0
 };
+layout(std430, binding = 5) readonly buffer Objects { ObjectBounds objects[]; };
 
 bool aabbInFrustum(mat4 M, vec3 minOS, vec3 maxOS) {
     // Compute world-space center & extents of the OBB projected to an AABB
@@ -324,30 +1745,361 @@ bool aabbInFrustum(mat4 M, vec3 minOS, vec3 maxOS) {
     return true; // inside or intersects
 }
 
-void main() {
-    uint idx = gl_GlobalInvocationID.x;
+// Projects the box with the pyramid's camera and compares its nearest depth against
+// the farthest depth stored over its screen footprint.
+bool occludedByHiZ(mat4 M, vec3 minOS, vec3 maxOS) {
+    mat4 MVP = uHiZViewProj * M;
+    vec3 ndcMin = vec3( 1e30);
+    vec3 ndcMax = vec3(-1e30);
+    for (int i = 0; i < 8; ++i) {
+        vec3 c = vec3((i & 1) != 0 ? maxOS.x : minOS.x,
+                      (i & 2) != 0 ? maxOS.y : minOS.y,
+                      (i & 4) != 0 ? maxOS.z : minOS.z);
+        vec4 clip = MVP * vec4(c, 1.0);
+        if (clip.w <= 1e-5) return false; // straddles the near plane: keep it
+        vec3 ndc = clip.xyz / clip.w;
+        ndcMin = min(ndcMin, ndc);
+        ndcMax = max(ndcMax, ndc);
+    }
+
+    vec2 uvMin = clamp(ndcMin.xy * 0.5 + 0.5, 0.0, 1.0);
+    vec2 uvMax = clamp(ndcMax.xy * 0.5 + 0.5, 0.0, 1.0);
+    float nearest = ndcMin.z * 0.5 + 0.5;
+
+    // pick the level where the footprint covers at most 2x2 texels
+    vec2 sizePx = (uvMax - uvMin) * uHiZSize;
+    float lod = ceil(log2(max(max(sizePx.x, sizePx.y), 1.0)));
+    lod = clamp(lod, 0.0, float(uHiZLevels - 1));
+
+    float farthest = max(max(textureLod(uHiZ, uvMin, lod).r,
+                             textureLod(uHiZ, vec2(uvMax.x, uvMin.y), lod).r),
+                         max(textureLod(uHiZ, vec2(uvMin.x, uvMax.y), lod).r,
+                             textureLod(uHiZ, uvMax, lod).r));
+    return nearest > farthest;
+}
+
+float maxScale(mat4 M) {
+    return sqrt(max(dot(M[0].xyz, M[0].xyz), max(dot(M[1].xyz, M[1].xyz), dot(M[2].xyz, M[2].xyz))));
+}
+
+// coarsest LOD whose error, seen from the nearest point of the bounding sphere, stays
+// within one (scaled) pixel
+int selectLod(uint obj, mat4 M, vec3 minOS, vec3 maxOS) {
+    ObjectLod ol = objectLods[obj];
+    if (uLodScale <= 0.0 || ol.lodCount < 2u) return 0;
+    float scale = maxScale(M);
+    vec3 centerWS = (M * vec4(0.5 * (minOS + maxOS), 1.0)).xyz;
+    float radius = 0.5 * length(maxOS - minOS) * scale;
+    float pixelsPerUnit = uLodScale * scale / max(distance(centerWS, uCameraPos) - radius, 1e-3);
+    int lod = 0;
+    for (int l = 1; l < int(ol.lodCount); ++l) {
+        if (ol.error[l] * pixelsPerUnit > 1.0) break;
+        lod = l;
+    }
+    return lod;
+}
+
+// true when idx was queued for per-meshlet culling (its bounding sphere is big enough on
+// screen); a full queue falls back to the whole-mesh draw
+bool queueForMeshlets(uint idx, uint obj, mat4 M, vec3 minOS, vec3 maxOS) {
+    if (uMeshletScale <= 0.0 || objectLods[obj].meshletCount == 0u) return false;
+    vec3 centerWS = (M * vec4(0.5 * (minOS + maxOS), 1.0)).xyz;
+    float radius  = 0.5 * length(maxOS - minOS) * maxScale(M);
+    if (radius * uMeshletScale < distance(centerWS, uCameraPos)) return false;
+    uint slot = atomicAdd(queueCount, 1u);
+    if (slot >= uMeshletCapacity) return false;
+    visibleIndices[uMeshletBase + slot] = idx;
+    atomicMax(queueGroupsX, slot + 1u);
+    return true;
+}
+
+// LOD to draw idx with, -1 when culled or handed to the meshlet pass; phase-0 occlusion
+// rejects are queued for the phase-1 re-test
+int cullInstance(uint idx, bool inside) {
+    uint obj   = instanceObject[idx];
+    vec3 minOS = objects[obj].aabbMinOS.xyz;
+    vec3 maxOS = objects[obj].aabbMaxOS.xyz;
+#ifdef PACKED_INSTANCES
+    mat4 M     = instanceMatrix(loadInstance(idx));
+#else
+    mat4 M     = worldMats[idx];
+#endif
+
+    if (uCullEnabled != 0) {
+        // phase 1 entries already passed the frustum test
+        if (uPhase == 0 && !inside && !aabbInFrustum(M, minOS, maxOS)) return -1;
+        if (uOcclusion != 0 && occludedByHiZ(M, minOS, maxOS)) {
+            if (uPhase == 0) {
+                uint r = atomicAdd(retestCount, 1u);
+                retestIndices[r] = idx;
+                atomicMax(retestGroupsX, r / 128u + 1u);
+            }
+            return -1;
+        }
+    }
+    int lod = selectLod(obj, M, minOS, maxOS);
+    if (lod == 0 && queueForMeshlets(idx, obj, M, minOS, maxOS)) return -1;
+    return lod;
+}
 
-    // Optional: bounds check in case dispatch is rounded up
-    if (idx >= worldMats.length()) return;
+#ifdef ORDERED_COMPACTION
+// Phase 0 over every instance (no BVH): each workgroup scans its visibility flags in
+// shared memory; kScanCS turns the group totals into offsets and kScatterCS writes each
+// visible index to (group offset + local offset), in instance order, without atomics.
+// One 8-bit count per LOD is packed into each scan value (a group holds at most 128).
+// No early return: every invocation has to reach the barriers.
+layout(std430, binding = 13) writeonly buffer GroupSums { uvec4 groupSums[]; };  // per LOD
+layout(std430, binding = 14) writeonly buffer LocalScan { uvec2 localScan[]; };  // packed exclusive prefix, LOD | visible << 31
 
-    vec3 minOS = aabbMinOS.xyz;
-    vec3 maxOS = aabbMaxOS.xyz;
+shared uint sScan[128];
+#define SCAN_STEP(o) { uint v = lid >= (o) ? sScan[lid - (o)] : 0u; barrier(); sScan[lid] += v; barrier(); }
 
-    if (aabbInFrustum(worldMats[idx], minOS, maxOS)) {
-        uint outIdx = atomicCounterIncrement(visCount);
-        visibleIndices[outIdx] = idx;
+void main() {
+    uint idx = gl_GlobalInvocationID.x;
+    uint lid = gl_LocalInvocationID.x;
+    bool valid = idx < instanceObject.length();
+    int lod = valid ? cullInstance(idx, false) : -1;
+    uint own = lod >= 0 ? 1u << (8u * uint(lod)) : 0u;
+
+    sScan[lid] = own;
+    barrier();
+    SCAN_STEP(1u) SCAN_STEP(2u) SCAN_STEP(4u) SCAN_STEP(8u) SCAN_STEP(16u) SCAN_STEP(32u) SCAN_STEP(64u)
+    uint inclusive = sScan[lid];
+
+    if (valid) localScan[idx] = uvec2(inclusive - own, lod >= 0 ? uint(lod) | 0x80000000u : 0u);
+    if (lid == 127u) {
+        groupSums[gl_WorkGroupID.x] = uvec4(inclusive & 255u, (inclusive >> 8) & 255u,
+                                            (inclusive >> 16) & 255u, inclusive >> 24);
     }
 }
+#else
+void main() {
+    uint gid = gl_GlobalInvocationID.x;
+    uint idx;
+    bool inside = false;     // the leaf already passed every plane
+    if (uPhase == 0 && uBvh != 0) {
+        if (gl_WorkGroupID.x >= leafCount) return;
+        uvec2 leaf = leaves[gl_WorkGroupID.x];
+        if (gl_LocalInvocationID.x >= (leaf.y & 0x7FFFFFFFu)) return;
+        idx = bvhOrder[leaf.x + gl_LocalInvocationID.x];
+        inside = (leaf.y & 0x80000000u) != 0u;
+    } else if (uPhase == 0) {
+        // Optional: bounds check in case dispatch is rounded up
+        if (gid >= instanceObject.length()) return;
+        idx = gid;
+    } else {
+        if (gid >= retestCount) return;
+        idx = retestIndices[gid];
+    }
+
+    int lod = cullInstance(idx, inside);
+    if (lod < 0) return;
+    uint c      = objectLods[instanceObject[idx]].firstCommand + uint(lod);
+    uint outIdx = atomicAdd(cmds[c].instanceCount, 1u);
+    visibleIndices[cmds[c].baseInstance + outIdx] = idx;
+}
+#endif
 )";
 
-    GLuint cs = compileShader_(GL_COMPUTE_SHADER, kCullCS);
-    cullProgram_ = linkProgram_(cs);
-    glDeleteShader(cs);
+    // same instance layout as the draw VS
+    string src = kCullCS;
+    if (packed_) src.insert(src.find('\n') + 1, string("#define PACKED_INSTANCES 1\n") + kPackedInstanceGLSL);
+    cullPacked_ = packed_;
+
+    if (cullProgram_) programCacheClass::global().release(cullProgram_);
+    cullProgram_ = programCacheClass::global().compute(src);
+
+    src.insert(src.find('\n') + 1, "#define ORDERED_COMPACTION 1\n");
+    if (cullOrderedProgram_) programCacheClass::global().release(cullOrderedProgram_);
+    cullOrderedProgram_ = programCacheClass::global().compute(src);
+
+    if (cullProgram_) {
+        uCullEnabled_ = glGetUniformLocation(cullProgram_, "uCullEnabled");
+        uPhase_       = glGetUniformLocation(cullProgram_, "uPhase");
+        uOcclusion_   = glGetUniformLocation(cullProgram_, "uOcclusion");
+        uHiZViewProj_ = glGetUniformLocation(cullProgram_, "uHiZViewProj");
+        uHiZ_         = glGetUniformLocation(cullProgram_, "uHiZ");
+        uHiZSize_     = glGetUniformLocation(cullProgram_, "uHiZSize");
+        uHiZLevels_   = glGetUniformLocation(cullProgram_, "uHiZLevels");
+        uBvh_         = glGetUniformLocation(cullProgram_, "uBvh");
+        uCameraPos_   = glGetUniformLocation(cullProgram_, "uCameraPos");
+        uLodScale_    = glGetUniformLocation(cullProgram_, "uLodScale");
+        uMeshletScale_    = glGetUniformLocation(cullProgram_, "uMeshletScale");
+        uMeshletBase_     = glGetUniformLocation(cullProgram_, "uMeshletBase");
+        uMeshletCapacity_ = glGetUniformLocation(cullProgram_, "uMeshletCapacity");
+    }
 
     // Storage buffers are created on demand in setInstanceTransforms()
     if (!cullProgram_) {
-        std::cerr << "[compute] link failed; disabling GPU culling this run.\n";
+        std::cerr << "[compute] link failed; culling on the CPU (" << cpuCullerClass::simdPath() << ") this run.\n";
+    }
+    buildMeshletProgram_();
+}
+
+// One workgroup per queued instance, one thread per meshlet: frustum-tests each meshlet's
+// sphere and rejects clusters whose normal cone faces away from the camera, then appends one
+// single-instance draw per survivor. baseInstance points back at the queue slot, so the draw
+// VS fetches the instance exactly as for a whole-mesh command.
+void sceneBuilderClass::buildMeshletProgram_() {
+    static const char* kMeshletCS = R"(#version 430
+layout(local_size_x = 64) in;
+
+#ifndef PACKED_INSTANCES
+layout(std430, binding = 0) readonly buffer Matrices { mat4 worldMats[]; };
+#endif
+layout(std430, binding = 1) readonly buffer InstanceObject { uint instanceObject[]; };
+layout(std430, binding = 2) readonly buffer Visible { uint visibleIndices[]; };
+struct ObjectLod {
+    uint firstCommand;
+    uint lodCount;
+    uint firstInstance;
+    uint pad;
+    vec4 error;
+    uint firstMeshlet;
+    uint meshletCount;
+    uint pad1;
+    uint pad2;
+};
+layout(std430, binding = 15) readonly buffer ObjectLods { ObjectLod objectLods[]; };
+struct Meshlet {
+    vec4 sphere;         // object space center, radius
+    vec4 cone;           // axis, cutoff
+    uint firstIndex;
+    uint indexCount;
+    uint baseVertex;
+    uint wide;           // 32-bit indices
+};
+layout(std430, binding = 16) readonly buffer Meshlets { Meshlet meshlets[]; };
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    uint baseVertex;
+    uint baseInstance;
+};
+layout(std430, binding = 17) buffer MeshletDraws {
+    uint drawCount[2];       // GL_PARAMETER_BUFFER_ARB sources: 16-bit, 32-bit index section
+    uint drawPad0;
+    uint drawPad1;
+    DrawCommand draws[];     // 16-bit section, then the 32-bit one at uWideBase
+};
+layout(std430, binding = 18) readonly buffer MeshletQueue {
+    uint queueGroupsX;
+    uint queueGroupsY;
+    uint queueGroupsZ;
+    uint queueCount;
+};
+layout(std140, binding = 4) uniform Frustum { vec4 planes[6]; };
+
+uniform vec3 uCameraPos;
+uniform uint uQueueBase;
+uniform uint uDrawCapacity;   // per section
+uniform uint uWideBase;
+
+shared mat4 sM;
+shared vec3 sEyeOS;
+shared float sScale;
+
+void main() {
+    uint slot = gl_WorkGroupID.x;
+    uint idx  = visibleIndices[uQueueBase + slot];
+    ObjectLod ol = objectLods[instanceObject[idx]];
+    if (gl_LocalInvocationID.x == 0u) {
+#ifdef PACKED_INSTANCES
+        sM = instanceMatrix(loadInstance(idx));
+#else
+        sM = worldMats[idx];
+#endif
+        sEyeOS = (inverse(sM) * vec4(uCameraPos, 1.0)).xyz; // cone test runs in object space
+        sScale = sqrt(max(dot(sM[0].xyz, sM[0].xyz), max(dot(sM[1].xyz, sM[1].xyz), dot(sM[2].xyz, sM[2].xyz))));
     }
+    barrier();
+
+    for (uint m = gl_LocalInvocationID.x; m < ol.meshletCount; m += 64u) {
+        Meshlet ml = meshlets[ol.firstMeshlet + m];
+        vec3 toCenter = ml.sphere.xyz - sEyeOS;
+        if (dot(toCenter, ml.cone.xyz) >= ml.cone.w * length(toCenter) + ml.sphere.w) continue;
+
+        vec3 centerWS = (sM * vec4(ml.sphere.xyz, 1.0)).xyz;
+        float radius  = ml.sphere.w * sScale;
+        bool visible  = true;
+        for (int i = 0; i < 6; ++i) {
+            if (dot(planes[i].xyz, centerWS) + planes[i].w < -radius) { visible = false; break; }
+        }
+        if (!visible) continue;
+
+        uint at = atomicAdd(drawCount[ml.wide], 1u);
+        if (at < uDrawCapacity) {
+            draws[ml.wide * uWideBase + at] = DrawCommand(ml.indexCount, 1u, ml.firstIndex, ml.baseVertex, uQueueBase + slot);
+        }
+    }
+}
+)";
+
+    string src = kMeshletCS;
+    if (packed_) src.insert(src.find('\n') + 1, string("#define PACKED_INSTANCES 1\n") + kPackedInstanceGLSL);
+    if (meshletProgram_) programCacheClass::global().release(meshletProgram_);
+    meshletProgram_ = programCacheClass::global().compute(src);
+    if (!meshletProgram_) {
+        std::cerr << "[compute] meshlet cull link failed; large meshes are drawn whole.\n";
+        return;
+    }
+    uMlCameraPos_    = glGetUniformLocation(meshletProgram_, "uCameraPos");
+    uMlQueueBase_    = glGetUniformLocation(meshletProgram_, "uQueueBase");
+    uMlDrawCapacity_ = glGetUniformLocation(meshletProgram_, "uDrawCapacity");
+    uMlWideBase_     = glGetUniformLocation(meshletProgram_, "uWideBase");
+}
+
+void sceneBuilderClass::dispatchMeshlets_() {
+    if (GLEW_ARB_indirect_parameters) {
+        const GLuint zero[2] = {0, 0};
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletDrawBuf_);
+        glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(zero), zero);
+    } else {
+        // every slot is drawn: the unused ones must stay zero-count commands
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, meshletDrawBuf_);
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+
+    bindMatrices_();
+    bindInstanceObjects_();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, ssboVisible_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 15, ssboObjectLods_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 16, ssboMeshlets_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 17, meshletDrawBuf_);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 18, ssboMeshletQueue_);
+    if (uboFrustum_) glBindBufferBase(GL_UNIFORM_BUFFER, 4, uboFrustum_);
+
+    glUseProgram(meshletProgram_);
+    const glm::vec3 eye(glm::inverse(view)[3]);
+    glUniform3f(uMlCameraPos_, eye.x, eye.y, eye.z);
+    glUniform1ui(uMlQueueBase_, GLuint(visibleCapacity_ * 2));
+    glUniform1ui(uMlDrawCapacity_, meshletDrawCapacity_);
+    glUniform1ui(uMlWideBase_, meshletSection_[0]);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, ssboMeshletQueue_);
+    glDispatchComputeIndirect(0);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+}
+
+void sceneBuilderClass::drawMeshlets_() {
+    objects_.front()->bindProgram();
+    bindMatrices_();
+    glBindVertexArray(drawVao_);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, meshletDrawBuf_);
+    if (GLEW_ARB_indirect_parameters) glBindBuffer(GL_PARAMETER_BUFFER_ARB, meshletDrawBuf_);
+    for (int k = 0; k < 2; ++k) {
+        if (!meshletSection_[k]) continue;
+        const GLenum type = k == 0 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        const void* first = reinterpret_cast<const void*>(sizeof(GLuint) * 4 +
+                                                          sizeof(DrawElementsIndirectCommand) * (k == 0 ? 0 : meshletSection_[0]));
+        if (GLEW_ARB_indirect_parameters) {
+            glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, type, first, GLintptr(sizeof(GLuint) * k),
+                                                static_cast<GLsizei>(meshletSection_[k]), 0);
+        } else {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, type, first, static_cast<GLsizei>(meshletSection_[k]), 0);
+        }
+    }
+    glBindVertexArray(0);
 }
 
 void sceneBuilderClass::updateFrustumPlanes_(glm::vec4 planes[6]) const {
@@ -376,88 +2128,269 @@ void sceneBuilderClass::updateFrustumPlanes_(glm::vec4 planes[6]) const {
     }
 }
 
-vector<glm::mat4> sceneBuilderClass::makeInstanceTransforms(
-    size_t count,
-    const string& layout,
-    float spacing,
-    float radius,
-    const glm::vec3& boxMin,
-    const glm::vec3& boxMax)
-{
+// The original generator: one mt19937 walked in order, glm::translate/rotate/scale per
+// instance. Only kept as the baseline for benchmarkInstanceGeneration().
+static vector<glm::mat4> makeGridTransformsSerial(size_t count, float spacing) {
     vector<glm::mat4> mats;
     mats.reserve(count);
-    if (count == 0) return mats;
-
-    
     mt19937 rng(12345u);
     uniform_real_distribution<float> jitter(-0.25f, 0.25f);
     uniform_real_distribution<float> scaleJit(0.90f, 1.10f);
     uniform_real_distribution<float> yawJit(-glm::pi<float>(), glm::pi<float>());
-    uniform_real_distribution<float> u01(0.0f, 1.0f);
-    uniform_real_distribution<float> rx(boxMin.x, boxMax.x);
-    uniform_real_distribution<float> ry(boxMin.y, boxMax.y);
-    uniform_real_distribution<float> rz(boxMin.z, boxMax.z);
-
-    auto makeTRS = [&](const glm::vec3& p, float yaw, const glm::vec3& s) {
-        glm::mat4 M(1.0f);
-        M = glm::translate(M, p);
-        // Yaw-only random rotation (keeps instances upright)
-        M = glm::rotate(M, yaw, glm::vec3(0, 1, 0));
-        M = glm::scale(M, s);
-        return M;
-    };
 
-    if (layout == "grid") {
-        // 3D grid, centered around origin
-        const int side = static_cast<int>(ceil(pow(double(count), 1.0/3.0)));
-        size_t emitted = 0;
-        for (int z = 0; z < side && emitted < count; ++z) {
-            for (int y = 0; y < side && emitted < count; ++y) {
-                for (int x = 0; x < side && emitted < count; ++x) {
-                    glm::vec3 pos(
-                        (x - side/2) * spacing + jitter(rng),
-                        (y - side/2) * spacing + jitter(rng),
-                        (z - side/2) * spacing + jitter(rng));
-                    glm::vec3 sc(scaleJit(rng), scaleJit(rng), scaleJit(rng));
-                    float yaw = yawJit(rng) * 0.1f; // small, keep grid readable
-                    mats.push_back(makeTRS(pos, yaw, sc));
-                    ++emitted;
-                }
+    const int side = static_cast<int>(ceil(pow(double(count), 1.0/3.0)));
+    for (int z = 0; z < side && mats.size() < count; ++z) {
+        for (int y = 0; y < side && mats.size() < count; ++y) {
+            for (int x = 0; x < side && mats.size() < count; ++x) {
+                glm::vec3 pos((x - side/2) * spacing + jitter(rng),
+                              (y - side/2) * spacing + jitter(rng),
+                              (z - side/2) * spacing + jitter(rng));
+                glm::vec3 sc(scaleJit(rng), scaleJit(rng), scaleJit(rng));
+                float yaw = yawJit(rng) * 0.1f;
+                glm::mat4 M = glm::translate(glm::mat4(1.0f), pos);
+                M = glm::rotate(M, yaw, glm::vec3(0, 1, 0));
+                mats.push_back(glm::scale(M, sc));
             }
         }
     }
-    
-    else {
-        // Fallback to grid if unknown layout keyword
-        const int side = static_cast<int>(ceil(pow(double(count), 1.0/3.0)));
-        size_t emitted = 0;
-        for (int z = 0; z < side && emitted < count; ++z) {
-            for (int y = 0; y < side && emitted < count; ++y) {
-                for (int x = 0; x < side && emitted < count; ++x) {
-                    glm::vec3 pos(
-                        (x - side/2) * spacing + jitter(rng),
-                        (y - side/2) * spacing + jitter(rng),
-                        (z - side/2) * spacing + jitter(rng));
-                    glm::vec3 sc(scaleJit(rng), scaleJit(rng), scaleJit(rng));
-                    float yaw = yawJit(rng) * 0.1f;
-                    mats.push_back(makeTRS(pos, yaw, sc));
-                    ++emitted;
-                }
+    return mats;
+}
+
+// translate(p) * rotateY(yaw) * scale(s), written column by column
+static inline void storeTrs(glm::mat4& dst, const glm::vec3& p, float yaw, const glm::vec3& s, bool aligned) {
+    const float c = cos(yaw), sn = sin(yaw);
+#if defined(__SSE__) || defined(_M_X64)
+    float* o = reinterpret_cast<float*>(&dst);
+    const __m128 c0 = _mm_set_ps(0.0f, -sn * s.x, 0.0f, c * s.x);
+    const __m128 c1 = _mm_set_ps(0.0f, 0.0f, s.y, 0.0f);
+    const __m128 c2 = _mm_set_ps(0.0f, c * s.z, 0.0f, sn * s.z);
+    const __m128 c3 = _mm_set_ps(1.0f, p.z, p.y, p.x);
+    if (aligned) {
+        // non-temporal: tens of millions of matrices would only evict the cache
+        _mm_stream_ps(o, c0); _mm_stream_ps(o + 4, c1); _mm_stream_ps(o + 8, c2); _mm_stream_ps(o + 12, c3);
+    } else {
+        _mm_storeu_ps(o, c0); _mm_storeu_ps(o + 4, c1); _mm_storeu_ps(o + 8, c2); _mm_storeu_ps(o + 12, c3);
+    }
+#else
+    (void)aligned;
+    dst = glm::mat4(glm::vec4(c * s.x, 0.0f, -sn * s.x, 0.0f), glm::vec4(0.0f, s.y, 0.0f, 0.0f),
+                    glm::vec4(sn * s.z, 0.0f, c * s.z, 0.0f), glm::vec4(p, 1.0f));
+#endif
+}
+
+static constexpr uint32_t kInstanceSeed = 12345u;
+
+// Periodic Poisson-disk tile in [0,1)^3: dart throwing with toroidal distances, so copies
+// placed side by side keep the minimum distance across tile borders. Points are in
+// acceptance order, i.e. random, so any prefix is an even thinning of the whole tile.
+static vector<glm::vec3> poissonTile(size_t n) {
+    const float r = cbrt(0.5f / float(n));          // below the ~0.73/r^3 jamming density of darts
+    const int   g = max(1, int(1.0f / r));          // cell >= r: neighbours are one cell away
+    vector<vector<uint32_t>> grid(size_t(g) * g * g);
+    vector<glm::vec3> pts;
+    pts.reserve(n);
+    auto cellOf = [g](float v) { return min(g - 1, int(v * float(g))); };
+    for (uint32_t attempt = 0; pts.size() < n && attempt < 64u * uint32_t(n); ++attempt) {
+        const philox4x32 d = philox4x32::generate(attempt, 0u, 4u, 0u, kInstanceSeed, 0u);
+        const glm::vec3 p(philox4x32::unit(d.v[0]), philox4x32::unit(d.v[1]), philox4x32::unit(d.v[2]));
+        const int cx = cellOf(p.x), cy = cellOf(p.y), cz = cellOf(p.z);
+        bool ok = true;
+        for (int dz = -1; dz <= 1 && ok; ++dz)
+        for (int dy = -1; dy <= 1 && ok; ++dy)
+        for (int dx = -1; dx <= 1 && ok; ++dx) {
+            const size_t c = (size_t((cz + dz + g) % g) * g + size_t((cy + dy + g) % g)) * g + size_t((cx + dx + g) % g);
+            for (uint32_t k : grid[c]) {
+                glm::vec3 d3 = glm::abs(pts[k] - p);
+                d3 = glm::min(d3, glm::vec3(1.0f) - d3);
+                if (glm::dot(d3, d3) < r * r) { ok = false; break; }
             }
         }
+        if (!ok) continue;
+        grid[(size_t(cz) * g + size_t(cy)) * g + size_t(cx)].push_back(uint32_t(pts.size()));
+        pts.push_back(p);
     }
+    return pts;
+}
+
+// Minimum distance of `count` Poisson points in a box of `size` (the tile's r at its density).
+// Axes shorter than that count as that long, so a flat box is a one-spacing slab, not zero volume:
+// with k axes at least d long, d^k = 0.5 * (their product) / count.
+static float poissonSpacing(const glm::vec3& size, size_t count) {
+    float s[3] = { size.x, size.y, size.z };
+    sort(s, s + 3);
+    const float n = float(max<size_t>(count, 1));
+    const float d3 = cbrt(0.5f * s[0] * s[1] * s[2] / n);
+    if (s[0] > 0.0f && s[0] >= d3) return d3;
+    const float d2 = sqrt(0.5f * s[1] * s[2] / n);
+    if (s[1] > 0.0f && s[1] >= d2) return d2;
+    return 0.5f * s[2] / n; // a line, or 0 for a point
+}
 
+// Box-Muller pair from two uniforms
+static inline glm::vec2 gaussian2(uint32_t a, uint32_t b) {
+    const float m = sqrt(-2.0f * log(1.0f - philox4x32::unit(a)));
+    const float t = 6.2831853f * philox4x32::unit(b);
+    return glm::vec2(m * cos(t), m * sin(t));
+}
+
+// Instance i draws only from Philox counters {i, stream}, so the result is identical for
+// any split of [0, count) across threads (minChunk = count: serial). Every layout gets the
+// same small yaw / per-axis scale jitter; only the positions differ:
+//   grid      jittered 3D grid, x fastest, `spacing` apart
+//   box       uniform in [boxMin, boxMax]
+//   sphere    shell of `radius` (5% thick) around the origin
+//   poisson   Poisson-disk in the box (tiled periodic pattern, evenly thinned to count)
+//   spiral    four-armed flat spiral of `radius` in XZ
+//   clustered dense gaussian clumps at random centres in the box
+static void fillTransforms(glm::mat4* out, size_t count, const string& layout, float spacing, float radius,
+                           const glm::vec3& boxMin, const glm::vec3& boxMax, size_t minChunk) {
+    enum { Grid, Box, Sphere, Poisson, Spiral, Clustered } kind = Grid;
+    if      (layout == "box")       kind = Box;
+    else if (layout == "sphere")    kind = Sphere;
+    else if (layout == "poisson")   kind = Poisson;
+    else if (layout == "spiral")    kind = Spiral;
+    else if (layout == "clustered") kind = Clustered;
+    else if (layout != "grid") cerr << "[scene] unknown layout '" << layout << "', using grid\n";
+
+    const glm::vec3 boxSize = glm::max(boxMax - boxMin, glm::vec3(0.0f));
+    const size_t side = static_cast<size_t>(ceil(pow(double(count), 1.0/3.0)));
+    const float half = float(side / 2);
+
+    // poisson: tiles covering the box, each holding an even share of the instances
+    // (thin axes widened to the point spacing about the box centre, see poissonSpacing)
+    vector<glm::vec3> tile;
+    size_t tilesX = 1, tilesY = 1, tilesZ = 1, perTile = count, extraTiles = 0;
+    glm::vec3 tileSize = boxSize, tileMin = boxMin;
+    if (kind == Poisson && count > 0) {
+        tile = poissonTile(min<size_t>(count, 4096));
+        const size_t wanted = (count + tile.size() - 1) / tile.size();
+        const glm::vec3 size = glm::max(boxSize, glm::vec3(poissonSpacing(boxSize, count)));
+        tileMin = boxMin - 0.5f * (size - boxSize);
+        const float edge = cbrt(max(size.x * size.y * size.z, 1e-12f) / float(wanted));
+        tilesX = max<size_t>(1, size_t(ceil(size.x / edge)));
+        tilesY = max<size_t>(1, size_t(ceil(size.y / edge)));
+        tilesZ = max<size_t>(1, size_t(ceil(size.z / edge)));
+        while (tilesX * tilesY * tilesZ < wanted) ++tilesX; // rounding, or a point box: never more than a tile each
+        const size_t tiles = tilesX * tilesY * tilesZ;
+        perTile = count / tiles;
+        extraTiles = count % tiles;  // the first extraTiles tiles take one more
+        tileSize = size / glm::vec3(float(tilesX), float(tilesY), float(tilesZ));
+    }
+
+    // clustered: ~5000 instances per clump, sigma 2% of the smallest box edge
+    const size_t clusters = min<size_t>(4096, max<size_t>(1, count / 5000));
+    const float sigma = 0.02f * max(min(boxSize.x, min(boxSize.y, boxSize.z)), 1e-6f);
+    vector<glm::vec3> centers(kind == Clustered ? clusters : 0);
+    for (size_t c = 0; c < centers.size(); ++c) {
+        const philox4x32 r = philox4x32::generate(uint32_t(c), 0u, 5u, 0u, kInstanceSeed, 0u);
+        centers[c] = boxMin + boxSize * glm::vec3(philox4x32::unit(r.v[0]), philox4x32::unit(r.v[1]), philox4x32::unit(r.v[2]));
+    }
+
+    const bool aligned = (reinterpret_cast<uintptr_t>(out) & 15u) == 0;
+    parallelFor(count, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) {
+            const uint32_t lo = uint32_t(i), hi = uint32_t(uint64_t(i) >> 32);
+            const philox4x32 r0 = philox4x32::generate(lo, hi, 0u, 0u, kInstanceSeed, 0u); // jitter xyz, yaw
+            const philox4x32 r1 = philox4x32::generate(lo, hi, 1u, 0u, kInstanceSeed, 0u); // scale xyz
+            glm::vec3 pos;
+            switch (kind) {
+            case Grid: {
+                const size_t x = i % side, y = (i / side) % side, z = i / (side * side);
+                pos = glm::vec3((float(x) - half) * spacing + r0.uniform(0, -0.25f, 0.25f),
+                                (float(y) - half) * spacing + r0.uniform(1, -0.25f, 0.25f),
+                                (float(z) - half) * spacing + r0.uniform(2, -0.25f, 0.25f));
+                break;
+            }
+            case Box: {
+                const philox4x32 r2 = philox4x32::generate(lo, hi, 2u, 0u, kInstanceSeed, 0u);
+                pos = boxMin + boxSize * glm::vec3(philox4x32::unit(r2.v[0]), philox4x32::unit(r2.v[1]), philox4x32::unit(r2.v[2]));
+                break;
+            }
+            case Sphere: {
+                const philox4x32 r2 = philox4x32::generate(lo, hi, 2u, 0u, kInstanceSeed, 0u);
+                const float y = r2.uniform(0, -1.0f, 1.0f), phi = r2.uniform(1, 0.0f, 6.2831853f);
+                const float ring = sqrt(max(0.0f, 1.0f - y * y));
+                pos = radius * r2.uniform(2, 0.975f, 1.025f) * glm::vec3(ring * cos(phi), y, ring * sin(phi));
+                break;
+            }
+            case Poisson: {
+                // tile t holds instances [start(t), start(t) + perTile (+1)), in order
+                const size_t big = extraTiles * (perTile + 1);
+                const size_t t = i < big ? i / (perTile + 1) : extraTiles + (i - big) / max<size_t>(perTile, 1);
+                const size_t k = i < big ? i % (perTile + 1) : (i - big) % max<size_t>(perTile, 1);
+                const glm::vec3 cell(float(t % tilesX), float((t / tilesX) % tilesY), float(t / (tilesX * tilesY)));
+                pos = tileMin + (cell + tile[k]) * tileSize;
+                break;
+            }
+            case Spiral: {
+                const philox4x32 r2 = philox4x32::generate(lo, hi, 2u, 0u, kInstanceSeed, 0u);
+                const float t = (float(i) + 0.5f) / float(count);               // 0 at the core, 1 at the rim
+                const float angle = float(i % 4) * 1.5707963f + t * 3.0f * 6.2831853f;
+                const float rr = radius * t + r2.uniform(0, -0.04f, 0.04f) * radius;
+                pos = glm::vec3(rr * cos(angle), r2.uniform(1, -0.02f, 0.02f) * radius, rr * sin(angle));
+                break;
+            }
+            case Clustered: {
+                const philox4x32 r2 = philox4x32::generate(lo, hi, 2u, 0u, kInstanceSeed, 0u);
+                const glm::vec2 g01 = gaussian2(r2.v[0], r2.v[1]), g23 = gaussian2(r2.v[2], r2.v[3]);
+                pos = centers[r1.v[3] % clusters] + sigma * glm::vec3(g01.x, g01.y, g23.x);
+                break;
+            }
+            }
+            const glm::vec3 sc(r1.uniform(0, 0.90f, 1.10f), r1.uniform(1, 0.90f, 1.10f), r1.uniform(2, 0.90f, 1.10f));
+            const float yaw = r0.uniform(3, -glm::pi<float>(), glm::pi<float>()) * 0.1f; // small, keep layouts readable
+            storeTrs(out[i], pos, yaw, sc, aligned);
+        }
+#if defined(__SSE__) || defined(_M_X64)
+        _mm_sfence(); // streaming stores visible before the join
+#endif
+    }, minChunk);
+}
+
+vector<glm::mat4> sceneBuilderClass::makeInstanceTransforms(
+    size_t count,
+    const string& layout,
+    float spacing,
+    float radius,
+    const glm::vec3& boxMin,
+    const glm::vec3& boxMax)
+{
+    TRACE_SCOPE("instance generation");
+    vector<glm::mat4> mats(count);
+    fillTransforms(mats.data(), count, layout, spacing, radius, boxMin, boxMax, 16384);
     return mats;
 }
 
+// Serial mt19937 baseline vs the Philox generator on one thread and on every worker;
+// the two Philox runs must match bit for bit.
+void sceneBuilderClass::benchmarkInstanceGeneration(size_t count) {
+    using clock = chrono::steady_clock;
+    auto rate = [count](clock::duration d) {
+        return double(count) / max(chrono::duration<double>(d).count(), 1e-9) / 1e6;
+    };
+
+    auto t0 = clock::now();
+    vector<glm::mat4> baseline = makeGridTransformsSerial(count, 100.0f);
+    auto t1 = clock::now();
+    const glm::vec3 box(50.0f * cbrt(float(count)));
+    vector<glm::mat4> serial(count);
+    fillTransforms(serial.data(), count, "grid", 100.0f, box.x, -box, box, max<size_t>(count, 1));
+    auto t2 = clock::now();
+    vector<glm::mat4> parallel(count);
+    fillTransforms(parallel.data(), count, "grid", 100.0f, box.x, -box, box, 16384);
+    auto t3 = clock::now();
+
+    const bool same = memcmp(serial.data(), parallel.data(), count * sizeof(glm::mat4)) == 0;
+    cout << "[bench-instances] " << count << " instances, " << workerCount() << " workers\n"
+         << "[bench-instances] mt19937 + glm (old): " << rate(t1 - t0) << " M/s\n"
+         << "[bench-instances] philox, 1 thread:    " << rate(t2 - t1) << " M/s\n"
+         << "[bench-instances] philox, parallel:    " << rate(t3 - t2) << " M/s\n"
+         << "[bench-instances] thread-count invariant: " << (same ? "yes" : "NO") << "\n";
+}
+
 void sceneBuilderClass::setModelBounds(const glm::vec3& minOS, const glm::vec3& maxOS) {
     aabbMinOS_ = minOS;
     aabbMaxOS_ = maxOS;
     hasModelBounds_ = true;
-
-    // Write to UBO now so compute shader reads valid data
-    glm::vec4 pack[2] = { glm::vec4(aabbMinOS_, 0.0f), glm::vec4(aabbMaxOS_, 0.0f) };
-    glBindBuffer(GL_UNIFORM_BUFFER, uboAabb_);
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(pack), pack);
-    glBindBufferBase(GL_UNIFORM_BUFFER, 5, uboAabb_); // ensure bound
+    sceneDirty_ = true; // picked up by buildSceneBuffers_()
 }
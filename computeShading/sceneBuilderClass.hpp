@@ -1,17 +1,26 @@
 #pragma once
 #include "modelClass.hpp"
+#include "frameStatsClass.hpp"
+#include "persistentRingClass.hpp"
+#include "normalMatrixUtil.hpp"
+#include "cpuCullerClass.hpp"
+#include "instanceBvhClass.hpp"
+#include "asyncMeshLoaderClass.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <glm/gtc/matrix_access.hpp>
 
 using namespace std;
 
 class sceneBuilderClass {
 public:
-    sceneBuilderClass();
+    // headless: invisible window (or GLFW's null platform + EGL when there is no display),
+    // nothing is presented; pair with runBenchmark()
+    explicit sceneBuilderClass(bool headless = false);
     GLFWwindow* windowInit(int width, int height, string name);
 
     // camera
@@ -20,41 +29,283 @@ public:
 
     // objects
     void addObject(const shared_ptr<ModelObject>& obj);
-    void setInstanceTransforms(const vector<glm::mat4>& mats);
+    // loads the mesh on a worker thread; it joins with these transforms at the start of the
+    // first frame after it is ready, appended into the spare room the scene buffers keep while
+    // loads are pending (a full rebuild only when it does not fit)
+    void addObjectAsync(const string& path, VertexFormat format, vector<glm::mat4> mats);
+    size_t pendingObjects() const { return loader_ ? loader_->pending() : 0; }
+    void setInstanceTransforms(const vector<glm::mat4>& mats); // same list for every object
+    void setInstanceTransforms(const shared_ptr<ModelObject>& obj, const vector<glm::mat4>& mats);
+    // streaming mode: every frame the animator writes all transforms (in object order) straight
+    // into a persistently mapped, triple-buffered ring; pass nullptr to go back to static
+    void setInstanceAnimator(InstanceAnimator animator);
+    // normal matrices computed once per transform change on the CPU (default), or false for
+    // the per-vertex inverse in the VS; uniform-scale static scenes skip the stream entirely
+    void setPrecomputedNormals(bool on) { precomputeNormals_ = on; sceneDirty_ = true; }
+    // upload translate/rotate/scale in 28 bytes per instance instead of a mat4; the cull CS
+    // and VS rebuild the matrix. Falls back to mat4 when animating or for non-TRS transforms.
+    void setPackedInstances(bool on) { packedRequested_ = on; sceneDirty_ = true; }
+    // frustum culling on the CPU (SIMD, all cores) instead of the cull CS, toggle with 'G';
+    // used automatically when the cull program fails to build. No occlusion on this path.
+    void setCpuCulling(bool on) { cpuCulling_ = on; }
+    // static scenes: walk a per-object instance BVH so culling cost follows the visible set
+    // (GPU: one thread per treelet emits surviving leaves, one workgroup per leaf tests
+    // its instances; CPU: same treelets per work item). Ignored while animating.
+    void setHierarchicalCulling(bool on) { bvhEnabled_ = on; cpuCullerValid_ = false; }
+    // sort each object's instances by the Morton code of their position before upload, so
+    // neighbours in space are neighbours in ssboMatrices_ (and in every visible list)
+    void setMortonOrder(bool on) { mortonOrder_ = on; sceneDirty_ = true; }
+    // phase-0 visible lists via workgroup scan + global prefix sum (default): in instance
+    // order, no per-instance atomics. false = the atomic append, for A/B timing.
+    void setOrderedCompaction(bool on) { orderedCompaction_ = on; }
+    // per instance, draw the coarsest mesh LOD whose simplification error projects to at
+    // most pixelError pixels (from the instance's nearest bounding-sphere distance);
+    // <= 0 always draws LOD 0
+    void setLodPixelError(float pixelError) { lodPixelError_ = pixelError; }
+    // GPU culling, phase 0: instances of meshlet-bearing meshes that are drawn at LOD 0 and
+    // whose bounding sphere spans at least minPixels (radius) are not drawn whole; a second
+    // pass culls their meshlets (frustum + normal cone) and draws the survivors one indirect
+    // command each. <= 0 turns the path off.
+    void setMeshletCulling(float minPixels) { meshletMinPixels_ = minPixels; }
 
      // main loop
     void run();
+    // fixed number of frames on a scripted orbit; prints per-frame CPU/GPU ms and a summary
+    void runBenchmark(int frameCount);
 
-    vector<glm::mat4> makeInstanceTransforms(size_t count, const string& layout, float spacing, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax);
-    void setModelBounds(const glm::vec3& minOS, const glm::vec3& maxOS);
+    // debug: lagged, fence-guarded readback of the GPU visible count (never stalls)
+    void   setDebugReadback(bool enabled) { debugReadback_ = enabled; }
+    GLuint lastVisibleCount() const { return lastVisibleCount_; }
+
+    // two-phase Hi-Z occlusion culling (toggle with 'O'); counters lag like lastVisibleCount()
+    void   setOcclusionCulling(bool enabled) { occlusionCulling_ = enabled; }
+    GLuint lastOccludedCount()  const { return lastOccludedCount_; }  // rejected by both phases
+    GLuint lastRecoveredCount() const { return lastRecoveredCount_; } // rejected by phase 1, drawn in phase 2
+    GLuint lastLodCount(int lod) const { return lastLodCounts_[lod]; }  // visible instances drawn at each LOD
+    GLuint lastMeshletInstances() const { return lastMeshletInstances_; } // of those, drawn as meshlets
+    GLuint lastMeshletDraws()     const { return lastMeshletDraws_; }     // meshlets that survived
+
+    // per-stage CPU/GPU timings; run() prints a rolling summary every `seconds`
+    frameStatsClass& frameStats() { return stats_; }
+    void setStatsInterval(double seconds) { statsInterval_ = seconds; }
+    bool setStatsCsv(const string& path) { return stats_.openCsv(path); }
+
+    // layouts: grid (spacing), box (boxMin..boxMax), sphere (shell of radius), poisson (box),
+    // spiral (radius), clustered (box). Parallel and reproducible: instance i only depends
+    // on i, never on the thread count.
+    static vector<glm::mat4> makeInstanceTransforms(size_t count, const string& layout, float spacing, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax);
+    // instances/second of the old serial generator vs the parallel one (no GL context needed)
+    static void benchmarkInstanceGeneration(size_t count);
+    void setModelBounds(const glm::vec3& minOS, const glm::vec3& maxOS); // overrides every mesh's AABB
+
+    // layout matches glDrawElementsIndirect; the cull shader writes instanceCount directly
+    struct DrawElementsIndirectCommand {
+        GLuint count;          // indices in this LOD of the object's mesh
+        GLuint instanceCount;  // visible instances (written by the cull shader)
+        GLuint firstIndex;     // offset of the LOD in the shared index buffer
+        GLuint baseVertex;     // offset of the mesh in the shared vertex buffer
+        GLuint baseInstance;   // start of the (object, LOD) range in visibleIndices
+    };
+    // per object, layout matches the cull shader's ObjectLod (binding 15)
+    struct ObjectLod {
+        GLuint firstCommand;   // commands_[firstCommand + l] draws LOD l
+        GLuint lodCount;
+        GLuint firstInstance;  // start of the object's range in the instance buffers
+        GLuint pad;
+        glm::vec4 error;       // object-space error per LOD (x: LOD 0, always 0)
+        GLuint firstMeshlet;   // range in the scene's meshlet SSBO (binding 16), count 0 = none
+        GLuint meshletCount;
+        GLuint pad1, pad2;
+    };
 
 private:
     void bindCameraPointers();
 
+    // ==== Scene buffers (rebuilt when objects or instances change) ====
+    void buildSceneBuffers_();
+    bool joinLoadedObjects_(); // true when a joined object did not fit and needs buildSceneBuffers_()
+    bool appendObject_(size_t i); // objects_[i] into the spare room, false = does not fit
+    void uploadObjectTables_();   // per-object AABBs, dequant and ObjectLods (bindings 5, 7, 15)
+    void uploadCommands_();       // indirect command buffers + readback slots from commands_
+    void bindInstanceObjects_();  // binding 1 over the used instances only (the shaders read its length)
+    struct StagedCopy { GLuint dst; GLintptr offset; GLsizeiptr bytes; const void* data; };
+    void stagedUpload_(const vector<StagedCopy>& copies);
+
     // ==== Compute-culling helpers & GL resources ====
     void buildCullProgram_();
     void updateFrustumPlanes_(glm::vec4 planes[6]) const;
+    void queueVisibleReadback_(bool twoPhase);
+    void pollVisibleReadback_();
+    bool keyToggled_(int key);
+
+    // ==== Offscreen target + Hi-Z pyramid ====
+    void ensureRenderTargets_(int w, int h);
+    void buildHiZProgram_();
+    void buildHiZ_();
+    void dispatchCull_(int phase, bool occlusion, bool cullEnabled, const glm::mat4& hizViewProj);
+    void bindMatrices_();       // bindings 0 (+8): static SSBOs, or this frame's ring region
+    NormalMode pickNormalMode_() const;
+    void streamInstances_();
+    void drawCommands_(GLuint cmdBuf);
+    bool useCpuCulling_() const { return cpuCulling_ || !cullProgram_; }
+    void buildCpuCuller_();
+    void buildBvhProgram_();
+    void buildCompactionPrograms_();
+    void buildBvh_();
+    bool bvhActive_() const { return bvhEnabled_ && bvhValid_ && !animator_; }
+    void cpuCull_(const glm::vec4 planes[6], bool cullEnabled);
+    float lodScale_() const; // pixels per world unit at distance 1, over the pixel error; 0 = LOD 0 only
+    void buildMeshletProgram_();
+    bool meshletsActive_() const { return meshletProgram_ && meshletQueueCapacity_ > 0 && meshletMinPixels_ > 0.0f; }
+    void dispatchMeshlets_();
+    void drawMeshlets_();
+
+    // ==== Frame ====
+    bool renderFrame_(bool disableCulling); // false when there is nothing to render into
+    void present_();
+    glm::mat4 orbitView_(int frame, int frameCount) const;
+
+    // shared geometry for glMultiDrawElementsIndirect
+    GLuint drawVao_ = 0;
+    GLuint megaVbo_ = 0;         // every mesh's pos/normal stream back to back
+    GLuint megaEbo_ = 0;         // every mesh's indices back to back (mesh-local values): 16-bit meshes, then 32-bit
+    GLsizei shortCommandCount_ = 0; // commands_[0, n) index 16-bit, the rest 32-bit
+
+    // spare room for streamed-in objects, in elements; 32-bit indices start after the 16-bit capacity
+    size_t vertexUsed_ = 0, vertexCapacity_ = 0;
+    size_t shortIndexUsed_ = 0, shortIndexCapacity_ = 0;
+    size_t wideIndexUsed_ = 0, wideIndexCapacity_ = 0;
+    size_t instanceCapacity_ = 0;        // matrices, normals, instObj, re-test list
+    size_t visibleUsed_ = 0;             // of visibleCapacity_
+    size_t meshletCount_ = 0, meshletCapacity_ = 0, maxMeshlets_ = 0;
+    GLuint stagingBuf_ = 0;              // appendObject_ uploads go through here
+    GLsizeiptr stagingBytes_ = 0;
+    GLsync stagingFence_ = nullptr;      // last copies out of stagingBuf_
 
     // GL objects for culling
     GLuint cullProgram_ = 0;
-    GLuint ssboMatrices_ = 0;    // input: per-instance world matrices (mat4)
-    GLuint ssboVisible_  = 0;    // output: compacted visible indices (uint[])
-    GLuint ssboCounter_  = 0;    // output: atomic counter (uint)
+    GLuint ssboMatrices_  = 0;   // input: per-instance world matrices (mat4 or PackedInstance), grouped by object
+    GLuint ssboInstObj_   = 0;   // input: owning object index per instance (uint[])
+    GLuint ssboVisible_   = 0;   // output: visible indices, one region per (object, LOD) (uint[])
+    GLuint ssboObjects_   = 0;   // input: per-object object-space AABB
+    GLuint ssboDequant_   = 0;   // VS input: per-object offset/scale for quantized positions
+    GLuint ssboNormals_   = 0;   // VS input: per-instance normal matrix (3 x vec4), NormalMode::Precomputed
+    GLuint ssboObjectLods_ = 0;  // input: ObjectLod per object (binding 15)
+    persistentRingClass instanceRing_;  // streaming replacement for ssboMatrices_ (+ ssboNormals_)
+    InstanceAnimator    animator_;
+    double              animTime_ = 0.0;
+    size_t              ringNormalsOffset_ = 0;  // normal matrices follow the matrices in each region
+    vector<glm::mat4>   animScratch_;            // animator output when normals are derived from it
+    bool                precomputeNormals_ = true;
+    NormalMode          normalMode_ = NormalMode::Inverse;
+    bool                packedRequested_ = false;
+    bool                packed_ = false;         // ssboMatrices_ holds PackedInstance records
+    bool                cullPacked_ = false;     // layout cullProgram_ was compiled for
+    GLuint cmdBuffer_     = 0;   // one DrawElementsIndirectCommand per (object, LOD)
+    GLuint cmdReset_      = 0;   // same commands with instanceCount = 0
+    GLuint cmdAll_        = 0;   // same commands with every instance visible (no-cull fallback)
+    GLuint cmdBuffer2_    = 0;   // phase-2 commands, visible region offset by visibleCapacity_
+    GLuint cmdReset2_     = 0;
+    GLuint ssboRetest_    = 0;   // phase-1 occlusion rejects: dispatch args, count, indices
+    cpuCullerClass cpuCuller_;           // CPU backend, built on first use after a scene rebuild
+    bool   cpuCulling_    = false;
+    bool   cpuCullerValid_ = false;
+    instanceBvhClass bvh_;               // built on first use after a scene rebuild
+    bool   bvhEnabled_ = false;
+    bool   mortonOrder_ = false;
+    bool   bvhValid_   = false;
+    GLuint bvhProgram_ = 0;              // treelet traversal -> surviving leaves
+    GLuint ssboBvhNodes_    = 0;         // binding 9: instanceBvhClass::Node[]
+    GLuint ssboBvhTreelets_ = 0;         // binding 10: treelet root per traversal thread
+    GLuint ssboBvhLeaves_   = 0;         // binding 11: dispatch args, count, {first slot, count | inside}
+    GLuint ssboBvhOrder_    = 0;         // binding 12: slot -> instance index
+    GLint  uBvhCullEnabled_ = -1;
+    GLint  uBvh_ = -1;                   // cull shader: 1 = phase 0 reads the BVH leaf list
+    GLuint cullOrderedProgram_ = 0;      // kCullCS + ORDERED_COMPACTION: flags + workgroup scan
+    GLuint scanProgram_ = 0, scatterProgram_ = 0;
+    GLuint ssboGroupSums_ = 0;           // binding 13: per-workgroup visible count -> offset
+    GLuint ssboLocalScan_ = 0;           // binding 14: per-instance offset in its workgroup | visible bit
+    size_t compactionCapacity_ = 0;
+    GLint  uScanGroupCount_ = -1;
+    bool   orderedCompaction_ = true;
+    GLint  uCullEnabled_ = -1;   // cull shader: 0 = emit every instance
+    GLint  uPhase_ = -1, uOcclusion_ = -1, uHiZViewProj_ = -1, uHiZ_ = -1, uHiZSize_ = -1, uHiZLevels_ = -1;
+    GLint  uCameraPos_ = -1, uLodScale_ = -1;
+    float  lodPixelError_ = 1.0f;
+    GLint  uMeshletScale_ = -1, uMeshletBase_ = -1, uMeshletCapacity_ = -1;
+
+    // meshlet culling (GPU path only)
+    static constexpr GLuint kMeshletDrawCapacity = 1u << 16;
+    GLuint meshletProgram_ = 0;
+    GLuint ssboMeshlets_      = 0;       // binding 16: meshletBuilderClass::Meshlet[], absolute index ranges
+    GLuint meshletDrawBuf_    = 0;       // binding 17: 16-bit / 32-bit draw counts (+2 pad) then DrawElementsIndirectCommand[] per section
+    GLuint ssboMeshletQueue_  = 0;       // binding 18: dispatch args, count; the instances sit in visibleIndices
+    GLuint meshletQueueCapacity_ = 0;    // instances; every one can emit all of its meshlets
+    GLuint meshletDrawCapacity_  = 0;
+    GLuint meshletSection_[2] = {0, 0}; // command slots for 16-bit / 32-bit meshes (0 or the capacity)
+    GLint  uMlCameraPos_ = -1, uMlQueueBase_ = -1, uMlDrawCapacity_ = -1, uMlWideBase_ = -1;
+    float  meshletMinPixels_ = 100.0f;
+    bool   sceneDirty_    = true;
+
+    // offscreen scene target (depth must be sampleable for the Hi-Z build)
+    GLuint sceneFbo_ = 0, sceneColor_ = 0, sceneDepth_ = 0;
+    int    targetW_ = 0, targetH_ = 0;
+
+    // Hi-Z: R32F max-depth pyramid
+    GLuint hizTex_ = 0, hizProgram_ = 0;
+    GLint  uHizSrc_ = -1, uHizSrcLevel_ = -1, uHizCopy_ = -1;
+    int    hizLevels_ = 0;
+    bool   hizValid_  = false;       // holds last frame's depth
+    glm::mat4 hizViewProj_{1.0f};    // camera the pyramid was built with
+    bool   occlusionCulling_ = false;
+
+    // lagged readback of instanceCount (ring of small buffers, each guarded by a fence)
+    static constexpr int kReadbackSlots = 3;
+    GLuint readbackBuf_[kReadbackSlots]   = {0, 0, 0};
+    GLsync readbackFence_[kReadbackSlots] = {nullptr, nullptr, nullptr};
+    int    readbackHead_     = 0;    // next slot to write
+    bool   debugReadback_    = true;
+    GLuint lastVisibleCount_ = 0;
+    GLuint lastOccludedCount_  = 0;
+    GLuint lastRecoveredCount_ = 0;
+    GLuint lastLodCounts_[ModelObject::kMaxLods] = {};
+    GLuint lastMeshletInstances_ = 0;
+    GLuint lastMeshletDraws_ = 0;
+
+    unordered_map<int, bool> keyLatch_;
+
+    // frame timing stages
+    frameStatsClass stats_;
+    double statsInterval_ = 2.0;
+    int stFrame_ = -1, stUpdate_ = -1, stCull_ = -1, stDraw_ = -1;
+    int stOcclusion_ = -1, stReadback_ = -1, stPresent_ = -1, stStream_ = -1;
 
     // UBOs
     GLuint uboFrustum_   = 0;    // 6 planes
-    GLuint uboAabb_      = 0;    // object-space AABB (min/max)
 
     // CPU-side cached data
-    vector<glm::mat4> allInstances_;
+    vector<glm::mat4> allInstances_;      // every object's instances, concatenated
+    vector<vector<glm::mat4>> objectInstances_; // parallel to objects_
+    vector<DrawElementsIndirectCommand> commands_;
+    vector<ObjectLod> objectLods_;
+    vector<GLuint>    instObj_;           // instance -> object, parallel to allInstances_
+    vector<glm::vec4> objectAabbs_;       // min, max per object (the cull inputs, shared with the CPU culler / BVH)
     GLsizei maxInstances_ = 0;
+    size_t  visibleCapacity_ = 0;         // one phase's visibleIndices: every object's instances once per LOD (+ spare)
+    vector<uint8_t> cpuLods_;             // cpuCull_ scratch: LOD per visible instance
+    vector<GLuint>  cpuLodLists_;         // cpuCull_ scratch: one object's visible list bucketed by LOD
 
-    // STL object-space AABB
+    // optional AABB override (otherwise each mesh's own bbox is used)
     glm::vec3 aabbMinOS_{-0.5f, -0.5f, -0.5f};
     glm::vec3 aabbMaxOS_{ 0.5f,  0.5f,  0.5f};
     bool      hasModelBounds_ = false;
 
     GLFWwindow* window = nullptr;
+    bool headless_ = false;
     glm::mat4 view{1.0f}, projection{1.0f};
     vector<shared_ptr<ModelObject>> objects_;
+
+    // last member: its workers are joined before anything else goes away
+    unique_ptr<asyncMeshLoaderClass> loader_;
+    vector<vector<glm::mat4>> asyncInstances_; // by request tag, moved out on arrival
 };
@@ -0,0 +1,319 @@
+#include "stlLoaderClass.hpp"
+#include "traceRecorderClass.hpp"
+#include "mappedFileClass.hpp"
+#include "parallelUtil.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+using namespace std;
+
+bool stlLoaderClass::isStlPath(const string& path) {
+    if (path.size() < 4) return false;
+    string ext = path.substr(path.size() - 4);
+    transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return ext == ".stl";
+}
+
+void stlLoaderClass::load(const string& path,
+                          vector<float>& interleaved,
+                          vector<unsigned>& indices,
+                          glm::vec3& bboxMin,
+                          glm::vec3& bboxMax) {
+    vector<float> soup;
+    {
+        TRACE_SCOPE("stl parse");
+        mappedFileClass file(path);
+        const unsigned char* d = file.data();
+        const size_t n = file.size();
+
+        // Binary if the header's triangle count matches the file size exactly; many binary
+        // exporters still start the header with "solid", so check this before the ASCII test.
+        uint32_t triCount = 0;
+        if (n >= 84) memcpy(&triCount, d + 80, sizeof(triCount));
+        if (n >= 84 && 84ull + 50ull * triCount == n) {
+            parseBinary_(d, n, soup);
+        } else if (n >= 5 && memcmp(d, "solid", 5) == 0) {
+            parseAscii_(d, n, soup);
+        } else {
+            throw runtime_error("Not a valid STL file: " + path);
+        }
+    } // unmap before welding; the soup is all we need
+
+    if (soup.empty()) throw runtime_error("STL has no triangles: " + path);
+
+    vector<float> positions;
+    weld_(soup, positions, indices);
+    vector<float>().swap(soup);
+
+    generateNormals_(positions, indices, interleaved);
+
+    // bounds: per-chunk min/max, merged in order
+    const size_t verts = positions.size() / 3;
+    const size_t chunks = workerCount();
+    vector<glm::vec3> mins(chunks, glm::vec3(FLT_MAX)), maxs(chunks, glm::vec3(-FLT_MAX));
+    parallelFor(chunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            size_t b = verts * c / chunks, e = verts * (c + 1) / chunks;
+            for (size_t v = b; v < e; ++v) {
+                glm::vec3 p(positions[v*3], positions[v*3+1], positions[v*3+2]);
+                mins[c] = glm::min(mins[c], p);
+                maxs[c] = glm::max(maxs[c], p);
+            }
+        }
+    }, 1);
+    for (size_t c = 0; c < chunks; ++c) {
+        bboxMin = glm::min(bboxMin, mins[c]);
+        bboxMax = glm::max(bboxMax, maxs[c]);
+    }
+}
+
+// 80-byte header, uint32 count, then 50-byte records: normal(3f) v0 v1 v2 (3f each) attr(u16)
+void stlLoaderClass::parseBinary_(const unsigned char* data, size_t size, vector<float>& soup) {
+    const size_t tris = (size - 84) / 50;
+    soup.resize(tris * 9);
+    parallelFor(tris, [&](size_t b, size_t e) {
+        for (size_t t = b; t < e; ++t) {
+            // records are not 4-byte aligned; the file normal is ignored (we regenerate)
+            memcpy(&soup[t * 9], data + 84 + t * 50 + 12, sizeof(float) * 9);
+        }
+    });
+}
+
+namespace {
+// next `word` at pos or later that is the first token of its line and is followed by
+// whitespace, so a solid name like "vertex_paint" is never taken for a keyword
+size_t findKeyword(string_view text, string_view word, size_t pos) {
+    for (; (pos = text.find(word, pos)) != string_view::npos; pos += word.size()) {
+        size_t b = pos;
+        while (b > 0 && (text[b - 1] == ' ' || text[b - 1] == '\t')) --b;
+        if (b > 0 && text[b - 1] != '\n' && text[b - 1] != '\r') continue;
+        const size_t a = pos + word.size();
+        if (a < text.size() && text[a] != ' ' && text[a] != '\t' && text[a] != '\n' && text[a] != '\r') continue;
+        return pos;
+    }
+    return string_view::npos;
+}
+} // namespace
+
+// Splits the text at "endfacet" boundaries so every chunk holds whole facets, parses the
+// "vertex x y z" lines of each chunk independently and concatenates in file order.
+void stlLoaderClass::parseAscii_(const unsigned char* data, size_t size, vector<float>& soup) {
+    const string_view text(reinterpret_cast<const char*>(data), size);
+    const size_t chunks = max<size_t>(1, min<size_t>(workerCount(), size / (1u << 20)));
+
+    vector<size_t> bounds(chunks + 1, size);
+    bounds[0] = 0;
+    for (size_t c = 1; c < chunks; ++c) {
+        size_t at = findKeyword(text, "endfacet", max(bounds[c - 1], size * c / chunks));
+        bounds[c] = (at == string_view::npos) ? size : at + 8;
+    }
+
+    vector<vector<float>> parts(chunks);
+    atomic<bool> malformed{false}; // worker threads must not throw
+    parallelFor(chunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            vector<float>& out = parts[c];
+            const char* end = text.data() + bounds[c + 1];
+            size_t pos = bounds[c];
+            while (!malformed && (pos = findKeyword(text, "vertex", pos)) != string_view::npos && pos < bounds[c + 1]) {
+                const char* p = text.data() + pos + 6;
+                for (int k = 0; k < 3; ++k) {
+                    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+                    if (p < end && *p == '+') ++p; // from_chars rejects a leading '+'
+                    float v = 0.0f;
+                    auto r = from_chars(p, end, v);
+                    if (r.ec != errc()) { malformed = true; break; }
+                    out.push_back(v);
+                    p = r.ptr;
+                }
+                pos = size_t(p - text.data());
+            }
+        }
+    }, 1);
+    if (malformed) throw runtime_error("Malformed ASCII STL vertex");
+
+    size_t total = 0;
+    for (auto& p : parts) total += p.size();
+    if (total % 9 != 0) throw runtime_error("ASCII STL facet without three vertices");
+    soup.reserve(total);
+    for (auto& p : parts) soup.insert(soup.end(), p.begin(), p.end());
+}
+
+namespace {
+struct PosKey { uint32_t x, y, z; };
+
+inline PosKey keyOf(const float* p) {
+    PosKey k;
+    float x = p[0], y = p[1], z = p[2];
+    if (x == 0.0f) x = 0.0f; // fold -0 into +0 so they weld
+    if (y == 0.0f) y = 0.0f;
+    if (z == 0.0f) z = 0.0f;
+    memcpy(&k.x, &x, 4); memcpy(&k.y, &y, 4); memcpy(&k.z, &z, 4);
+    return k;
+}
+
+inline uint32_t hashKey(const PosKey& k) {
+    uint64_t h = (uint64_t(k.x) * 0x9E3779B97F4A7C15ull) ^ (uint64_t(k.y) * 0xC2B2AE3D27D4EB4Full)
+               ^ (uint64_t(k.z) * 0x165667B19E3779F9ull);
+    h ^= h >> 29;
+    return uint32_t(h ^ (h >> 32));
+}
+} // namespace
+
+void stlLoaderClass::weld_(const vector<float>& soup, vector<float>& positions, vector<unsigned>& indices) {
+    TRACE_SCOPE("stl weld");
+    const size_t n = soup.size() / 3; // corners
+    const unsigned shardBits = 6;     // 64 shards keeps every worker busy
+    const size_t shards = size_t(1) << shardBits;
+    const size_t chunks = workerCount();
+
+    vector<uint32_t> hashes(n);
+    parallelFor(n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) hashes[i] = hashKey(keyOf(&soup[i * 3]));
+    });
+
+    // stable counting sort of corner ids by shard: per-chunk histograms -> offsets -> scatter
+    vector<size_t> counts(chunks * shards, 0);
+    auto chunkRange = [&](size_t c) { return make_pair(n * c / chunks, n * (c + 1) / chunks); };
+    parallelFor(chunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            auto [b, e] = chunkRange(c);
+            for (size_t i = b; i < e; ++i) ++counts[c * shards + (hashes[i] & (shards - 1))];
+        }
+    }, 1);
+    vector<size_t> shardStart(shards + 1, 0);
+    {
+        size_t run = 0;
+        for (size_t s = 0; s < shards; ++s) {
+            shardStart[s] = run;
+            for (size_t c = 0; c < chunks; ++c) {
+                size_t cnt = counts[c * shards + s];
+                counts[c * shards + s] = run;
+                run += cnt;
+            }
+        }
+        shardStart[shards] = run;
+    }
+    vector<uint32_t> byShard(n);
+    parallelFor(chunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            auto [b, e] = chunkRange(c);
+            for (size_t i = b; i < e; ++i) byShard[counts[c * shards + (hashes[i] & (shards - 1))]++] = uint32_t(i);
+        }
+    }, 1);
+
+    // each shard owns its keys: open addressing, corners visited in increasing order so the
+    // representative is always the first occurrence
+    vector<uint32_t> firstOf(n);
+    parallelFor(shards, [&](size_t sb, size_t se) {
+        vector<uint32_t> table;
+        for (size_t s = sb; s < se; ++s) {
+            const size_t b = shardStart[s], e = shardStart[s + 1];
+            if (b == e) continue;
+            size_t cap = 16;
+            while (cap < (e - b) * 2) cap <<= 1;
+            table.assign(cap, UINT32_MAX);
+            for (size_t j = b; j < e; ++j) {
+                const uint32_t i = byShard[j];
+                const PosKey k = keyOf(&soup[size_t(i) * 3]);
+                size_t slot = (hashes[i] >> shardBits) & (cap - 1);
+                for (;;) {
+                    uint32_t t = table[slot];
+                    if (t == UINT32_MAX) { table[slot] = i; firstOf[i] = i; break; }
+                    const PosKey kt = keyOf(&soup[size_t(t) * 3]);
+                    if (k.x == kt.x && k.y == kt.y && k.z == kt.z) {
+                        firstOf[i] = t;
+                        break;
+                    }
+                    slot = (slot + 1) & (cap - 1);
+                }
+            }
+        }
+    }, 1);
+    vector<uint32_t>().swap(byShard);
+    vector<uint32_t>().swap(hashes);
+
+    // new ids in order of first occurrence: chunked exclusive prefix sum over "is first"
+    vector<size_t> firsts(chunks, 0);
+    parallelFor(chunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            auto [b, e] = chunkRange(c);
+            for (size_t i = b; i < e; ++i) firsts[c] += (firstOf[i] == i);
+        }
+    }, 1);
+    size_t unique = 0;
+    for (size_t c = 0; c < chunks; ++c) { size_t f = firsts[c]; firsts[c] = unique; unique += f; }
+
+    positions.resize(unique * 3);
+    vector<uint32_t> newId(n);
+    parallelFor(chunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+            auto [b, e] = chunkRange(c);
+            size_t next = firsts[c];
+            for (size_t i = b; i < e; ++i) {
+                if (firstOf[i] != i) continue;
+                newId[i] = uint32_t(next);
+                memcpy(&positions[next * 3], &soup[i * 3], sizeof(float) * 3);
+                ++next;
+            }
+        }
+    }, 1);
+
+    indices.resize(n);
+    parallelFor(n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; ++i) indices[i] = newId[firstOf[i]];
+    });
+
+    // drop triangles that collapsed onto a repeated vertex
+    size_t w = 0;
+    for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+        unsigned a = indices[t], b = indices[t + 1], c = indices[t + 2];
+        if (a == b || b == c || a == c) continue;
+        indices[w++] = a; indices[w++] = b; indices[w++] = c;
+    }
+    indices.resize(w);
+}
+
+// Area-weighted vertex normals: face normals in parallel, vertex->triangle lists (CSR),
+// then each vertex sums its own faces so no two threads write the same output.
+void stlLoaderClass::generateNormals_(const vector<float>& positions, const vector<unsigned>& indices,
+                                      vector<float>& interleaved) {
+    TRACE_SCOPE("stl normals");
+    const size_t verts = positions.size() / 3;
+    const size_t tris  = indices.size() / 3;
+
+    auto P = [&](unsigned v) { return glm::vec3(positions[v*3], positions[v*3+1], positions[v*3+2]); };
+
+    vector<glm::vec3> faceN(tris);
+    parallelFor(tris, [&](size_t b, size_t e) {
+        for (size_t t = b; t < e; ++t) {
+            glm::vec3 a = P(indices[t*3]), c1 = P(indices[t*3+1]), c2 = P(indices[t*3+2]);
+            faceN[t] = glm::cross(c1 - a, c2 - a); // length = 2 * area
+        }
+    });
+
+    vector<uint32_t> start(verts + 1, 0);
+    for (unsigned v : indices) ++start[v + 1];
+    for (size_t v = 0; v < verts; ++v) start[v + 1] += start[v];
+    vector<uint32_t> fill(start.begin(), start.end() - 1);
+    vector<uint32_t> vertTris(indices.size());
+    for (size_t i = 0; i < indices.size(); ++i) vertTris[fill[indices[i]]++] = uint32_t(i / 3);
+
+    interleaved.resize(verts * 6);
+    parallelFor(verts, [&](size_t b, size_t e) {
+        for (size_t v = b; v < e; ++v) {
+            glm::vec3 n(0.0f);
+            for (uint32_t k = start[v]; k < start[v + 1]; ++k) n += faceN[vertTris[k]];
+            float len = glm::length(n);
+            n = len > 0.0f ? n / len : glm::vec3(0.0f, 0.0f, 1.0f);
+            float* o = &interleaved[v * 6];
+            o[0] = positions[v*3]; o[1] = positions[v*3+1]; o[2] = positions[v*3+2];
+            o[3] = n.x; o[4] = n.y; o[5] = n.z;
+        }
+    });
+}
@@ -0,0 +1,108 @@
+#include "traceRecorderClass.hpp"
+
+#include <GL/glew.h>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+using namespace std;
+
+traceRecorderClass& traceRecorderClass::global() {
+    static traceRecorderClass instance; // destroyed at exit, which writes the file
+    return instance;
+}
+
+void traceRecorderClass::start(const string& path) {
+    lock_guard<mutex> lock(mutex_);
+    path_  = path;
+    epoch_ = chrono::steady_clock::now();
+    events_.clear();
+    events_.reserve(1 << 16);
+    enabled_.store(true, memory_order_relaxed);
+}
+
+double traceRecorderClass::nowUs() const {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - epoch_).count();
+}
+
+// Samples both clocks back to back; the GL query is a sync point, so take the tighter of a few tries.
+void traceRecorderClass::calibrateGpuClock() {
+    if (!enabled()) return;
+    double best = 1e300;
+    for (int i = 0; i < 5; ++i) {
+        const double before = nowUs();
+        GLint64 gpuNs = 0;
+        glGetInteger64v(GL_TIMESTAMP, &gpuNs);
+        const double after = nowUs();
+        if (after - before < best) {
+            best = after - before;
+            gpuOffsetUs_ = 0.5 * (before + after) - double(gpuNs) * 1e-3;
+        }
+    }
+}
+
+int traceRecorderClass::threadIndex_() {
+    static atomic<int> next{0};
+    thread_local int index = next.fetch_add(1);
+    return index;
+}
+
+void traceRecorderClass::cpuEvent(const string& name, const char* cat, double startUs, double endUs) {
+    if (!enabled()) return;
+    const int tid = threadIndex_();
+    lock_guard<mutex> lock(mutex_);
+    events_.push_back({name, cat, 'X', startUs, endUs - startUs, tid});
+}
+
+void traceRecorderClass::gpuEvent(const string& name, uint64_t gpuStartNs, uint64_t gpuEndNs) {
+    if (!enabled()) return;
+    const double ts = double(gpuStartNs) * 1e-3 + gpuOffsetUs_;
+    lock_guard<mutex> lock(mutex_);
+    events_.push_back({name, "gpu", 'X', ts, double(gpuEndNs - gpuStartNs) * 1e-3, -1});
+}
+
+void traceRecorderClass::counter(const char* name, double value) {
+    if (!enabled()) return;
+    const double ts = nowUs();
+    lock_guard<mutex> lock(mutex_);
+    events_.push_back({name, "counter", 'C', ts, value, 0});
+}
+
+static void writeJsonString(ostream& os, const string& s) {
+    os << '"';
+    for (char c : s) {
+        if (c == '"' || c == '\\') os << '\\' << c;
+        else if (static_cast<unsigned char>(c) < 0x20) { char buf[8]; snprintf(buf, sizeof(buf), "\\u%04x", c); os << buf; }
+        else os << c;
+    }
+    os << '"';
+}
+
+void traceRecorderClass::stop() {
+    if (!enabled_.exchange(false)) return;
+    lock_guard<mutex> lock(mutex_);
+
+    ofstream f(path_, ios::trunc);
+    if (!f) { cerr << "[trace] cannot write " << path_ << "\n"; return; }
+    f.precision(3);
+    f << fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    // track names: pid 0 = CPU threads, pid 1 = GPU
+    f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":0,\"args\":{\"name\":\"CPU\"}},\n";
+    f << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}},\n";
+    f << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GL queue\"}}";
+
+    for (const Event& e : events_) {
+        f << ",\n{\"name\":";
+        writeJsonString(f, e.name);
+        if (e.ph == 'C') {
+            f << ",\"ph\":\"C\",\"pid\":0,\"ts\":" << e.ts << ",\"args\":{\"value\":" << e.dur << "}}";
+            continue;
+        }
+        f << ",\"cat\":\"" << e.cat << "\",\"ph\":\"X\",\"ts\":" << e.ts << ",\"dur\":" << e.dur;
+        if (e.tid < 0) f << ",\"pid\":1,\"tid\":0}";
+        else           f << ",\"pid\":0,\"tid\":" << e.tid << "}";
+    }
+    f << "\n]}\n";
+    cerr << "[trace] wrote " << events_.size() << " events to " << path_ << "\n";
+    events_.clear();
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+using namespace std;
+
+// Chrome trace-event / Perfetto JSON recorder (chrome://tracing, ui.perfetto.dev).
+// CPU scopes come from any thread via TRACE_SCOPE; GPU intervals arrive as GL timestamps
+// and are shifted onto the CPU clock with an offset measured by calibrateGpuClock().
+// Recording is off until start(); a disabled TRACE_SCOPE costs one relaxed atomic load.
+class traceRecorderClass {
+public:
+    static traceRecorderClass& global();
+
+    void start(const string& path);     // begin recording; written by stop() or at exit
+    void stop();                        // writes the file once
+    bool enabled() const { return enabled_.load(memory_order_relaxed); }
+
+    // needs a current GL context; call again after long runs if the clocks drift
+    void calibrateGpuClock();
+
+    // complete events, timestamps in the recorder's clock (µs since start())
+    double nowUs() const;
+    void   cpuEvent(const string& name, const char* cat, double startUs, double endUs);
+    void   gpuEvent(const string& name, uint64_t gpuStartNs, uint64_t gpuEndNs);
+    void   counter(const char* name, double value);
+
+    class Scope {
+    public:
+        Scope(const char* name, const char* cat = "cpu")
+            : name_(name), cat_(cat), active_(global().enabled()), t0_(active_ ? global().nowUs() : 0.0) {}
+        ~Scope() { if (active_) global().cpuEvent(name_, cat_, t0_, global().nowUs()); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    private:
+        const char* name_;
+        const char* cat_;
+        bool   active_;
+        double t0_;
+    };
+
+private:
+    traceRecorderClass() = default;
+    ~traceRecorderClass() { stop(); }
+
+    struct Event {
+        string      name;
+        const char* cat;
+        char        ph;        // 'X' complete, 'C' counter
+        double      ts, dur;   // µs
+        int         tid;       // -1 = GPU track
+    };
+    static int threadIndex_();
+
+    atomic<bool> enabled_{false};
+    mutex        mutex_;
+    vector<Event> events_;
+    string       path_;
+    chrono::steady_clock::time_point epoch_ = chrono::steady_clock::now();
+    double       gpuOffsetUs_ = 0.0;   // cpuUs = gpuNs / 1000 + gpuOffsetUs_
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b)  TRACE_CONCAT_(a, b)
+// times the rest of the enclosing block under `name` (a string literal)
+#define TRACE_SCOPE(name)   traceRecorderClass::Scope TRACE_CONCAT(traceScope_, __LINE__)(name)
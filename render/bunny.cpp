@@ -1,4 +1,5 @@
 #include "bunny.hpp"
+#include "meshOptimizerClass.hpp"
 using namespace std;
 
 render::render(){
@@ -92,6 +93,13 @@ void render::importer(string filename){// check includes needed // may only work
             indices.push_back(face.mIndices[j]);
     }
 
+    // built-in vertex cache, overdraw and vertex fetch order (see meshOptimizerClass)
+    const size_t vertexCount = vertices.size() / 6;
+    meshOptimizerClass::optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    meshOptimizerClass::optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, 6);
+    vertices.resize(meshOptimizerClass::optimizeVertexFetch(vertices.data(), vertexCount, 6,
+                                                            indices.data(), indices.size()) * 6);
+
     GLuint VBO, EBO;
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
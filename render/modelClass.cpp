@@ -1,4 +1,5 @@
 #include "modelClass.hpp"
+#include "meshOptimizerClass.hpp"
 using namespace std;
 
 /*---------------------------vectorClass--------------------------------- */
@@ -9,6 +10,8 @@ layout (location = 1) in vec3 aNormal;
 
 /* Per-instance transform (mat4 uses 4 locations) */
 layout (location = 2) in mat4 iModel;
+/* Per-instance normal matrix, precomputed on the CPU (mat3 uses 3 locations) */
+layout (location = 6) in mat3 iNormal;
 
 out vec3 vNormal;
 
@@ -17,8 +20,7 @@ uniform mat4 projection;
 
 void main()
 {
-    mat3 normalMat = mat3(transpose(inverse(iModel)));
-    vNormal = normalMat * aNormal;
+    vNormal = iNormal * aNormal;
     gl_Position = projection * view * iModel * vec4(aPos, 1.0);
 }
 )";
@@ -48,6 +50,13 @@ void vertexClass::importer(string filename){
             indices.push_back(face.mIndices[j]);
     }
 
+    // built-in vertex cache, overdraw and vertex fetch order (see meshOptimizerClass)
+    const size_t vertexCount = vertices.size() / 6;
+    meshOptimizerClass::optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+    meshOptimizerClass::optimizeOverdraw(indices.data(), indices.size(), vertices.data(), vertexCount, 6);
+    vertices.resize(meshOptimizerClass::optimizeVertexFetch(vertices.data(), vertexCount, 6,
+                                                            indices.data(), indices.size()) * 6);
+
     glGenVertexArrays(1, &VAO);
     glGenBuffers(1, &VBO);
     glGenBuffers(1, &EBO);
@@ -0,0 +1,76 @@
+#pragma once
+#include <glm/glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define NORMAL_MATRIX_SSE 1
+#endif
+using namespace std;
+
+// Normal matrix = inverse-transpose of the upper 3x3, i.e. its cofactor matrix / det.
+// Columns of the cofactor matrix are cross(c1,c2), cross(c2,c0), cross(c0,c1), so no
+// general inverse is needed. Stored as three vec4 columns (w = 0): the std430 mat3 /
+// vec4[3] layout, and a direct 16-byte store per column.
+struct NormalMatrix {
+    glm::vec4 c[3];
+};
+
+// true when the 3x3 part is a rotation times one scale factor: the normal matrix is then
+// mat3(m) up to a positive scale, which the shader removes by normalising anyway
+inline bool isUniformScale(const glm::mat4& m, float tol = 1e-4f) {
+    const glm::vec3 a(m[0]), b(m[1]), c(m[2]);
+    const float la = glm::dot(a, a), lb = glm::dot(b, b), lc = glm::dot(c, c);
+    const float eps = tol * max(la, max(lb, lc));
+    return fabs(la - lb) <= eps && fabs(la - lc) <= eps &&
+           fabs(glm::dot(a, b)) <= eps && fabs(glm::dot(b, c)) <= eps && fabs(glm::dot(c, a)) <= eps &&
+           glm::dot(glm::cross(a, b), c) > 0.0f; // mirrored instances need the real cofactor
+}
+
+inline bool allUniformScale(const glm::mat4* m, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        if (!isUniformScale(m[i])) return false;
+    }
+    return true;
+}
+
+// dst[i] = normal matrix of src[i] for i in [begin, end); run per chunk by the callers
+inline void computeNormalMatrices(const glm::mat4* src, NormalMatrix* dst, size_t begin, size_t end) {
+#ifdef NORMAL_MATRIX_SSE
+    // lanes x y z w; w of a cross product comes out 0
+    auto cross = [](__m128 a, __m128 b) {
+        const __m128 aYZX = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 bYZX = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+        const __m128 r = _mm_sub_ps(_mm_mul_ps(a, bYZX), _mm_mul_ps(aYZX, b)); // zxy order
+        return _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 0, 2, 1));
+    };
+    for (size_t i = begin; i < end; ++i) {
+        const float* m = reinterpret_cast<const float*>(&src[i]);
+        const __m128 c0 = _mm_loadu_ps(m), c1 = _mm_loadu_ps(m + 4), c2 = _mm_loadu_ps(m + 8);
+        const __m128 x0 = cross(c1, c2), x1 = cross(c2, c0), x2 = cross(c0, c1);
+
+        // det = dot(c0, cross(c1, c2)), horizontal sum of the 4 lanes (w is 0)
+        __m128 d = _mm_mul_ps(c0, x0);
+        d = _mm_add_ps(d, _mm_movehl_ps(d, d));
+        d = _mm_add_ss(d, _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 1, 1, 1)));
+        const float det = _mm_cvtss_f32(d);
+        const __m128 inv = _mm_set1_ps(det != 0.0f ? 1.0f / det : 0.0f);
+
+        float* o = reinterpret_cast<float*>(dst[i].c);
+        _mm_storeu_ps(o,     _mm_mul_ps(x0, inv));
+        _mm_storeu_ps(o + 4, _mm_mul_ps(x1, inv));
+        _mm_storeu_ps(o + 8, _mm_mul_ps(x2, inv));
+    }
+#else
+    for (size_t i = begin; i < end; ++i) {
+        const glm::vec3 c0(src[i][0]), c1(src[i][1]), c2(src[i][2]);
+        const glm::vec3 x0 = glm::cross(c1, c2), x1 = glm::cross(c2, c0), x2 = glm::cross(c0, c1);
+        const float det = glm::dot(c0, x0);
+        const float inv = det != 0.0f ? 1.0f / det : 0.0f;
+        dst[i].c[0] = glm::vec4(x0 * inv, 0.0f);
+        dst[i].c[1] = glm::vec4(x1 * inv, 0.0f);
+        dst[i].c[2] = glm::vec4(x2 * inv, 0.0f);
+    }
+#endif
+}
@@ -73,6 +73,18 @@ void sceneBuilderClass::setupInstanceBuffer() {
         glVertexAttribDivisor(2 + i, 1);
     }
 
+    // normal matrices once per upload instead of inverse() in every vertex
+    std::vector<NormalMatrix> normals(instanceMatrices.size());
+    computeNormalMatrices(instanceMatrices.data(), normals.data(), 0, normals.size());
+    if (!normalVBO) glGenBuffers(1, &normalVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, normalVBO);
+    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(NormalMatrix), normals.data(), GL_STATIC_DRAW);
+    for (int i = 0; i < 3; ++i) {
+        glEnableVertexAttribArray(6 + i);
+        glVertexAttribPointer(6 + i, 3, GL_FLOAT, GL_FALSE, sizeof(NormalMatrix), (void*)(sizeof(glm::vec4) * i));
+        glVertexAttribDivisor(6 + i, 1);
+    }
+
     glBindVertexArray(0);
 }
 
@@ -1,4 +1,5 @@
 #include "modelClass.hpp"
+#include "normalMatrixUtil.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <vector>
@@ -24,6 +25,7 @@ private:
     glm::mat4 view{1.0f}, projection{1.0f};
     vector<glm::mat4> instanceMatrices;
     GLuint instanceVBO = 0;//check this
+    GLuint normalVBO = 0;   // per-instance normal matrices (locations 6..8)
     vertexClass v;
     fragmentClass f;
     GLuint program = 0;